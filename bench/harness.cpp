@@ -5,10 +5,15 @@
 //-----------------------------------------------------------------------------
 #include <chrono>
 #include <functional>
+#include <memory>
+#include <random>
 #include <string>
 #include <vector>
 
 #include "solvespace.h"
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
 
 using namespace SolveSpace;
 
@@ -47,6 +52,139 @@ static bool RunBenchmark(std::function<void()> setupFn,
     return true;
 }
 
+// A chain of points, each a unit distance from the next and a fixed distance
+// to its right; that gives a single cluster of 2*(points-1) equations, all of
+// them coupled, in 2*points unknowns.
+static void WriteChainSystem(System *sys, int points) {
+    for(int i = 0; i < points; i++) {
+        Param px = {}, py = {};
+        px.h.v  = 2 * i + 1;
+        px.val  = 0.55 * i;
+        py.h.v  = 2 * i + 2;
+        py.val  = 0.85 * i;
+        sys->param.Add(&px);
+        sys->param.Add(&py);
+    }
+    for(int i = 0; i + 1 < points; i++) {
+        Expr *dx = Expr::From(hParam { (uint32_t)(2 * i + 3) })
+                       ->Minus(Expr::From(hParam { (uint32_t)(2 * i + 1) }));
+        Expr *dy = Expr::From(hParam { (uint32_t)(2 * i + 4) })
+                       ->Minus(Expr::From(hParam { (uint32_t)(2 * i + 2) }));
+        Equation e = {};
+        e.h.v = 2 * i + 1;
+        e.e   = dx->Square()->Plus(dy->Square())->Minus(Expr::From(1.0));
+        sys->eq.Add(&e);
+        e.h.v = 2 * i + 2;
+        e.e   = dx->Minus(Expr::From(0.6));
+        sys->eq.Add(&e);
+    }
+}
+
+// Adds params with the given handles to a list, in that order, and then looks
+// each of them up again.
+template<IdIndex Index>
+static bool RunIdListBenchmark(const std::vector<uint32_t> &handles) {
+    IdList<Param, hParam, Index> list;
+    return RunBenchmark(
+        [] {},
+        [&] {
+            for(uint32_t h : handles) {
+                Param p = {};
+                p.h.v = h;
+                list.Add(&p);
+            }
+            for(uint32_t h : handles) {
+                if(list.FindById(hParam { h })->h.v != h)
+                    return false;
+            }
+            return true;
+        },
+        [&] {
+            list.Clear();
+        }, /*minIter=*/3, /*minTime=*/1.0);
+}
+
+static bool RunLoadBenchmark(const Platform::Path &filename, bool afterNewFile) {
+    return RunBenchmark(
+        [] {
+            SS.Init();
+        },
+        [&] {
+            if(!SS.LoadFromFile(filename))
+                return false;
+            if(afterNewFile) SS.AfterNewFile();
+            return true;
+        },
+        [] {
+            SK.Clear();
+            SS.Clear();
+        });
+}
+
+// A grid of line segments in the default workplane, each with a length
+// dimension; saved, that makes a file with about ten records per segment.
+static void GenerateLoadCorpus(int segments) {
+    int columns = (int)ceil(sqrt((double)segments));
+    for(int i = 0; i < segments; i++) {
+        hRequest hr = SS.GW.AddRequest(Request::Type::LINE_SEGMENT, /*rememberForUndo=*/false);
+        Vector a = Vector::From(10.0 * (i % columns), 10.0 * (i / columns), 0.0),
+               b = a.Plus(Vector::From(3.0 + 0.001 * i, 4.0, 0.0));
+        SK.GetEntity(hr.entity(1))->PointForceTo(a);
+        SK.GetEntity(hr.entity(2))->PointForceTo(b);
+
+        Constraint c = {};
+        c.type      = Constraint::Type::PT_PT_DISTANCE;
+        c.group     = SS.GW.activeGroup;
+        c.workplane = SS.GW.ActiveWorkplane();
+        c.ptA       = hr.entity(1);
+        c.ptB       = hr.entity(2);
+        c.valA      = a.Minus(b).Magnitude();
+        Constraint::AddConstraint(&c, /*rememberForUndo=*/false);
+    }
+}
+
+// Adds a circle of the given radius in the xy plane, as four rational arcs.
+static void AddCircle(SBezierList *sbl, Vector center, double r) {
+    Vector p[4] = {
+        center.Plus(Vector::From( r,  0, 0)), center.Plus(Vector::From( 0,  r, 0)),
+        center.Plus(Vector::From(-r,  0, 0)), center.Plus(Vector::From( 0, -r, 0)),
+    };
+    for(int i = 0; i < 4; i++) {
+        Vector a = p[i], b = p[(i + 1) % 4],
+               c = a.Plus(b).Minus(center);
+        SBezier sb = SBezier::From(a, c, b);
+        sb.weight[1] = sqrt(2) / 2;
+        sbl->l.Add(&sb);
+    }
+}
+
+// Adds a closed polygon through the given points, in order.
+static void AddPolygon(SBezierList *sbl, const std::vector<Vector> &pts) {
+    for(size_t i = 0; i < pts.size(); i++) {
+        SBezier sb = SBezier::From(pts[i], pts[(i + 1) % pts.size()]);
+        sbl->l.Add(&sb);
+    }
+}
+
+// Extrudes the closed curves in the xy plane into a shell, the same way as
+// an extrude group would.
+static void ExtrudeInto(SShell *sh, SBezierList *sbl, double zmin, double zmax) {
+    SBezierLoopSetSet sblss = {};
+    SPolygon poly = {};
+    SEdge errorAt = {};
+    Vector errorPointAt = {};
+    bool allClosed, allCoplanar;
+    sblss.FindOuterFacesFrom(sbl, &poly, NULL, SS.ChordTolMm(),
+                             &allClosed, &errorAt, &allCoplanar, &errorPointAt, NULL);
+    for(SBezierLoopSet &sbls : sblss.l) {
+        sh->MakeFromExtrusionOf(&sbls, Vector::From(0, 0, zmin), Vector::From(0, 0, zmax),
+                                RGBi(255, 255, 255));
+    }
+    sblss.Clear();
+    poly.Clear();
+    sbl->Clear();
+}
+
 int main(int argc, char **argv) {
     std::vector<std::string> args = Platform::InitCli(argc, argv);
 
@@ -57,26 +195,305 @@ int main(int argc, char **argv) {
         filename = Platform::Path::From(args[2]);
     } else {
         fprintf(stderr, "Usage: %s [mode] [filename]\n", args[0].c_str());
-        fprintf(stderr, "Mode can be one of: load.\n");
+        fprintf(stderr, "Mode can be one of: load, loadgen, solve, idlist, boolean, "
+                        "evaluate, hiddenline.\n");
+        fprintf(stderr, "For loadgen, pass the number of line segments to generate "
+                        "instead of a filename.\n");
+        fprintf(stderr, "For solve, pass the largest number of unknowns instead of a filename.\n");
+        fprintf(stderr, "For idlist, pass the number of elements instead of a filename.\n");
+        fprintf(stderr, "For boolean, pass the number of holes along each side of a plate "
+                        "instead of a filename.\n");
+        fprintf(stderr, "For evaluate, pass the number of points on a surface "
+                        "instead of a filename.\n");
+        fprintf(stderr, "For hiddenline, pass the number of holes along each side of a plate "
+                        "instead of a filename.\n");
         return 1;
     }
 
     bool result = false;
     if(mode == "load") {
+        result = RunLoadBenchmark(filename, /*afterNewFile=*/true);
+    } else if(mode == "loadgen") {
+        // Generate a large sketch, save it in both the text and the binary
+        // format, and report how long each takes to read back.
+        int segments = atoi(args[2].c_str());
+        Platform::Path textFile   = Platform::Path::CurrentDirectory().Join("load-corpus.slvs"),
+                       binaryFile = Platform::Path::CurrentDirectory().Join("load-corpus-bin.slvs");
+        SS.Init();
+        GenerateLoadCorpus(segments);
+        SS.saveBinaryFiles = false;
+        result = SS.SaveToFile(textFile);
+        SS.saveBinaryFiles = true;
+        result = result && SS.SaveToFile(binaryFile);
+        SS.saveBinaryFiles = false;
+        SK.Clear();
+        SS.Clear();
+
+        if(result) {
+            fprintf(stdout, "Segments:   %d\n", segments);
+            fprintf(stdout, "Text:\n");
+            result = RunLoadBenchmark(textFile, /*afterNewFile=*/false);
+            fprintf(stdout, "Binary:\n");
+            result = result && RunLoadBenchmark(binaryFile, /*afterNewFile=*/false);
+        }
+        Platform::RemoveFile(textFile);
+        Platform::RemoveFile(binaryFile);
+    } else if(mode == "solve") {
+        // Report how the solve time grows with the size of the system; cold,
+        // with a new system that compiles its Jacobian each time, and warm,
+        // with one that finds it compiled already, as when dragging.
+        int maxUnknowns = atoi(args[2].c_str());
+        result = true;
+        for(int unknowns = 1000; result && unknowns <= maxUnknowns; unknowns *= 2) {
+            std::unique_ptr<System> sys;
+            auto solve = [&] {
+                int dof;
+                sys->WriteJacobian(0, /*useCache=*/true);
+                if(!sys->NewtonSolve())
+                    return false;
+                return sys->TestRank(&dof);
+            };
+            fprintf(stdout, "Unknowns:   %d\n", unknowns);
+            fprintf(stdout, "Cold:\n");
+            result = RunBenchmark(
+                [&] {
+                    sys.reset(new System);
+                    WriteChainSystem(sys.get(), unknowns / 2);
+                },
+                solve,
+                [&] {
+                    sys->Clear();
+                    sys.reset();
+                    Platform::FreeAllTemporary();
+                }, /*minIter=*/3, /*minTime=*/1.0);
+
+            fprintf(stdout, "Warm:\n");
+            sys.reset(new System);
+            result = result && RunBenchmark(
+                [&] {
+                    WriteChainSystem(sys.get(), unknowns / 2);
+                },
+                solve,
+                [&] {
+                    sys->Clear();
+                    Platform::FreeAllTemporary();
+                }, /*minIter=*/3, /*minTime=*/1.0);
+            sys.reset();
+        }
+    } else if(mode == "idlist") {
+        // Compare the sorted and hashed indexes of IdList, with the handles
+        // added in order (as when loading a file) and shuffled.
+        int count = atoi(args[2].c_str());
+        std::vector<uint32_t> inOrder, shuffled;
+        for(int i = 0; i < count; i++) {
+            inOrder.push_back(i + 1);
+        }
+        shuffled = inOrder;
+        std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(0));
+
+        result = true;
+        for(const std::vector<uint32_t> *handles : { &inOrder, &shuffled }) {
+            const char *order = (handles == &inOrder) ? "in order" : "shuffled";
+            fprintf(stdout, "Sorted, %s:\n", order);
+            result = result && RunIdListBenchmark<IdIndex::SORTED>(*handles);
+            fprintf(stdout, "Hashed, %s:\n", order);
+            result = result && RunIdListBenchmark<IdIndex::HASHED>(*handles);
+        }
+    } else if(mode == "boolean") {
+        // Drill a square grid of holes through a plate, and then a second
+        // grid between those; so that both shells in the second Boolean have
+        // a surface or so for each hole, as with a pattern of repeated holes.
+        int holes = max(atoi(args[2].c_str()), 2);
+        SS.Init();
+
+        SShell plate = {}, drill = {}, drilled = {}, drill2 = {}, drilled2 = {};
+        SBezierList sbl = {};
+        double side = 10.0 * holes;
+        AddPolygon(&sbl, { Vector::From(0, 0, 0), Vector::From(side, 0, 0),
+                           Vector::From(side, side, 0), Vector::From(0, side, 0) });
+        ExtrudeInto(&plate, &sbl, 0, 2);
+        for(int i = 0; i < holes * holes; i++) {
+            AddCircle(&sbl, Vector::From(5.0 + 10.0 * (i % holes),
+                                         5.0 + 10.0 * (i / holes), 0), 3.0);
+        }
+        ExtrudeInto(&drill, &sbl, -1, 3);
+        for(int i = 0; i < (holes - 1) * (holes - 1); i++) {
+            AddCircle(&sbl, Vector::From(10.0 + 10.0 * (i % (holes - 1)),
+                                         10.0 + 10.0 * (i / (holes - 1)), 0), 2.0);
+        }
+        ExtrudeInto(&drill2, &sbl, -1, 3);
+        drilled.MakeFromDifferenceOf(&plate, &drill);
+
+        fprintf(stdout, "Surfaces:   %d and %d\n", drilled.surface.n, drill2.surface.n);
+        result = !drilled.booleanFailed && RunBenchmark(
+            [] {},
+            [&] {
+                drilled2.MakeFromDifferenceOf(&drilled, &drill2);
+                return !drilled2.booleanFailed;
+            },
+            [&] {
+                drilled2.Clear();
+            }, /*minIter=*/3, /*minTime=*/1.0);
+        plate.Clear();
+        drill.Clear();
+        drilled.Clear();
+        drill2.Clear();
+    } else if(mode == "evaluate") {
+        // Evaluate points and normals on a patch of a torus, one at a time
+        // and then in batches; and project points back onto it, from scratch,
+        // from a sample grid, and along a curve.
+        int count = atoi(args[2].c_str());
+        SBezier arc = SBezier::From(Vector::From(25, 0, 0), Vector::From(25, 5, 0),
+                                    Vector::From(20, 5, 0));
+        arc.weight[1] = sqrt(2) / 2;
+        SSurface srf = SSurface::FromRevolutionOf(&arc, Vector::From(0, 0, 0),
+                                                  Vector::From(0, 1, 0), 0, PI / 2, 0, 0);
+        std::vector<Point2d> puv;
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<double> param(0.0, 1.0);
+        for(int i = 0; i < count; i++) {
+            puv.push_back(Point2d::From(param(rng), param(rng)));
+        }
+        std::vector<Vector> pt(count), nv(count);
+
+        fprintf(stdout, "Points:     %d\n", count);
+        fprintf(stdout, "One at a time:\n");
         result = RunBenchmark(
-            [] {
-                SS.Init();
+            [] {},
+            [&] {
+                for(int i = 0; i < count; i++) {
+                    pt[i] = srf.PointAt(puv[i]);
+                    nv[i] = srf.NormalAt(puv[i]);
+                }
+                return true;
             },
+            [] {}, /*minIter=*/3, /*minTime=*/1.0);
+        fprintf(stdout, "Batched:\n");
+        result = result && RunBenchmark(
+            [] {},
             [&] {
-                if(!SS.LoadFromFile(filename))
-                    return false;
-                SS.AfterNewFile();
+                srf.PointsAt(puv.data(), pt.data(), count);
+                srf.NormalsAt(puv.data(), nv.data(), count);
                 return true;
             },
-            [] {
-                SK.Clear();
-                SS.Clear();
-            });
+            [] {}, /*minIter=*/3, /*minTime=*/1.0);
+        fprintf(stdout, "Projected:\n");
+        result = result && RunBenchmark(
+            [] {},
+            [&] {
+                for(int i = 0; i < count; i++) {
+                    Point2d p;
+                    srf.ClosestPointTo(pt[i], &p);
+                    if(!srf.PointAt(p).Equals(pt[i])) return false;
+                }
+                return true;
+            },
+            [] {}, /*minIter=*/3, /*minTime=*/1.0);
+        srf.MakeSampleGrid();
+        fprintf(stdout, "Projected from the sample grid:\n");
+        result = result && RunBenchmark(
+            [] {},
+            [&] {
+                for(int i = 0; i < count; i++) {
+                    Point2d p;
+                    srf.ClosestPointTo(pt[i], &p);
+                    if(!srf.PointAt(p).Equals(pt[i])) return false;
+                }
+                return true;
+            },
+            [] {}, /*minIter=*/3, /*minTime=*/1.0);
+        // Successive points along a curve, the way that the Boolean projects
+        // the pwl trim curves, starting each from where the last one landed.
+        for(int i = 0; i < count; i++) {
+            double t = (i + 0.5) / count;
+            pt[i] = srf.PointAt(t, 0.3 + 0.4 * t);
+        }
+        fprintf(stdout, "Projected along a curve:\n");
+        result = result && RunBenchmark(
+            [] {},
+            [&] {
+                SProjectionGuess guess = {};
+                for(int i = 0; i < count; i++) {
+                    Point2d p;
+                    srf.ClosestPointTo(pt[i], &p, /*mustConverge=*/true, &guess);
+                    if(!srf.PointAt(p).Equals(pt[i])) return false;
+                }
+                return true;
+            },
+            [] {}, /*minIter=*/3, /*minTime=*/1.0);
+    } else if(mode == "hiddenline") {
+        // Remove the hidden lines from an oblique view of a drilled plate, the
+        // way that exporting a view does.
+        int holes = max(atoi(args[2].c_str()), 2);
+        SS.Init();
+
+        SShell plate = {}, drill = {}, drilled = {};
+        SBezierList sbl = {};
+        double side = 10.0 * holes;
+        AddPolygon(&sbl, { Vector::From(0, 0, 0), Vector::From(side, 0, 0),
+                           Vector::From(side, side, 0), Vector::From(0, side, 0) });
+        ExtrudeInto(&plate, &sbl, 0, 2);
+        for(int i = 0; i < holes * holes; i++) {
+            AddCircle(&sbl, Vector::From(5.0 + 10.0 * (i % holes),
+                                         5.0 + 10.0 * (i / holes), 0), 3.0);
+        }
+        ExtrudeInto(&drill, &sbl, -1, 3);
+        drilled.MakeFromDifferenceOf(&plate, &drill);
+
+        SMesh mesh = {};
+        SEdgeList edges = {};
+        drilled.TriangulateInto(&mesh);
+        drilled.MakeEdgesInto(&edges);
+        Quaternion view = Quaternion::From(Vector::From(1, 0.3, 0), 0.9);
+        for(STriangle &tr : mesh.l) {
+            tr.a = view.Rotate(tr.a);
+            tr.b = view.Rotate(tr.b);
+            tr.c = view.Rotate(tr.c);
+        }
+        for(SEdge &se : edges.l) {
+            se.a = view.Rotate(se.a);
+            se.b = view.Rotate(se.b);
+        }
+
+        fprintf(stdout, "Triangles:  %d\n", mesh.l.n);
+        fprintf(stdout, "Edges:      %d\n", edges.l.n);
+        std::vector<SEdgeList> split;
+        auto runHiddenLine = [&] {
+            return RunBenchmark(
+                [] {},
+                [&] {
+                    SKdNode *root = SKdNode::From(&mesh);
+                    root->OcclusionTestLines(&edges, &split);
+                    return true;
+                },
+                [&] {
+                    for(SEdgeList &sel : split) {
+                        sel.Clear();
+                    }
+                    Platform::FreeAllTemporary();
+                }, /*minIter=*/3, /*minTime=*/1.0);
+        };
+        result = !drilled.booleanFailed;
+#if defined(_OPENMP)
+        // The edges are tested on all threads; so report how that scales.
+        int maxThreads = omp_get_max_threads();
+        for(int threads = 1; result; threads = min(threads * 2, maxThreads)) {
+            omp_set_num_threads(threads);
+            fprintf(stdout, "Threads:    %d\n", threads);
+            result = runHiddenLine();
+            if(threads == maxThreads) break;
+        }
+        omp_set_num_threads(maxThreads);
+#else
+        fprintf(stdout, "Threads:    1 (built without OpenMP)\n");
+        result = result && runHiddenLine();
+#endif
+        mesh.Clear();
+        edges.Clear();
+        sbl.Clear();
+        plate.Clear();
+        drill.Clear();
+        drilled.Clear();
     } else {
         fprintf(stderr, "Unknown mode \"%s\"\n", mode.c_str());
     }
@@ -56,6 +56,40 @@ void ExampleStateful()
     printf("p2y:%.3f\n", p2y);
 }
 
+/*-----------------------------------------------------------------------------
+ * The same sketch as above, but built in two independent solver contexts.
+ * Each context has its own parameters, entities and constraints, so the two
+ * could just as well be built and solved on two different threads.
+ *---------------------------------------------------------------------------*/
+void ExampleContexts()
+{
+    Slvs_Context *ctx[2];
+    int i;
+    for(i = 0; i < 2; i++) {
+        ctx[i] = Slvs_CreateContext();
+
+        Slvs_hGroup g = 1;
+        Slvs_Entity wp = Slvs_CtxAddBase2D(ctx[i], g);
+        Slvs_Entity p1 = Slvs_CtxAddPoint2D(ctx[i], g, 0.0, 10.0, wp);
+        Slvs_Entity p2 = Slvs_CtxAddPoint2D(ctx[i], g, 5.0 * (i + 1), 20.0, wp);
+        Slvs_CtxAddLine2D(ctx[i], g, p1, p2, wp);
+        if(i == 0) {
+            Slvs_CtxVertical(ctx[i], g, p1, wp, p2);
+        } else {
+            Slvs_CtxHorizontal(ctx[i], g, p1, wp, p2);
+        }
+
+        Slvs_SolveResult res = Slvs_CtxSolveSketch(ctx[i], g, NULL);
+        printf("context %d: res %i, dof %i, p2 at (%.3f %.3f)\n", i,
+               res.result, res.dof,
+               Slvs_CtxGetParamValue(ctx[i], p2.param[0]),
+               Slvs_CtxGetParamValue(ctx[i], p2.param[1]));
+    }
+    for(i = 0; i < 2; i++) {
+        Slvs_DestroyContext(ctx[i]);
+    }
+}
+
 /*-----------------------------------------------------------------------------
  * An example of a constraint in 3d. We create a single group, with some
  * entities and constraints.
@@ -281,6 +315,7 @@ void Example2d()
 int main()
 {
     ExampleStateful();
+    ExampleContexts();
 
     sys.param      = CheckMalloc(50*sizeof(sys.param[0]));
     sys.entity     = CheckMalloc(50*sizeof(sys.entity[0]));
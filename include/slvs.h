@@ -195,7 +195,9 @@ typedef struct {
     /* The solver indicates the number of unconstrained degrees of freedom. */
     int                 dof;
 
-    /* The solver indicates whether the solution succeeded. */
+    /* The solver indicates whether the solution succeeded. There is no
+     * longer a limit on the number of unknowns, so TOO_MANY_UNKNOWNS is never
+     * returned; it is kept so that existing callers still compile. */
 #define SLVS_RESULT_OKAY                0
 #define SLVS_RESULT_INCONSISTENT        1
 #define SLVS_RESULT_DIDNT_CONVERGE      2
@@ -509,6 +511,92 @@ DLL void Slvs_MarkDragged(Slvs_Entity ptA);
 DLL Slvs_SolveResult Slvs_SolveSketch(uint32_t hg, Slvs_hConstraint **bad);
 DLL void Slvs_ClearSketch();
 
+/*-------------------------------------
+ * Solver contexts. The functions above all operate on a single sketch that
+ * is shared by the whole process, so they must not be called from more than
+ * one thread at a time. A context holds a complete, independent sketch
+ * (parameters, entities, constraints and the dragged set); each function
+ * below is the same as its counterpart without the `Ctx`, but operates on
+ * the given context instead of the shared sketch.
+ *
+ * Different contexts may be used concurrently from different threads, but
+ * a single context must not be used from more than one thread at a time.
+ * Handles are assigned per context, so an entity or parameter handle is
+ * only meaningful in the context that created it. */
+typedef struct Slvs_Context Slvs_Context;
+
+DLL Slvs_Context *Slvs_CreateContext(void);
+DLL void Slvs_DestroyContext(Slvs_Context *ctx);
+
+DLL Slvs_Entity Slvs_CtxAddPoint2D(Slvs_Context *ctx, uint32_t grouph, double u, double v, Slvs_Entity workplane);
+DLL Slvs_Entity Slvs_CtxAddPoint3D(Slvs_Context *ctx, uint32_t grouph, double x, double y, double z);
+DLL Slvs_Entity Slvs_CtxAddNormal2D(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity workplane);
+DLL Slvs_Entity Slvs_CtxAddNormal3D(Slvs_Context *ctx, uint32_t grouph, double qw, double qx, double qy, double qz);
+DLL Slvs_Entity Slvs_CtxAddDistance(Slvs_Context *ctx, uint32_t grouph, double value, Slvs_Entity workplane);
+DLL Slvs_Entity Slvs_CtxAddLine2D(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity workplane);
+DLL Slvs_Entity Slvs_CtxAddLine3D(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity ptA, Slvs_Entity ptB);
+DLL Slvs_Entity Slvs_CtxAddCubic(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity ptC, Slvs_Entity ptD, Slvs_Entity workplane);
+DLL Slvs_Entity Slvs_CtxAddArc(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity normal, Slvs_Entity center, Slvs_Entity start, Slvs_Entity end, Slvs_Entity workplane);
+DLL Slvs_Entity Slvs_CtxAddCircle(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity normal, Slvs_Entity center, Slvs_Entity radius, Slvs_Entity workplane);
+DLL Slvs_Entity Slvs_CtxAddWorkplane(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity origin, Slvs_Entity nm);
+DLL Slvs_Entity Slvs_CtxAddBase2D(Slvs_Context *ctx, uint32_t grouph);
+
+DLL Slvs_Constraint Slvs_CtxAddConstraint(Slvs_Context *ctx, uint32_t grouph, int type, Slvs_Entity workplane, double val, Slvs_Entity ptA,
+    Slvs_Entity ptB, Slvs_Entity entityA,
+    Slvs_Entity entityB, Slvs_Entity entityC,
+    Slvs_Entity entityD, int other, int other2);
+DLL Slvs_Constraint Slvs_CtxCoincident(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity entityB,
+                                    Slvs_Entity workplane);
+DLL Slvs_Constraint Slvs_CtxDistance(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity entityB, double value,
+                                    Slvs_Entity workplane);
+DLL Slvs_Constraint Slvs_CtxEqual(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity entityB,
+                                    Slvs_Entity workplane);
+DLL Slvs_Constraint Slvs_CtxEqualAngle(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity entityC,
+                                    Slvs_Entity entityD,
+                                    Slvs_Entity workplane);
+DLL Slvs_Constraint Slvs_CtxEqualPointToLine(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity entityB,
+                                    Slvs_Entity entityC, Slvs_Entity entityD,
+                                    Slvs_Entity workplane);
+DLL Slvs_Constraint Slvs_CtxRatio(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity entityB, double value,
+                                    Slvs_Entity workplane);
+DLL Slvs_Constraint Slvs_CtxSymmetric(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity entityB,
+                                    Slvs_Entity entityC,
+                                    Slvs_Entity workplane);
+DLL Slvs_Constraint Slvs_CtxSymmetricH(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity ptA, Slvs_Entity ptB,
+                                    Slvs_Entity workplane);
+DLL Slvs_Constraint Slvs_CtxSymmetricV(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity ptA, Slvs_Entity ptB,
+                                    Slvs_Entity workplane);
+DLL Slvs_Constraint Slvs_CtxMidpoint(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity ptA, Slvs_Entity ptB,
+                                    Slvs_Entity workplane);
+DLL Slvs_Constraint Slvs_CtxHorizontal(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity workplane,
+                                    Slvs_Entity entityB);
+DLL Slvs_Constraint Slvs_CtxVertical(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity workplane,
+                                    Slvs_Entity entityB);
+DLL Slvs_Constraint Slvs_CtxDiameter(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, double value);
+DLL Slvs_Constraint Slvs_CtxSameOrientation(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity entityB);
+DLL Slvs_Constraint Slvs_CtxAngle(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity entityB, double value,
+                                    Slvs_Entity workplane,
+                                    int inverse);
+DLL Slvs_Constraint Slvs_CtxPerpendicular(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity entityB,
+                                    Slvs_Entity workplane,
+                                    int inverse);
+DLL Slvs_Constraint Slvs_CtxParallel(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity entityB,
+                                    Slvs_Entity workplane);
+DLL Slvs_Constraint Slvs_CtxTangent(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity entityB,
+                                    Slvs_Entity workplane);
+DLL Slvs_Constraint Slvs_CtxDistanceProj(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity ptA, Slvs_Entity ptB, double value);
+DLL Slvs_Constraint Slvs_CtxLengthDiff(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity entityA, Slvs_Entity entityB, double value,
+                                    Slvs_Entity workplane);
+DLL Slvs_Constraint Slvs_CtxDragged(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity ptA, Slvs_Entity workplane);
+
+DLL double Slvs_CtxGetParamValue(Slvs_Context *ctx, uint32_t ph);
+DLL void Slvs_CtxSetParamValue(Slvs_Context *ctx, uint32_t ph, double value);
+
+DLL void Slvs_CtxSolve(Slvs_Context *ctx, Slvs_System *sys, uint32_t hg);
+DLL void Slvs_CtxMarkDragged(Slvs_Context *ctx, Slvs_Entity ptA);
+DLL Slvs_SolveResult Slvs_CtxSolveSketch(Slvs_Context *ctx, uint32_t hg, Slvs_hConstraint **bad);
+DLL void Slvs_CtxClearSketch(Slvs_Context *ctx);
+
 #ifdef __cplusplus
 }
 #endif
@@ -63,7 +63,76 @@ export interface QuaternionConstructor {
   from(w: number, vx: number, vy: number, vz: number): Quaternion;
 }
 
-export interface SlvsModule {
+export interface Sketch {
+  addPoint2D(grouph: number, u: number, v: number, workplane: Entity): Entity;
+  addPoint3D(grouph: number, x: number, y: number, z: number): Entity;
+  addNormal2D(grouph: number, workplane: Entity): Entity;
+  addNormal3D(grouph: number, qw: number, qx: number, qy: number, qz: number): Entity;
+  addDistance(grouph: number, value: number, workplane: Entity): Entity;
+  addLine2D(grouph: number, ptA: Entity, ptB: Entity, workplane: Entity): Entity;
+  addLine3D(grouph: number, ptA: Entity, ptB: Entity): Entity;
+  addCubic(grouph: number, ptA: Entity, ptB: Entity, ptC: Entity, ptD: Entity, workplane: Entity): Entity;
+  addArc(grouph: number, normal: Entity, center: Entity, start: Entity, end: Entity, workplane: Entity): Entity;
+  addCircle(grouph: number, normal: Entity, center: Entity, radius: Entity, workplane: Entity): Entity;
+  addWorkplane(grouph: number, origin: Entity, nm: Entity): Entity;
+  addBase2D(grouph: number): Entity;
+
+  addConstraint(
+    grouph: number,
+    type: number,
+    workplane: Entity,
+    val: number,
+    ptA: Entity,
+    ptB: Entity,
+    entityA: Entity,
+    entityB: Entity,
+    entityC: Entity,
+    entityD: Entity,
+    other: boolean,
+    other2: boolean,
+  ): Constraint;
+
+  coincident(grouph: number, entityA: Entity, entityB: Entity, workplane: Entity): Constraint;
+  distance(grouph: number, entityA: Entity, entityB: Entity, value: number, workplane: Entity): Constraint;
+  equal(grouph: number, entityA: Entity, entityB: Entity, workplane: Entity): Constraint;
+  equalAngle(grouph: number, entityA: Entity, entityB: Entity, entityC: Entity, entityD: Entity, workplane: Entity): Constraint;
+  equalPointToLine(grouph: number, entityA: Entity, entityB: Entity, entityC: Entity, entityD: Entity, workplane: Entity): Constraint;
+  ratio(grouph: number, entityA: Entity, entityB: Entity, value: number, workplane: Entity): Constraint;
+  symmetric(grouph: number, entityA: Entity, entityB: Entity, entityC: Entity): Constraint;
+  symmetricH(grouph: number, ptA: Entity, ptB: Entity, workplane: Entity): Constraint;
+  symmetricV(grouph: number, ptA: Entity, ptB: Entity, workplane: Entity): Constraint;
+  midpoint(grouph: number, ptA: Entity, ptB: Entity, workplane: Entity): Constraint;
+  horizontal(grouph: number, entityA: Entity, workplane: Entity, entityB: Entity): Constraint;
+  vertical(grouph: number, entityA: Entity, workplane: Entity, entityB: Entity): Constraint;
+  diameter(grouph: number, entityA: Entity, value: number): Constraint;
+  sameOrientation(grouph: number, entityA: Entity, entityB: Entity): Constraint;
+  angle(grouph: number, entityA: Entity, entityB: Entity, value: number, workplane: Entity, inverse: boolean): Constraint;
+  perpendicular(grouph: number, entityA: Entity, entityB: Entity, workplane: Entity, inverse: boolean): Constraint;
+  parallel(grouph: number, entityA: Entity, entityB: Entity, workplane: Entity): Constraint;
+  tangent(grouph: number, entityA: Entity, entityB: Entity, workplane: Entity): Constraint;
+  distanceProj(grouph: number, ptA: Entity, ptB: Entity, value: number): Constraint;
+  lengthDiff(grouph: number, entityA: Entity, entityB: Entity, value: number, workplane: Entity): Constraint;
+  dragged(grouph: number, ptA: Entity, workplane: Entity): Constraint;
+
+  getParamValue(ph: number): number;
+  setParamValue(ph: number, value: number): number;
+  markDragged(ptA: Entity): void;
+  solveSketch(hgroup: number, calculateFaileds: boolean): SolveResult;
+  clearSketch(): void;
+}
+
+// An independent sketch that can be solved concurrently with others.
+// Must be released with delete() once no longer needed.
+export interface Context extends Sketch {
+  delete(): void;
+}
+
+export interface ContextConstructor {
+  new(): Context;
+  prototype: Context;
+}
+
+export interface SlvsModule extends Sketch {
   C_POINTS_COINCIDENT: 100000;
   C_PT_PT_DISTANCE: 100001;
   C_PT_PLANE_DISTANCE: 100002;
@@ -133,60 +202,7 @@ export interface SlvsModule {
   isDistance(entity: Entity): boolean;
   isPoint(entity: Entity): boolean;
 
-  addPoint2D(grouph: number, u: number, v: number, workplane: Entity): Entity;
-  addPoint3D(grouph: number, x: number, y: number, z: number): Entity;
-  addNormal2D(grouph: number, workplane: Entity): Entity;
-  addNormal3D(grouph: number, qw: number, qx: number, qy: number, qz: number): Entity;
-  addDistance(grouph: number, value: number, workplane: Entity): Entity;
-  addLine2D(grouph: number, ptA: Entity, ptB: Entity, workplane: Entity): Entity;
-  addLine3D(grouph: number, ptA: Entity, ptB: Entity): Entity;
-  addCubic(grouph: number, ptA: Entity, ptB: Entity, ptC: Entity, ptD: Entity, workplane: Entity): Entity;
-  addArc(grouph: number, normal: Entity, center: Entity, start: Entity, end: Entity, workplane: Entity): Entity;
-  addCircle(grouph: number, normal: Entity, center: Entity, radius: Entity, workplane: Entity): Entity;
-  addWorkplane(grouph: number, origin: Entity, nm: Entity): Entity;
-  addBase2D(grouph: number): Entity;
-
-  addConstraint(
-    grouph: number,
-    type: number,
-    workplane: Entity,
-    val: number,
-    ptA: Entity,
-    ptB: Entity,
-    entityA: Entity,
-    entityB: Entity,
-    entityC: Entity,
-    entityD: Entity,
-    other: boolean,
-    other2: boolean,
-  ): Constraint;
-
-  coincident(grouph: number, entityA: Entity, entityB: Entity, workplane: Entity): Constraint;
-  distance(grouph: number, entityA: Entity, entityB: Entity, value: number, workplane: Entity): Constraint;
-  equal(grouph: number, entityA: Entity, entityB: Entity, workplane: Entity): Constraint;
-  equalAngle(grouph: number, entityA: Entity, entityB: Entity, entityC: Entity, entityD: Entity, workplane: Entity): Constraint;
-  equalPointToLine(grouph: number, entityA: Entity, entityB: Entity, entityC: Entity, entityD: Entity, workplane: Entity): Constraint;
-  ratio(grouph: number, entityA: Entity, entityB: Entity, value: number, workplane: Entity): Constraint;
-  symmetric(grouph: number, entityA: Entity, entityB: Entity, entityC: Entity): Constraint;
-  symmetricH(grouph: number, ptA: Entity, ptB: Entity, workplane: Entity): Constraint;
-  symmetricV(grouph: number, ptA: Entity, ptB: Entity, workplane: Entity): Constraint;
-  midpoint(grouph: number, ptA: Entity, ptB: Entity, workplane: Entity): Constraint;
-  horizontal(grouph: number, entityA: Entity, workplane: Entity, entityB: Entity): Constraint;
-  vertical(grouph: number, entityA: Entity, workplane: Entity, entityB: Entity): Constraint;
-  diameter(grouph: number, entityA: Entity, value: number): Constraint;
-  sameOrientation(grouph: number, entityA: Entity, entityB: Entity): Constraint;
-  angle(grouph: number, entityA: Entity, entityB: Entity, value: number, workplane: Entity, inverse: boolean): Constraint;
-  perpendicular(grouph: number, entityA: Entity, entityB: Entity, workplane: Entity, inverse: boolean): Constraint;
-  parallel(grouph: number, entityA: Entity, entityB: Entity, workplane: Entity): Constraint;
-  tangent(grouph: number, entityA: Entity, entityB: Entity, workplane: Entity): Constraint;
-  distanceProj(grouph: number, ptA: Entity, ptB: Entity, value: number): Constraint;
-  lengthDiff(grouph: number, entityA: Entity, entityB: Entity, value: number, workplane: Entity): Constraint;
-  dragged(grouph: number, ptA: Entity, workplane: Entity): Constraint;
-
-  getParamValue(ph: number): number;
-  setParamValue(ph: number, value: number): number;
-  solveSketch(hgroup: number, calculateFaileds: boolean): SolveResult;
-  clearSketch(): void;
+  Context: ContextConstructor;
 }
 
 declare function ModuleLoader(): Promise<SlvsModule>;
@@ -43,6 +43,7 @@ from .solvespace import (
     vertical,
     ResultFlag,
     ConstraintType,
+    Context,
     E_NONE,
     E_FREE_IN_3D
 )
@@ -92,6 +93,7 @@ __all__ = [
     "vertical",
     "ResultFlag",
     "ConstraintType",
+    "Context",
     "E_NONE",
     "E_FREE_IN_3D",
 ]
@@ -277,4 +277,49 @@ def get_param_value(ph: int) -> float:
     ...
 
 def set_param_value(ph: int, value: float) -> None:
-    ...
\ No newline at end of file
+    ...
+class Context:
+    """An independent sketch; see the `Context` docstring in the module."""
+    def __init__(self) -> None: ...
+    def add_point_2d(self, grouph: int, u: float, v: float, wp: Slvs_Entity) -> Slvs_Entity: ...
+    def add_point_3d(self, grouph: int, x: float, y: float, z: float) -> Slvs_Entity: ...
+    def add_normal_2d(self, grouph: int, wp: Slvs_Entity) -> Slvs_Entity: ...
+    def add_normal_3d(self, grouph: int, qw: float, qx: float, qy: float, qz: float) -> Slvs_Entity: ...
+    def add_distance(self, grouph: int, d: float, wp: Slvs_Entity) -> Slvs_Entity: ...
+    def add_line_2d(self, grouph: int, p1: Slvs_Entity, p2: Slvs_Entity, wp: Slvs_Entity) -> Slvs_Entity: ...
+    def add_line_3d(self, grouph: int, p1: Slvs_Entity, p2: Slvs_Entity) -> Slvs_Entity: ...
+    def add_cubic(self, grouph: int, p1: Slvs_Entity, p2: Slvs_Entity, p3: Slvs_Entity, p4: Slvs_Entity, wp: Slvs_Entity) -> Slvs_Entity: ...
+    def add_arc(self, grouph: int, nm: Slvs_Entity, ct: Slvs_Entity, start: Slvs_Entity, end: Slvs_Entity, wp: Slvs_Entity) -> Slvs_Entity: ...
+    def add_circle(self, grouph: int, nm: Slvs_Entity, ct: Slvs_Entity, radius: Slvs_Entity, wp: Slvs_Entity) -> Slvs_Entity: ...
+    def add_workplane(self, grouph: int, origin: Slvs_Entity, nm: Slvs_Entity) -> Slvs_Entity: ...
+    def add_base_2d(self, grouph: int) -> Slvs_Entity: ...
+    def add_constraint(self, grouph: int, c_type: int, wp: Slvs_Entity, v: float, p1: Slvs_Entity = E_NONE,
+                       p2: Slvs_Entity = E_NONE, e1: Slvs_Entity = E_NONE, e2: Slvs_Entity = E_NONE,
+                       e3: Slvs_Entity = E_NONE, e4: Slvs_Entity = E_NONE, other: int = 0,
+                       other2: int = 0) -> Slvs_Constraint: ...
+    def coincident(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, wp: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint: ...
+    def distance(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, value: float, wp: Slvs_Entity) -> Slvs_Constraint: ...
+    def equal(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, wp: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint: ...
+    def equal_angle(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, e3: Slvs_Entity, e4: Slvs_Entity, wp: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint: ...
+    def equal_point_to_line(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, e3: Slvs_Entity, e4: Slvs_Entity, wp: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint: ...
+    def ratio(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, value: float, wp: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint: ...
+    def symmetric(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, e3: Slvs_Entity = E_NONE, wp: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint: ...
+    def symmetric_h(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, wp: Slvs_Entity) -> Slvs_Constraint: ...
+    def symmetric_v(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, wp: Slvs_Entity) -> Slvs_Constraint: ...
+    def midpoint(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, wp: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint: ...
+    def horizontal(self, grouph: int, e1: Slvs_Entity, wp: Slvs_Entity, e2: Slvs_Entity = E_NONE) -> Slvs_Constraint: ...
+    def vertical(self, grouph: int, e1: Slvs_Entity, wp: Slvs_Entity, e2: Slvs_Entity = E_NONE) -> Slvs_Constraint: ...
+    def diameter(self, grouph: int, e1: Slvs_Entity, value: float) -> Slvs_Constraint: ...
+    def same_orientation(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity) -> Slvs_Constraint: ...
+    def angle(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, value: float, wp: Slvs_Entity = E_FREE_IN_3D, inverse: bool = False) -> Slvs_Constraint: ...
+    def perpendicular(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, wp: Slvs_Entity = E_FREE_IN_3D, inverse: bool = False) -> Slvs_Constraint: ...
+    def parallel(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, wp: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint: ...
+    def tangent(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, wp: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint: ...
+    def distance_proj(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, value: float) -> Slvs_Constraint: ...
+    def length_diff(self, grouph: int, e1: Slvs_Entity, e2: Slvs_Entity, value: float, wp: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint: ...
+    def dragged(self, grouph: int, e1: Slvs_Entity, wp: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint: ...
+    def mark_dragged(self, e1: Slvs_Entity) -> None: ...
+    def solve_sketch(self, grouph: int, calculateFaileds: bool) -> Slvs_SolveResult: ...
+    def get_param_value(self, ph: int) -> float: ...
+    def set_param_value(self, ph: int, value: float) -> None: ...
+    def clear_sketch(self) -> None: ...
@@ -1,4 +1,5 @@
 from unittest import TestCase
+from concurrent.futures import ThreadPoolExecutor
 import slvs
 # from solvespace import ConstraintType, E_NONE
 from math import radians
@@ -251,3 +252,131 @@ class CoreTest(TestCase):
     x = slvs.get_param_value(d307['param'][0])
     self.assertAlmostEqual(17, x, 4)
     self.assertEqual(6, g2result['dof'])
+
+  def test_clusters(self):
+    """Disconnected sub-sketches, solved as independent clusters."""
+    print("Clusters")
+    slvs.clear_sketch()
+    wp = slvs.add_base_2d(1)
+    g = 2
+    triangles = []
+    for i in range(3):
+      a = slvs.add_point_2d(g, 100 * i, 0, wp)
+      b = slvs.add_point_2d(g, 100 * i + 10, 1, wp)
+      c = slvs.add_point_2d(g, 100 * i + 3, 8, wp)
+      slvs.distance(g, a, b, 10, wp)
+      slvs.distance(g, b, c, 10, wp)
+      slvs.distance(g, c, a, 10, wp)
+      triangles.append((a, b, c))
+    slvs.add_point_2d(g, 5, 5, wp)
+
+    result = slvs.solve_sketch(g, False)
+    self.assertEqual(result['result'], slvs.ResultFlag.OKAY)
+    # Three dof for each triangle, and two for the lone point
+    self.assertEqual(11, result['dof'])
+    a, b, c = triangles[1]
+    x0 = slvs.get_param_value(a['param'][0])
+    x1 = slvs.get_param_value(b['param'][0])
+    y0 = slvs.get_param_value(a['param'][1])
+    y1 = slvs.get_param_value(b['param'][1])
+    self.assertAlmostEqual(10, ((x1 - x0)**2 + (y1 - y0)**2)**0.5, 6)
+
+    # Over-constrain only the last triangle
+    a, b, c = triangles[2]
+    slvs.distance(g, a, b, 10, wp)
+    result = slvs.solve_sketch(g, False)
+    self.assertEqual(result['result'], slvs.ResultFlag.REDUNDANT_OKAY)
+    self.assertEqual(11, result['dof'])
+
+  def test_clusters_didnt_converge(self):
+    """Every cluster that fails to converge reports its constraints."""
+    print("Clusters didn't converge")
+    nbad = []
+    for impossible in range(1, 3):
+      slvs.clear_sketch()
+      wp = slvs.add_base_2d(1)
+      g = 2
+      for i in range(3):
+        a = slvs.add_point_2d(g, 100 * i, 0, wp)
+        b = slvs.add_point_2d(g, 100 * i + 10, 1, wp)
+        c = slvs.add_point_2d(g, 100 * i + 3, 8, wp)
+        slvs.distance(g, a, b, 10, wp)
+        slvs.distance(g, b, c, 10, wp)
+        # Too long to close the triangle
+        slvs.distance(g, c, a, 30 if i < impossible else 10, wp)
+
+      result, bad = slvs.solve_sketch(g, True)
+      self.assertEqual(result['result'], slvs.ResultFlag.DIDNT_CONVERGE)
+      nbad.append(len(bad))
+    self.assertTrue(nbad[0] > 0)
+    self.assertEqual(2 * nbad[0], nbad[1])
+
+  def test_drag(self):
+    """Re-solving as a point is dragged; only the values change."""
+    print("Drag")
+    slvs.clear_sketch()
+    wp = slvs.add_base_2d(1)
+    g = 2
+    p0 = slvs.add_point_2d(1, 0, 0, wp)
+    p1 = slvs.add_point_2d(g, 10, 0, wp)
+    p2 = slvs.add_point_2d(g, 5, 5, wp)
+    slvs.distance(g, p0, p1, 10, wp)
+    slvs.distance(g, p1, p2, 10, wp)
+    for i in range(20):
+      x, y = 5 + i, 5 + 0.5 * i
+      slvs.set_param_value(p2['param'][0], x)
+      slvs.set_param_value(p2['param'][1], y)
+      result = slvs.solve_sketch(g, False)
+      self.assertEqual(result['result'], slvs.ResultFlag.OKAY)
+      self.assertEqual(2, result['dof'])
+      x1 = slvs.get_param_value(p1['param'][0])
+      y1 = slvs.get_param_value(p1['param'][1])
+      x2 = slvs.get_param_value(p2['param'][0])
+      y2 = slvs.get_param_value(p2['param'][1])
+      self.assertAlmostEqual(10, (x1**2 + y1**2)**0.5, 6)
+      self.assertAlmostEqual(10, ((x2 - x1)**2 + (y2 - y1)**2)**0.5, 6)
+
+  def test_contexts(self):
+    """Crank rocker example, solved in many contexts on several threads."""
+    print("Contexts")
+
+    def crank_rocker(angle):
+      ctx = slvs.Context()
+      g = 1
+      wp = ctx.add_base_2d(g)
+      p0 = ctx.add_point_2d(g, 0, 0, wp)
+      ctx.dragged(g, p0, wp)
+      p1 = ctx.add_point_2d(g, 90, 0, wp)
+      ctx.dragged(g, p1, wp)
+      line0 = ctx.add_line_2d(g, p0, p1, wp)
+      p2 = ctx.add_point_2d(g, 20, 20, wp)
+      p3 = ctx.add_point_2d(g, 0, 10, wp)
+      p4 = ctx.add_point_2d(g, 30, 20, wp)
+      ctx.distance(g, p2, p3, 40, wp)
+      ctx.distance(g, p2, p4, 40, wp)
+      ctx.distance(g, p3, p4, 70, wp)
+      ctx.distance(g, p0, p3, 35, wp)
+      ctx.distance(g, p1, p4, 70, wp)
+      line1 = ctx.add_line_2d(g, p0, p3, wp)
+      ctx.angle(g, line0, line1, angle, wp, False)
+
+      result = ctx.solve_sketch(g, False)
+      return (result['result'],
+              ctx.get_param_value(p2['param'][0]),
+              ctx.get_param_value(p2['param'][1]))
+
+    # A context does not disturb the shared sketch, nor the other contexts.
+    slvs.clear_sketch()
+    g = 1
+    wp = slvs.add_base_2d(g)
+    p = slvs.add_point_2d(g, 3, 4, wp)
+
+    with ThreadPoolExecutor(max_workers=4) as pool:
+      results = list(pool.map(crank_rocker, [45] * 16))
+    for result, x, y in results:
+      self.assertEqual(result, slvs.ResultFlag.OKAY)
+      self.assertAlmostEqual(39.54852, x, 4)
+      self.assertAlmostEqual(61.91009, y, 4)
+
+    self.assertAlmostEqual(3, slvs.get_param_value(p['param'][0]))
+    self.assertAlmostEqual(4, slvs.get_param_value(p['param'][1]))
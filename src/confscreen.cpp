@@ -81,6 +81,10 @@ void TextWindow::ScreenChangeShowFullFilePath(int link, uint32_t v) {
     SS.UpdateWindowTitles();
 }
 
+void TextWindow::ScreenChangeSaveBinaryFiles(int link, uint32_t v) {
+    SS.saveBinaryFiles = !SS.saveBinaryFiles;
+}
+
 void TextWindow::ScreenChangeFixExportColors(int link, uint32_t v) {
     SS.fixExportColors = !SS.fixExportColors;
 }
@@ -365,6 +369,8 @@ void TextWindow::ShowConfiguration() {
         SS.arcDimDefaultDiameter ? CHECK_TRUE : CHECK_FALSE);
     Printf(false, "  %Fd%f%Ll%s  display the full path in the title bar%E",
            &ScreenChangeShowFullFilePath, SS.showFullFilePath ? CHECK_TRUE : CHECK_FALSE);
+    Printf(false, "  %Fd%f%Ll%s  save files in binary format%E",
+           &ScreenChangeSaveBinaryFiles, SS.saveBinaryFiles ? CHECK_TRUE : CHECK_FALSE);
     Printf(false, "");
     Printf(false, "%Ft autosave interval (in minutes)%E");
     Printf(false, "%Ba   %d %Fl%Ll%f[change]%E",
@@ -378,6 +384,11 @@ void TextWindow::ShowConfiguration() {
     Printf(false, "%Ba   %d %Fl%Ll%f[change]%E",
         SS.animationSpeed, &ScreenChangeAnimationSpeed);
 
+    Printf(false, "");
+    Printf(false, "%Ft undo history%E");
+    Printf(false, "%Ba   %d undo, %d redo steps in %s kB",
+        SS.undo.cnt, SS.redo.cnt, ssprintf("%.1f", SS.UndoMemoryUsage() / 1024.0).c_str());
+
     if(canvas) {
         const char *gl_vendor, *gl_renderer, *gl_version;
         canvas->GetIdent(&gl_vendor, &gl_renderer, &gl_version);
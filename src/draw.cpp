@@ -417,6 +417,198 @@ GraphicsWindow::Selection GraphicsWindow::ChooseFromHoverToDrag() {
     return sel;
 }
 
+// The size of a cell of the pick index, in pixels.
+static const double PICK_CELL_SIZE = 32.0;
+
+// How an entity is drawn into the pick index to measure it, or nullptr if it
+// isn't measured at all. Normals and workplanes are drawn at a fixed size on
+// the screen, or in its corner, and don't depend only on the sketch; there
+// are few of them anyway.
+static std::function<void()> PickDrawFn(Entity *e, Canvas *canvas) {
+    switch(e->type) {
+        case Entity::Type::LINE_SEGMENT:
+        case Entity::Type::CIRCLE:
+        case Entity::Type::ARC_OF_CIRCLE:
+        case Entity::Type::CUBIC:
+        case Entity::Type::CUBIC_PERIODIC:
+        case Entity::Type::TTF_TEXT:
+        case Entity::Type::IMAGE:
+            break;
+
+        default:
+            if(!e->IsPoint()) return nullptr;
+            break;
+    }
+    return [=]{ e->Draw(Entity::DrawAs::DEFAULT, canvas); };
+}
+
+// A hash of where an entity is, from its points, normal and distance. While
+// dragging, nothing else about it changes, so if this didn't change then
+// neither did the entity as drawn.
+static uint64_t EntityGeometryHash(const Entity &e) {
+    uint64_t h = 0;
+    auto add = [&](double v) {
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        h = (h ^ bits) * 0x9e3779b97f4a7c15;
+        h ^= h >> 29;
+    };
+    auto addPoint = [&](Vector p) {
+        add(p.x);
+        add(p.y);
+        add(p.z);
+    };
+
+    if(e.IsPoint()) {
+        addPoint(e.PointGetNum());
+        return h;
+    }
+    for(int i = 0; i < MAX_POINTS_IN_ENTITY && e.point[i].v != 0; i++) {
+        addPoint(SK.GetEntity(e.point[i])->PointGetNum());
+    }
+    if(e.normal.v != 0) {
+        Quaternion q = SK.GetEntity(e.normal)->NormalGetNum();
+        add(q.w);
+        add(q.vx);
+        add(q.vy);
+        add(q.vz);
+    }
+    if(e.distance.v != 0) {
+        add(SK.GetEntity(e.distance)->DistanceGetNum());
+    }
+    return h;
+}
+
+// Put an item of the pick index in the cells that its drawn extent comes
+// within the selection radius of.
+static void PlacePickItem(GraphicsWindow *gw, uint32_t index, BBoxMeasurer *measurer,
+                          const std::function<void()> &drawFn, double selRadius) {
+    auto &pickIndex = gw->pickIndex;
+    const Camera &camera = measurer->camera;
+    GraphicsWindow::PickExtent &ext = pickIndex.extents[index];
+    ext = {};
+    ext.x0 = 0;
+    ext.x1 = -1;
+    // Anything that draws nothing now (usually because it's hidden) may
+    // yet draw something, depending on the view options, so it has to be
+    // tried everywhere.
+    if(!drawFn || !measurer->Measure(drawFn)) {
+        ext.unbounded = true;
+        pickIndex.unbounded.push_back(index);
+        return;
+    }
+
+    double r = selRadius + measurer->maxWidth / 2.0;
+    ext.x0 = (int)floor((measurer->bbox.minp.x - r + camera.width  / 2.0) / PICK_CELL_SIZE);
+    ext.x1 = (int)floor((measurer->bbox.maxp.x + r + camera.width  / 2.0) / PICK_CELL_SIZE);
+    ext.y0 = (int)floor((measurer->bbox.minp.y - r + camera.height / 2.0) / PICK_CELL_SIZE);
+    ext.y1 = (int)floor((measurer->bbox.maxp.y + r + camera.height / 2.0) / PICK_CELL_SIZE);
+    ext.x0 = std::max(ext.x0, 0);
+    ext.y0 = std::max(ext.y0, 0);
+    ext.x1 = std::min(ext.x1, pickIndex.columns - 1);
+    ext.y1 = std::min(ext.y1, pickIndex.rows - 1);
+    for(int y = ext.y0; y <= ext.y1; y++) {
+        for(int x = ext.x0; x <= ext.x1; x++) {
+            pickIndex.cells[y * pickIndex.columns + x].push_back(index);
+        }
+    }
+}
+
+void GraphicsWindow::BuildPickIndex(const Camera &camera, double selRadius) {
+    pickIndex.width       = camera.width;
+    pickIndex.height      = camera.height;
+    pickIndex.columns     = std::max(1, (int)ceil(camera.width / PICK_CELL_SIZE));
+    pickIndex.rows        = std::max(1, (int)ceil(camera.height / PICK_CELL_SIZE));
+    pickIndex.entities    = SK.entity.n;
+    pickIndex.constraints = SK.constraint.n;
+    pickIndex.items.clear();
+    pickIndex.extents.resize(SK.entity.n + SK.constraint.n);
+    pickIndex.geometry.clear();
+    pickIndex.cells.clear();
+    pickIndex.cells.resize(pickIndex.columns * pickIndex.rows);
+    pickIndex.unbounded.clear();
+
+    // Measure everything as the picker draws it.
+    BBoxMeasurer measurer = {};
+    measurer.camera = camera;
+    for(Entity &e : SK.entity) {
+        Selection item = {};
+        item.entity = e.h;
+        pickIndex.items.push_back(item);
+        pickIndex.geometry.push_back(EntityGeometryHash(e));
+        PlacePickItem(this, (uint32_t)pickIndex.items.size() - 1, &measurer,
+                      PickDrawFn(&e, &measurer), selRadius);
+    }
+    for(Constraint &c : SK.constraint) {
+        Selection item = {};
+        item.constraint = c.h;
+        pickIndex.items.push_back(item);
+        PlacePickItem(this, (uint32_t)pickIndex.items.size() - 1, &measurer,
+                      [&]{ c.Draw(Constraint::DrawAs::DEFAULT, &measurer); }, selRadius);
+    }
+    measurer.Clear();
+
+    pickIndex.dirty = false;
+    pickIndex.moved = false;
+}
+
+// After a drag step, place again only the entities that moved. The
+// constraints are left where they were, since they're not hovered during a
+// drag; the index gets rebuilt once the drag is done. Returns false if the
+// entities themselves changed, so that it has to be rebuilt now.
+bool GraphicsWindow::UpdatePickIndex(const Camera &camera, double selRadius) {
+    if(pickIndex.entities != SK.entity.n) return false;
+
+    BBoxMeasurer measurer = {};
+    measurer.camera = camera;
+    uint32_t i = 0;
+    for(Entity &e : SK.entity) {
+        if(pickIndex.items[i].entity != e.h) {
+            measurer.Clear();
+            return false;
+        }
+        uint64_t geometry = EntityGeometryHash(e);
+        PickExtent &ext = pickIndex.extents[i];
+        if(geometry != pickIndex.geometry[i] && !ext.unbounded) {
+            for(int y = ext.y0; y <= ext.y1; y++) {
+                for(int x = ext.x0; x <= ext.x1; x++) {
+                    std::vector<uint32_t> &cell = pickIndex.cells[y * pickIndex.columns + x];
+                    cell.erase(std::find(cell.begin(), cell.end(), i));
+                }
+            }
+            PlacePickItem(this, i, &measurer, PickDrawFn(&e, &measurer), selRadius);
+        }
+        pickIndex.geometry[i] = geometry;
+        i++;
+    }
+    measurer.Clear();
+
+    pickIndex.moved = false;
+    return true;
+}
+
+void GraphicsWindow::GetPickCandidates(Point2d mp, std::vector<uint32_t> *candidates) {
+    candidates->clear();
+
+    int x = (int)floor((mp.x + pickIndex.width  / 2.0) / PICK_CELL_SIZE),
+        y = (int)floor((mp.y + pickIndex.height / 2.0) / PICK_CELL_SIZE);
+    if(x < 0 || x >= pickIndex.columns || y < 0 || y >= pickIndex.rows) {
+        // The cursor can leave the window while dragging; try everything.
+        for(uint32_t i = 0; i < pickIndex.items.size(); i++) {
+            candidates->push_back(i);
+        }
+        return;
+    }
+
+    const std::vector<uint32_t> &cell = pickIndex.cells[y * pickIndex.columns + x];
+    candidates->insert(candidates->end(), cell.begin(), cell.end());
+    candidates->insert(candidates->end(),
+                       pickIndex.unbounded.begin(), pickIndex.unbounded.end());
+    // Try them in the same order as the sketch, so that ties between equally
+    // good picks are broken as before.
+    std::sort(candidates->begin(), candidates->end());
+}
+
 void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
     hoverList = {};
     Selection sel = {};
@@ -433,6 +625,7 @@ void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
         for(Entity &e : SK.entity) {
             e.screenBBoxValid = false;
         }
+        pickIndex.dirty = true;
     }
 
     ObjectPicker canvas = {};
@@ -441,9 +634,23 @@ void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
     canvas.point     = mp;
     canvas.maxZIndex = -1;
 
+    if(pickIndex.dirty ||
+       EXACT(pickIndex.width != canvas.camera.width) ||
+       EXACT(pickIndex.height != canvas.camera.height) ||
+       pickIndex.entities != SK.entity.n ||
+       pickIndex.constraints != SK.constraint.n ||
+       (pickIndex.moved && (pending.operation == Pending::NONE ||
+                            !UpdatePickIndex(canvas.camera, canvas.selRadius)))) {
+        BuildPickIndex(canvas.camera, canvas.selRadius);
+    }
+    std::vector<uint32_t> candidates;
+    GetPickCandidates(mp, &candidates);
+
     // Always do the entities; we might be dragging something that should
     // be auto-constrained, and we need the hover for that.
-    for(Entity &e : SK.entity) {
+    for(uint32_t i : candidates) {
+        if(pickIndex.items[i].entity.v == 0) continue;
+        Entity &e = *SK.GetEntity(pickIndex.items[i].entity);
         if(!e.IsVisible()) continue;
 
         // If faces aren't selectable, image entities aren't either.
@@ -475,7 +682,9 @@ void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
     // The constraints and faces happen only when nothing's in progress.
     if(pending.operation == Pending::NONE) {
         // Constraints
-        for(Constraint &c : SK.constraint) {
+        for(uint32_t i : candidates) {
+            if(pickIndex.items[i].constraint.v == 0) continue;
+            Constraint &c = *SK.GetConstraint(pickIndex.items[i].constraint);
             if(canvas.Pick([&]{ c.Draw(Constraint::DrawAs::DEFAULT, &canvas); })) {
                 Hover hov = {};
                 hov.distance = canvas.minDistance;
@@ -499,7 +708,7 @@ void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
             Group *g = SK.GetGroup(activeGroup);
             SMesh *m = &(g->displayMesh);
 
-            uint32_t v = m->FirstIntersectionWith(mp);
+            uint32_t v = m->FirstIntersectionWith(mp, g->DisplayMeshBvh());
             if(v) {
                 sel.entity.v = v;
                 Hover hov = {};
@@ -953,6 +1162,7 @@ void GraphicsWindow::Invalidate(bool clearPersistent) {
     if(window) {
         if(clearPersistent) {
             persistentDirty = true;
+            pickIndex.dirty = true;
         }
         window->Invalidate();
     }
@@ -11,9 +11,11 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <unordered_map>
 #include <vector>
 
 #include "defs.h"
+#include "handle.h"
 #include "util.h"
 
 namespace SolveSpace {
@@ -352,13 +354,11 @@ public:
     }
 };
 
-template<class T, class H> class IdList;
-
 // Comparison functor used by IdList and related classes
-template <class T, class H>
+template <class T, class H, IdIndex Index>
 struct CompareId {
 
-    CompareId(const IdList<T, H> *list) {
+    CompareId(const IdList<T, H, Index> *list) {
         idlist = list;
     }
 
@@ -373,22 +373,24 @@ struct CompareId {
     }
 
 private:
-    const IdList<T, H> *idlist;
+    const IdList<T, H, Index> *idlist;
 };
 
 // A list, where each element has an integer identifier. The list is kept
 // sorted by that identifier, and items can be looked up in log n time by
-// id.
-template <class T, class H>
+// id, or in constant time if the list is hashed.
+template <class T, class H, IdIndex Index>
 class IdList {
     std::vector<T> elemstore;
     std::vector<int> elemidx;
     std::vector<int> freelist;
+    // Only for hashed lists, from the handle to the index in elemstore
+    std::unordered_map<uint32_t, int> hashidx;
 public:
     int n = 0;  // PAR@@@@@ make this private to see all interesting and suspicious places in SoveSpace ;-)
 
-    friend struct CompareId<T, H>;
-    using Compare = CompareId<T, H>;
+    friend struct CompareId<T, H, Index>;
+    using Compare = CompareId<T, H, Index>;
 
     struct iterator {
         typedef std::random_access_iterator_tag iterator_category;
@@ -419,14 +421,14 @@ public:
             return position - rhs.position;
         }
 
-        iterator(IdList<T, H> *l) : position(0), list(l) {
+        iterator(IdList *l) : position(0), list(l) {
             if(list) {
                 if(list->elemstore.size() && list->elemidx.size()) {
                     elem = &(list->elemstore[list->elemidx[position]]);
                 }
             }
         };
-        iterator(IdList<T, H> *l, int pos) : position(pos), list(l) {
+        iterator(IdList *l, int pos) : position(pos), list(l) {
             if(position >= (int)list->elemidx.size()) {
                 elem = nullptr;
             } else if(0 <= position) {
@@ -437,7 +439,7 @@ public:
     private:
         int position;
         T *elem;
-        IdList<T, H> *list;
+        IdList *list;
     };
 
 
@@ -459,6 +461,9 @@ public:
         // Add at the end of the list.
         elemstore.push_back(*t);
         elemidx.push_back(elemstore.size()-1);
+        if(Index == IdIndex::HASHED) {
+            hashidx[t->h.v] = elemstore.size()-1;
+        }
         ++n;
 
         return t->h;
@@ -474,22 +479,20 @@ public:
         // Look to see if we already have something with the same handle value.
         ssassert(FindByIdNoOops(t->h) == nullptr, "Handle isn't unique");
 
-        // Find out where the added element should be.
-        auto pos = std::lower_bound(elemidx.begin(), elemidx.end(), *t, Compare(this));
+        // Find out where the added element should be. Elements are mostly
+        // added in order of their handles, so try the end first.
+        auto pos = elemidx.end();
+        if(!elemidx.empty() && t->h.v < elemstore[elemidx.back()].h.v) {
+            pos = std::lower_bound(elemidx.begin(), elemidx.end(), *t, Compare(this));
+        }
 
         if(freelist.empty()) { // Add a new element to the store
             elemstore.push_back(*t);
             // Insert a pointer to the element at the correct position
-            if(elemidx.empty()) {
-                // The list is empty so pos, begin and end are all null.
-                // insert does not work in this case.
-                elemidx.push_back(elemstore.size()-1);
-            } else {
-                elemidx.insert(pos, elemstore.size() - 1);
-            }
+            pos = elemidx.insert(pos, elemstore.size() - 1);
         } else { // Use the last element from the freelist
             // Insert an index to the element at the correct position
-            elemidx.insert(pos, freelist.back());
+            pos = elemidx.insert(pos, freelist.back());
             // Remove the element from the freelist
             freelist.pop_back();
 
@@ -497,6 +500,9 @@ public:
             elemstore[*pos] = T(*t);
             //            *elemptr[pos] = *t;   // PAR@@@@@@ maybe this?
         }
+        if(Index == IdIndex::HASHED) {
+            hashidx[t->h.v] = *pos;
+        }
 
         ++n;
     }
@@ -511,6 +517,10 @@ public:
         if(IsEmpty()) {
             return nullptr;
         }
+        if(Index == IdIndex::HASHED) {
+            auto it = hashidx.find(h.v);
+            return (it == hashidx.end()) ? nullptr : &elemstore[it->second];
+        }
         auto it = std::lower_bound(elemidx.begin(), elemidx.end(), h, Compare(this));
         if(it == elemidx.end()) {
             return nullptr;
@@ -545,6 +555,9 @@ public:
         for(src = 0; src < n; src++) {
             if(elemstore[elemidx[src]].tag) {
                 // this item should be deleted
+                if(Index == IdIndex::HASHED) {
+                    hashidx.erase(elemstore[elemidx[src]].h.v);
+                }
                 elemstore[elemidx[src]].Clear();
 //                elemstore[elemidx[src]].~T(); // Clear below calls the destructors
                 freelist.push_back(elemidx[src]);
@@ -559,21 +572,31 @@ public:
         n = dest;
         elemidx.resize(n);  // Clear left over elements at the end.
     }
-    void RemoveById(H h) {  // PAR@@@@@ this can be optimized
-        ClearTags();
-        FindById(h)->tag = 1;
-        RemoveTagged();
+    // This is O(n) even for a hashed list, since the sorted index has to
+    // close up behind the removed element; to remove many elements, tag them
+    // and use RemoveTagged() instead.
+    void RemoveById(H h) {
+        auto pos = std::lower_bound(elemidx.begin(), elemidx.end(), h, Compare(this));
+        ssassert(pos != elemidx.end() && elemstore[*pos].h.v == h.v, "Cannot find handle");
+        if(Index == IdIndex::HASHED) {
+            hashidx.erase(h.v);
+        }
+        elemstore[*pos].Clear();
+        freelist.push_back(*pos);
+        elemidx.erase(pos);
+        --n;
     }
 
-    void MoveSelfInto(IdList<T,H> *l) {
+    void MoveSelfInto(IdList *l) {
         l->Clear();
         std::swap(l->elemstore, elemstore);
         std::swap(l->elemidx, elemidx);
         std::swap(l->freelist, freelist);
+        std::swap(l->hashidx, hashidx);
         std::swap(l->n, n);
     }
 
-    void DeepCopyInto(IdList<T,H> *l) {
+    void DeepCopyInto(IdList *l) {
         l->Clear();
 
         for(auto const &it : elemstore) {
@@ -583,6 +606,7 @@ public:
         for(auto const &it : elemidx) {
             l->elemidx.push_back(it);
         }
+        l->hashidx = hashidx;
 
         l->n = n;
     }
@@ -595,6 +619,7 @@ public:
         freelist.clear();
         elemidx.clear();
         elemstore.clear();
+        hashidx.clear();
         n = 0;
     }
 
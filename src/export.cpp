@@ -407,27 +407,34 @@ void SolveSpaceUI::ExportLinesAndMesh(SEdgeList *sel, SBezierList *sbl, SMesh *s
         // Generate the edges where a curved surface turns from front-facing
         // to back-facing.
         if(SS.GW.showEdges || SS.GW.showOutlines) {
-            root->MakeCertainEdgesInto(sel, EdgeKind::TURNING,
+            SMeshAdjacency adj = {};
+            adj.Build(&smp);
+            root->MakeCertainEdgesInto(adj, sel, EdgeKind::TURNING,
                                        /*coplanarIsInter=*/false, NULL, NULL,
                                        GW.showOutlines ? Style::OUTLINE : Style::SOLID_EDGE);
+            adj.Clear();
         }
 
-        root->ClearTags();
-        int cnt = 1234;
-
+        // Split the original edges against the mesh, except for constraints,
+        // which should not get hidden line removed; they're always on top.
+        SEdgeList test = {};
         SEdge *se;
+        for(se = sel->l.First(); se; se = sel->l.NextAfter(se)) {
+            if(se->auxA == Style::CONSTRAINT) continue;
+            test.l.Add(se);
+        }
+        std::vector<SEdgeList> split;
+        root->OcclusionTestLines(&test, &split);
+        test.Clear();
+
+        size_t i = 0;
         for(se = sel->l.First(); se; se = sel->l.NextAfter(se)) {
             if(se->auxA == Style::CONSTRAINT) {
-                // Constraints should not get hidden line removed; they're
-                // always on top.
                 hlrd.AddEdge(se->a, se->b, se->auxA);
                 continue;
             }
 
-            SEdgeList edges = {};
-            // Split the original edge against the mesh
-            edges.AddEdge(se->a, se->b, se->auxA);
-            root->OcclusionTestLine(*se, &edges, cnt);
+            SEdgeList &edges = split[i++];
             if(SS.GW.drawOccludedAs == GraphicsWindow::DrawOccludedAs::STIPPLED) {
                 for(SEdge &se : edges.l) {
                     if(se.tag == 1) {
@@ -440,7 +447,6 @@ void SolveSpaceUI::ExportLinesAndMesh(SEdgeList *sel, SBezierList *sbl, SMesh *s
 
             // the occlusion test splits unnecessarily; so fix those
             edges.MergeCollinearSegments(se->a, se->b);
-            cnt++;
             // And add the results to our output
             SEdge *sen;
             for(sen = edges.l.First(); sen; sen = edges.l.NextAfter(sen)) {
@@ -899,8 +905,11 @@ void SolveSpaceUI::ExportMeshAsStlTo(FILE *f, SMesh *sm) {
 // identical vertices to the same identifier, so do that first.
 //-----------------------------------------------------------------------------
 void SolveSpaceUI::ExportMeshAsObjTo(FILE *fObj, FILE *fMtl, SMesh *sm) {
+    SWeldedMesh wm = {};
+    wm.MakeFromMesh(sm);
+
     std::map<RgbaColor, std::string, RgbaColorCompare> colors;
-    for(const STriangle &t : sm->l) {
+    for(const SWeldedMesh::Triangle &t : wm.triangles) {
         RgbaColor color = t.meta.color;
         if(colors.find(color) == colors.end()) {
             std::string id = ssprintf("h%02x%02x%02x",
@@ -909,10 +918,10 @@ void SolveSpaceUI::ExportMeshAsObjTo(FILE *fObj, FILE *fMtl, SMesh *sm) {
                                       color.blue);
             colors.emplace(color, id);
         }
-        for(int i = 0; i < 3; i++) {
-            fprintf(fObj, "v %.10f %.10f %.10f\n",
-                    CO(t.vertices[i].ScaledBy(1 / SS.exportScale)));
-        }
+    }
+    for(const Vector &v : wm.vertices) {
+        fprintf(fObj, "v %.10f %.10f %.10f\n",
+                CO(v.ScaledBy(1 / SS.exportScale)));
     }
 
     for(auto &it : colors) {
@@ -922,26 +931,22 @@ void SolveSpaceUI::ExportMeshAsObjTo(FILE *fObj, FILE *fMtl, SMesh *sm) {
                 it.first.redF(), it.first.greenF(), it.first.blueF());
     }
 
-    for(const STriangle &t : sm->l) {
-        for(int i = 0; i < 3; i++) {
-            Vector n = t.normals[i].WithMagnitude(1.0);
-            fprintf(fObj, "vn %.10f %.10f %.10f\n",
-                    CO(n));
-        }
+    for(const Vector &n : wm.normals) {
+        fprintf(fObj, "vn %.10f %.10f %.10f\n",
+                CO(n));
     }
 
     RgbaColor currentColor = {};
-    for(int i = 0; i < sm->l.n; i++) {
-        const STriangle &t = sm->l[i];
+    for(const SWeldedMesh::Triangle &t : wm.triangles) {
         if(!currentColor.Equals(t.meta.color)) {
             currentColor = t.meta.color;
             fprintf(fObj, "usemtl %s\n", colors[currentColor].c_str());
         }
 
-        fprintf(fObj, "f %d//%d %d//%d %d//%d\n",
-                i * 3 + 1, i * 3 + 1,
-                i * 3 + 2, i * 3 + 2,
-                i * 3 + 3, i * 3 + 3);
+        fprintf(fObj, "f %u//%u %u//%u %u//%u\n",
+                t.vertex[0] + 1, t.normal[0] + 1,
+                t.vertex[1] + 1, t.normal[1] + 1,
+                t.vertex[2] + 1, t.normal[2] + 1);
     }
 }
 
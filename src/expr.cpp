@@ -11,9 +11,77 @@
 namespace SolveSpace {
 
 static inline Expr *AllocExpr() {
+    if(ExprArena *arena = ExprArena::Current()) {
+        return arena->Alloc();
+    }
     return (Expr *)Platform::AllocTemporary(sizeof(Expr));
 }
 
+//-----------------------------------------------------------------------------
+// Arenas for expressions with a bounded lifetime.
+//-----------------------------------------------------------------------------
+
+static thread_local ExprArena *CurrentExprArena = NULL;
+
+// In expressions; the blocks grow geometrically up to the maximum.
+static const size_t MinArenaBlock = 2048;
+static const size_t MaxArenaBlock = 262144;
+
+ExprArena::Scope::Scope(ExprArena *arena) {
+    previous = CurrentExprArena;
+    CurrentExprArena = arena;
+}
+
+ExprArena::Scope::~Scope() {
+    CurrentExprArena = previous;
+}
+
+ExprArena *ExprArena::Current() {
+    return CurrentExprArena;
+}
+
+Expr *ExprArena::Alloc() {
+    while(current < blocks.size() && next == blocks[current].n) {
+        current++;
+        next = 0;
+    }
+    if(current == blocks.size()) {
+        size_t n = blocks.empty() ? MinArenaBlock
+                                  : std::min(blocks.back().n * 2, MaxArenaBlock);
+        blocks.push_back({ std::unique_ptr<Expr[]>(new Expr[n]), n });
+        next = 0;
+    }
+
+    used++;
+    peak = std::max(peak, used);
+    Expr *e = &blocks[current].elem[next++];
+    *e = {};
+    return e;
+}
+
+void ExprArena::Reset() {
+    current = 0;
+    next    = 0;
+    used    = 0;
+}
+
+void ExprArena::Release() {
+    Reset();
+    blocks.clear();
+}
+
+ExprArena::Stats ExprArena::GetStats() const {
+    size_t reserved = 0;
+    for(const Block &b : blocks) {
+        reserved += b.n;
+    }
+    Stats stats = {};
+    stats.bytesUsed     = used * sizeof(Expr);
+    stats.bytesReserved = reserved * sizeof(Expr);
+    stats.peakBytesUsed = peak * sizeof(Expr);
+    return stats;
+}
+
 ExprVector ExprVector::From(Expr *x, Expr *y, Expr *z) {
     ExprVector r = { x, y, z};
     return r;
@@ -226,8 +294,8 @@ Expr *Expr::From(hParam p) {
 
 Expr *Expr::From(double v) {
     // Statically allocate common constants.
-    // Note: this is only valid because AllocExpr() uses AllocTemporary(),
-    // and Expr* is never explicitly freed.
+    // Note: this is only valid because AllocExpr() uses AllocTemporary() or
+    // an ExprArena, and Expr* is never explicitly freed.
 
     if(v == 0.0) {
         static Expr zero(0.0);
@@ -313,7 +381,7 @@ Expr *Expr::DeepCopy() const {
 }
 
 Expr *Expr::DeepCopyWithParamsAsPointers(ParamList *firstTry, ParamList *thenTry,
-                                         bool foldConstants) const {
+                                         bool foldConstants, ParamSet *known) const {
     Expr *n = AllocExpr();
     if(op == Op::PARAM) {
         // A param that is referenced by its hParam gets rewritten to go
@@ -324,6 +392,7 @@ Expr *Expr::DeepCopyWithParamsAsPointers(ParamList *firstTry, ParamList *thenTry
         if(p->known) {
             n->op = Op::CONSTANT;
             n->v = p->val;
+            if(known) known->insert(parh);
         } else {
             n->op = Op::PARAM_PTR;
             n->parp = p;
@@ -334,10 +403,10 @@ Expr *Expr::DeepCopyWithParamsAsPointers(ParamList *firstTry, ParamList *thenTry
     *n = *this;
     int c = n->Children();
     if(c > 0) {
-        n->a = a->DeepCopyWithParamsAsPointers(firstTry, thenTry, foldConstants);
+        n->a = a->DeepCopyWithParamsAsPointers(firstTry, thenTry, foldConstants, known);
         bool hasConstants = n->a->op == Op::CONSTANT;
         if(c > 1) {
-            n->b = b->DeepCopyWithParamsAsPointers(firstTry, thenTry, foldConstants);
+            n->b = b->DeepCopyWithParamsAsPointers(firstTry, thenTry, foldConstants, known);
             hasConstants |= n->b->op == Op::CONSTANT;
         }
         if(hasConstants && foldConstants) {
@@ -581,6 +650,119 @@ hParam Expr::ReferencedParams(ParamList *pl) const {
 }
 
 
+//-----------------------------------------------------------------------------
+// Compile expressions to a tape, and evaluate it. Each instruction's operands
+// always come earlier in the tape, so one forward pass evaluates everything.
+//-----------------------------------------------------------------------------
+size_t ExprTape::KeyHasher::operator()(const Key &k) const {
+    size_t h = std::hash<uint64_t>()(k.bits);
+    h ^= std::hash<uint64_t>()(((uint64_t)k.a << 32) | k.b) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= std::hash<uint32_t>()((uint32_t)k.op) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+}
+
+void ExprTape::Clear() {
+    insn.clear();
+    value.clear();
+    paramPtrs.clear();
+    added.clear();
+    shared.clear();
+}
+
+uint32_t ExprTape::Add(const Expr *e) {
+    auto it = added.find(e);
+    if(it != added.end()) return it->second;
+
+    Insn i = {};
+    i.op = e->op;
+    Key key = { e->op, 0, 0, 0 };
+    switch(e->op) {
+        case Expr::Op::PARAM:
+            i.parh   = e->parh;
+            key.bits = e->parh.v;
+            break;
+        case Expr::Op::PARAM_PTR:
+            i.parp   = e->parp;
+            key.bits = (uint64_t)(uintptr_t)e->parp;
+            break;
+        case Expr::Op::CONSTANT:
+            i.v = e->v;
+            memcpy(&key.bits, &e->v, sizeof(key.bits));
+            break;
+        case Expr::Op::VARIABLE:
+            ssassert(false, "Not supported yet");
+
+        default:
+            i.a = key.a = Add(e->a);
+            if(e->Children() > 1) i.b = key.b = Add(e->b);
+            break;
+    }
+
+    uint32_t slot;
+    auto sit = shared.find(key);
+    if(sit != shared.end()) {
+        slot = sit->second;
+    } else {
+        slot = (uint32_t)insn.size();
+        insn.push_back(i);
+        value.push_back(e->op == Expr::Op::CONSTANT ? e->v : 0.0);
+        shared.emplace(key, slot);
+        if(e->op == Expr::Op::PARAM_PTR) {
+            paramPtrs.emplace_back(slot, e->parp->h);
+        }
+    }
+    added.emplace(e, slot);
+    return slot;
+}
+
+void ExprTape::FinishAdding() {
+    std::unordered_map<const Expr *, uint32_t>().swap(added);
+    std::unordered_map<Key, uint32_t, KeyHasher>().swap(shared);
+}
+
+void ExprTape::BindParams(ParamList *firstTry, ParamList *thenTry) {
+    for(const auto &pp : paramPtrs) {
+        Param *p = firstTry->FindByIdNoOops(pp.second);
+        if(!p) p = thenTry->FindById(pp.second);
+        insn[pp.first].parp = p;
+    }
+}
+
+size_t ExprTape::MemoryUsed() const {
+    return insn.size() * sizeof(Insn) +
+           value.size() * sizeof(double) +
+           paramPtrs.size() * sizeof(paramPtrs[0]);
+}
+
+void ExprTape::Eval(size_t end) {
+    ssassert(end <= insn.size(), "Unexpected tape length");
+    const Insn *in = insn.data();
+    double *r = value.data();
+    for(size_t k = 0; k < end; k++) {
+        const Insn &i = in[k];
+        switch(i.op) {
+            case Expr::Op::PARAM:       r[k] = SK.GetParam(i.parh)->val; break;
+            case Expr::Op::PARAM_PTR:   r[k] = i.parp->val;              break;
+            case Expr::Op::CONSTANT:                                     break;
+            case Expr::Op::VARIABLE:    ssassert(false, "Not supported yet");
+
+            case Expr::Op::PLUS:        r[k] = r[i.a] + r[i.b];          break;
+            case Expr::Op::MINUS:       r[k] = r[i.a] - r[i.b];          break;
+            case Expr::Op::TIMES:       r[k] = r[i.a] * r[i.b];          break;
+            case Expr::Op::DIV:         r[k] = r[i.a] / r[i.b];          break;
+
+            case Expr::Op::NEGATE:      r[k] = -r[i.a];                  break;
+            case Expr::Op::SQRT:        r[k] = sqrt(r[i.a]);             break;
+            case Expr::Op::SQUARE:      r[k] = r[i.a] * r[i.a];          break;
+            case Expr::Op::SIN:         r[k] = sin(r[i.a]);              break;
+            case Expr::Op::COS:         r[k] = cos(r[i.a]);              break;
+            case Expr::Op::ACOS:        r[k] = acos(r[i.a]);             break;
+            case Expr::Op::ASIN:        r[k] = asin(r[i.a]);             break;
+        }
+    }
+}
+
+
 //-----------------------------------------------------------------------------
 // Routines to pretty-print an expression. Mostly for debugging.
 //-----------------------------------------------------------------------------
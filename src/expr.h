@@ -9,8 +9,10 @@
 
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "dsc.h"
 #include "param.h"
@@ -103,9 +105,12 @@ public:
     // Make a copy, with the parameters (usually referenced by hParam)
     // resolved to pointers to the actual value. This speeds things up
     // considerably.
+    // If known is given, then the params that were known (and so became
+    // constants) are added to it.
     Expr *DeepCopyWithParamsAsPointers(ParamList *firstTry,
                                        ParamList *thenTry,
-                                       bool foldConstants = false) const;
+                                       bool foldConstants = false,
+                                       ParamSet *known = NULL) const;
 
     static Expr *Parse(const std::string &input, std::string *error);
     static Expr *From(const std::string &input, bool popUpError);
@@ -149,6 +154,116 @@ public:
     Expr *Magnitude() const;
 };
 
+// Storage for expressions with a bounded lifetime, e.g. the equations of one
+// solve. While an arena is current for this thread (see Scope), new
+// expressions are bump-allocated from it instead of the temporary heap, and
+// Reset() drops them all at once while keeping the blocks for reuse.
+class ExprArena {
+public:
+    struct Stats {
+        size_t  bytesUsed;      // by the expressions allocated since Reset()
+        size_t  bytesReserved;  // by all the blocks, used or not
+        size_t  peakBytesUsed;
+    };
+
+    // Makes an arena current until the end of the enclosing block.
+    class Scope {
+    public:
+        explicit Scope(ExprArena *arena);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        ExprArena *previous;
+    };
+
+    ExprArena() = default;
+    ExprArena(const ExprArena &) = delete;
+    ExprArena &operator=(const ExprArena &) = delete;
+
+    // The arena that AllocExpr() uses on this thread, or NULL.
+    static ExprArena *Current();
+
+    Expr *Alloc();
+    void Reset();
+    // Like Reset(), but also frees the blocks.
+    void Release();
+    Stats GetStats() const;
+
+private:
+    struct Block {
+        std::unique_ptr<Expr[]> elem;
+        size_t                  n;
+    };
+
+    std::vector<Block>  blocks;
+    // The block we're allocating from, and the first free element in it
+    size_t              current = 0;
+    size_t              next    = 0;
+    size_t              used    = 0;
+    size_t              peak    = 0;
+};
+
+// A set of expressions flattened into a linear list of instructions, with
+// common subexpressions shared, so that all of them can be evaluated in a
+// single pass without chasing pointers through the trees. Expr::Eval() stays
+// the reference implementation.
+class ExprTape {
+public:
+    struct Insn {
+        Expr::Op    op;
+        // Slots of the operands, for unary and binary ops
+        uint32_t    a, b;
+        union {
+            double  v;
+            hParam  parh;
+            Param  *parp;
+        };
+    };
+
+    std::vector<Insn>   insn;
+    // The value of each slot, as of the last Eval()
+    std::vector<double> value;
+    // The PARAM_PTR instructions, and the params they point to
+    std::vector<std::pair<uint32_t, hParam>> paramPtrs;
+
+    void Clear();
+    // Returns the slot that will hold the value of e.
+    uint32_t Add(const Expr *e);
+    // Free the tables used to share subexpressions, once nothing more will
+    // be added.
+    void FinishAdding();
+    // Point the PARAM_PTR instructions at the params with the same handles in
+    // another table, e.g. when reusing a tape after the params were rebuilt.
+    void BindParams(ParamList *firstTry, ParamList *thenTry);
+    // Evaluate the instructions up to (but not including) slot end.
+    void Eval(size_t end);
+    void Eval() { Eval(insn.size()); }
+    size_t Size() const { return insn.size(); }
+    // Bytes in the instructions and the tables kept with them
+    size_t MemoryUsed() const;
+    double Value(uint32_t slot) const { return value[slot]; }
+
+private:
+    struct Key {
+        Expr::Op    op;
+        uint32_t    a, b;
+        uint64_t    bits;
+
+        bool operator==(const Key &other) const {
+            return op == other.op && a == other.a && b == other.b && bits == other.bits;
+        }
+    };
+    struct KeyHasher {
+        size_t operator()(const Key &k) const;
+    };
+
+    // Nodes we've already compiled, by identity and by structure
+    std::unordered_map<const Expr *, uint32_t> added;
+    std::unordered_map<Key, uint32_t, KeyHasher> shared;
+};
+
 } // namespace SolveSpace
 
 #endif
@@ -5,6 +5,8 @@
 //-----------------------------------------------------------------------------
 #include "solvespace.h"
 
+#include <clocale>
+
 namespace SolveSpace {
 
 #define VERSION_STRING "\261\262\263" "SolveSpaceREVa"
@@ -36,6 +38,9 @@ void SolveSpaceUI::ClearExisting() {
     SK.entity.Clear();
     SK.param.Clear();
     images.clear();
+    linkedParts.clear();
+
+    useSavedGeometry = false;
 }
 
 hGroup SolveSpaceUI::CreateDefaultDrawingGroup() {
@@ -222,6 +227,35 @@ struct SAVEDptr {
     uint32_t  &x() { return *((uint32_t *)this); }
 };
 
+// Any items that aren't specified are assumed to be zero, so aren't saved.
+static bool IsSavedAsDefault(int fmt, SAVEDptr *p) {
+    switch(fmt) {
+        case 'S': return p->S().empty();
+        case 'P': return p->P().IsEmpty();
+        case 'd': return p->d() == 0;
+        case 'f': return EXACT(p->f() == 0.0);
+        case 'x': return p->x() == 0;
+        case 'i': return true;
+        default:  return false;
+    }
+}
+
+static std::string SavedPath(const Platform::Path &path, const Platform::Path &filename) {
+    Platform::Path relativePath = path.Expand(/*fromCurrentDirectory=*/true).RelativeTo(filename.Expand(/*fromCurrentDirectory=*/true).Parent());
+    ssassert(!relativePath.IsEmpty(), "Cannot relativize path");
+    return relativePath.ToPortable();
+}
+
+// Sort the mapping, since EntityMap is not deterministic.
+static std::vector<std::pair<EntityKey, EntityId>> SortedRemap(const EntityMap &m) {
+    std::vector<std::pair<EntityKey, EntityId>> sorted(m.begin(), m.end());
+    std::sort(sorted.begin(), sorted.end(),
+        [](std::pair<EntityKey, EntityId> &a, std::pair<EntityKey, EntityId> &b) {
+            return a.second.v < b.second.v;
+        });
+    return sorted;
+}
+
 void SolveSpaceUI::SaveUsingTable(const Platform::Path &filename, int type) {
     int i;
     for(i = 0; SAVED[i].type != 0; i++) {
@@ -229,13 +263,7 @@ void SolveSpaceUI::SaveUsingTable(const Platform::Path &filename, int type) {
 
         int fmt = SAVED[i].fmt;
         SAVEDptr *p = (SAVEDptr *)SAVED[i].ptr;
-        // Any items that aren't specified are assumed to be zero
-        if(fmt == 'S' && p->S().empty())          continue;
-        if(fmt == 'P' && p->P().IsEmpty())        continue;
-        if(fmt == 'd' && p->d() == 0)             continue;
-        if(fmt == 'f' && EXACT(p->f() == 0.0))    continue;
-        if(fmt == 'x' && p->x() == 0)             continue;
-        if(fmt == 'i')                            continue;
+        if(IsSavedAsDefault(fmt, p)) continue;
 
         fprintf(fh, "%s=", SAVED[i].desc);
         switch(fmt) {
@@ -246,24 +274,11 @@ void SolveSpaceUI::SaveUsingTable(const Platform::Path &filename, int type) {
             case 'f': fprintf(fh, "%.20f", p->f());               break;
             case 'x': fprintf(fh, "%08x",  p->x());               break;
 
-            case 'P': {
-                if(!p->P().IsEmpty()) {
-                    Platform::Path relativePath = p->P().Expand(/*fromCurrentDirectory=*/true).RelativeTo(filename.Expand(/*fromCurrentDirectory=*/true).Parent());
-                    ssassert(!relativePath.IsEmpty(), "Cannot relativize path");
-                    fprintf(fh, "%s", relativePath.ToPortable().c_str());
-                }
-                break;
-            }
+            case 'P': fprintf(fh, "%s",    SavedPath(p->P(), filename).c_str()); break;
 
             case 'M': {
                 fprintf(fh, "{\n");
-                // Sort the mapping, since EntityMap is not deterministic.
-                std::vector<std::pair<EntityKey, EntityId>> sorted(p->M().begin(), p->M().end());
-                std::sort(sorted.begin(), sorted.end(),
-                    [](std::pair<EntityKey, EntityId> &a, std::pair<EntityKey, EntityId> &b) {
-                        return a.second.v < b.second.v;
-                    });
-                for(const auto &it : sorted) {
+                for(const auto &it : SortedRemap(p->M())) {
                     fprintf(fh, "    %d %08x %d\n",
                             it.second.v, it.first.input.v, it.first.copyNumber);
                 }
@@ -279,6 +294,263 @@ void SolveSpaceUI::SaveUsingTable(const Platform::Path &filename, int type) {
     }
 }
 
+//-----------------------------------------------------------------------------
+// The mesh and shell saved after the sketch can be used instead of
+// regenerating them, as long as everything that they were generated from is
+// unchanged. That's the text of the file before them, the settings that
+// determine how finely curves are approximated, and any linked files; hash
+// all of those, and store the hash with the geometry.
+//-----------------------------------------------------------------------------
+static uint64_t HashBytes(const void *data, size_t size,
+                          uint64_t hash = 14695981039346656037ULL) {
+    // FNV-1a
+    const uint8_t *bytes = (const uint8_t *)data;
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t HashFilePrefix(FILE *f, long length) {
+    long pos = ftell(f);
+    fflush(f);
+    fseek(f, 0, SEEK_SET);
+
+    uint64_t hash = HashBytes(NULL, 0);
+    char buf[4096];
+    while(length > 0) {
+        size_t n = fread(buf, 1, std::min((size_t)length, sizeof(buf)), f);
+        if(n == 0) break;
+        hash = HashBytes(buf, n, hash);
+        length -= (long)n;
+    }
+
+    fseek(f, pos, SEEK_SET);
+    return hash;
+}
+
+static uint64_t HashGenerationInputs(uint64_t hash) {
+    hash = HashBytes(&SS.chordTol, sizeof(SS.chordTol), hash);
+    hash = HashBytes(&SS.maxSegments, sizeof(SS.maxSegments), hash);
+    for(Group &g : SK.group) {
+        if(g.type != Group::Type::LINKED) continue;
+
+        std::string data;
+        if(!ReadFile(g.linkFile, &data)) {
+            data = "missing";
+        }
+        hash = HashBytes(data.data(), data.size(), hash);
+    }
+    return hash;
+}
+
+//-----------------------------------------------------------------------------
+// The binary encoding of the same data as the text file. It's a magic string,
+// and then a sequence of sections, each a four-character tag and a 64-bit
+// length followed by that many bytes, so that a reader can skip any section
+// that it doesn't know; all numbers are little-endian. The KEYS section names
+// the fields that the records of the SKCH section refer to by index, so that
+// they're looked up once per file, not once per value.
+//-----------------------------------------------------------------------------
+#define BINARY_MAGIC "\261\262\263" "SolveSpaceBINa"
+
+static void WriteU8(std::string *out, uint8_t v) {
+    out->push_back((char)v);
+}
+static void WriteU32(std::string *out, uint32_t v) {
+    for(int i = 0; i < 4; i++) out->push_back((char)(v >> (8 * i)));
+}
+static void WriteU64(std::string *out, uint64_t v) {
+    for(int i = 0; i < 8; i++) out->push_back((char)(v >> (8 * i)));
+}
+static void WriteF64(std::string *out, double v) {
+    uint64_t u;
+    memcpy(&u, &v, sizeof(u));
+    WriteU64(out, u);
+}
+static void WriteVector(std::string *out, Vector v) {
+    WriteF64(out, v.x);
+    WriteF64(out, v.y);
+    WriteF64(out, v.z);
+}
+static void WriteString(std::string *out, const std::string &s) {
+    WriteU32(out, (uint32_t)s.size());
+    out->append(s);
+}
+
+static size_t BeginSection(std::string *out, const char *tag) {
+    out->append(tag, 4);
+    size_t lengthAt = out->size();
+    WriteU64(out, 0);
+    return lengthAt;
+}
+static void EndSection(std::string *out, size_t lengthAt) {
+    uint64_t length = out->size() - lengthAt - 8;
+    for(int i = 0; i < 8; i++) (*out)[lengthAt + i] = (char)(length >> (8 * i));
+}
+
+static void SaveBinaryRecord(std::string *out, const Platform::Path &filename, int type) {
+    WriteU8(out, (uint8_t)type);
+    size_t countAt = out->size();
+    WriteU32(out, 0);
+
+    uint32_t count = 0;
+    for(int i = 0; SolveSpaceUI::SAVED[i].type != 0; i++) {
+        if(SolveSpaceUI::SAVED[i].type != type) continue;
+
+        int fmt = SolveSpaceUI::SAVED[i].fmt;
+        SAVEDptr *p = (SAVEDptr *)SolveSpaceUI::SAVED[i].ptr;
+        if(IsSavedAsDefault(fmt, p)) continue;
+
+        // The KEYS section lists SAVED[] in order, so that's our index.
+        WriteU32(out, (uint32_t)i);
+        switch(fmt) {
+            case 'S': WriteString(out, p->S());                   break;
+            case 'P': WriteString(out, SavedPath(p->P(), filename)); break;
+            case 'b': WriteU8(out, p->b() ? 1 : 0);               break;
+            case 'c': WriteU32(out, p->c().ToPackedInt());        break;
+            case 'd': WriteU32(out, (uint32_t)p->d());            break;
+            case 'f': WriteF64(out, p->f());                      break;
+            case 'x': WriteU32(out, p->x());                      break;
+
+            case 'M': {
+                std::vector<std::pair<EntityKey, EntityId>> sorted = SortedRemap(p->M());
+                WriteU32(out, (uint32_t)sorted.size());
+                for(const auto &it : sorted) {
+                    WriteU32(out, it.second.v);
+                    WriteU32(out, it.first.input.v);
+                    WriteU32(out, (uint32_t)it.first.copyNumber);
+                }
+                break;
+            }
+
+            default: ssassert(false, "Unexpected value format");
+        }
+        count++;
+    }
+
+    for(int i = 0; i < 4; i++) (*out)[countAt + i] = (char)(count >> (8 * i));
+}
+
+// The mesh and shell of the last group, as generated from the sketch.
+static void SaveBinaryGeometry(std::string *out, Group *g) {
+    size_t section = BeginSection(out, "MESH");
+    WriteU32(out, (uint32_t)g->runningMesh.l.n);
+    for(const STriangle &tr : g->runningMesh.l) {
+        WriteU32(out, tr.meta.face);
+        WriteU32(out, tr.meta.color.ToPackedInt());
+        WriteVector(out, tr.a);
+        WriteVector(out, tr.b);
+        WriteVector(out, tr.c);
+    }
+    EndSection(out, section);
+
+    SShell *s = &g->runningShell;
+    section = BeginSection(out, "SHEL");
+    WriteU32(out, (uint32_t)s->surface.n);
+    for(SSurface &srf : s->surface) {
+        WriteU32(out, srf.h.v);
+        WriteU32(out, srf.color.ToPackedInt());
+        WriteU32(out, srf.face);
+        WriteU32(out, (uint32_t)srf.degm);
+        WriteU32(out, (uint32_t)srf.degn);
+        for(int i = 0; i <= srf.degm; i++) {
+            for(int j = 0; j <= srf.degn; j++) {
+                WriteVector(out, srf.ctrl[i][j]);
+                WriteF64(out, srf.weight[i][j]);
+            }
+        }
+        WriteU32(out, (uint32_t)srf.trim.n);
+        for(const STrimBy &stb : srf.trim) {
+            WriteU32(out, stb.curve.v);
+            WriteU8(out, stb.backwards ? 1 : 0);
+            WriteVector(out, stb.start);
+            WriteVector(out, stb.finish);
+        }
+    }
+    WriteU32(out, (uint32_t)s->curve.n);
+    for(SCurve &sc : s->curve) {
+        WriteU32(out, sc.h.v);
+        WriteU8(out, sc.isExact ? 1 : 0);
+        WriteU32(out, (uint32_t)sc.exact.deg);
+        WriteU32(out, sc.surfA.v);
+        WriteU32(out, sc.surfB.v);
+        if(sc.isExact) {
+            for(int i = 0; i <= sc.exact.deg; i++) {
+                WriteVector(out, sc.exact.ctrl[i]);
+                WriteF64(out, sc.exact.weight[i]);
+            }
+        }
+        WriteU32(out, (uint32_t)sc.pts.n);
+        for(const SCurvePt &scpt : sc.pts) {
+            WriteU8(out, scpt.vertex ? 1 : 0);
+            WriteVector(out, scpt.p);
+        }
+    }
+    EndSection(out, section);
+}
+
+static bool SaveToBinaryFile(const Platform::Path &filename) {
+    std::string out = BINARY_MAGIC;
+
+    size_t section = BeginSection(&out, "KEYS");
+    uint32_t keys = 0;
+    while(SolveSpaceUI::SAVED[keys].type != 0) keys++;
+    WriteU32(&out, keys);
+    for(uint32_t i = 0; i < keys; i++) {
+        WriteU8(&out, (uint8_t)SolveSpaceUI::SAVED[i].fmt);
+        WriteString(&out, SolveSpaceUI::SAVED[i].desc);
+    }
+    EndSection(&out, section);
+
+    section = BeginSection(&out, "SKCH");
+    for(auto &g : SK.group) {
+        SS.sv.g = g;
+        SaveBinaryRecord(&out, filename, 'g');
+    }
+    for(auto &p : SK.param) {
+        SS.sv.p = p;
+        SaveBinaryRecord(&out, filename, 'p');
+    }
+    for(auto &r : SK.request) {
+        SS.sv.r = r;
+        SaveBinaryRecord(&out, filename, 'r');
+    }
+    for(auto &e : SK.entity) {
+        e.CalculateNumerical(/*forExport=*/true);
+        SS.sv.e = e;
+        SaveBinaryRecord(&out, filename, 'e');
+    }
+    for(auto &c : SK.constraint) {
+        SS.sv.c = c;
+        SaveBinaryRecord(&out, filename, 'c');
+    }
+    for(auto &s : SK.style) {
+        SS.sv.s = s;
+        if(SS.sv.s.h.v >= Style::FIRST_CUSTOM) {
+            SaveBinaryRecord(&out, filename, 's');
+        }
+    }
+    EndSection(&out, section);
+
+    uint64_t inputHash = HashGenerationInputs(HashBytes(out.data(), out.size()));
+    section = BeginSection(&out, "HASH");
+    WriteU64(&out, inputHash);
+    EndSection(&out, section);
+
+    // A sketch always has groups, unless it failed to load.
+    if(!SK.groupOrder.IsEmpty()) {
+        SaveBinaryGeometry(&out, SK.GetGroup(*SK.groupOrder.Last()));
+    }
+
+    if(!WriteFile(filename, out)) {
+        Error("Couldn't write to file '%s'", filename.raw.c_str());
+        return false;
+    }
+    return true;
+}
+
 bool SolveSpaceUI::SaveToFile(const Platform::Path &filename) {
     // Make sure all the entities are regenerated up to date, since they will be exported.
     SS.ScheduleShowTW();
@@ -299,7 +571,12 @@ bool SolveSpaceUI::SaveToFile(const Platform::Path &filename) {
         }
     }
 
-    fh = OpenFile(filename, "wb");
+    if(saveBinaryFiles) {
+        return SaveToBinaryFile(filename);
+    }
+
+    // Opened for reading too, to hash what we write before the geometry.
+    fh = OpenFile(filename, "w+b");
     if(!fh) {
         Error("Couldn't write to file '%s'", filename.raw.c_str());
         return false;
@@ -347,6 +624,10 @@ bool SolveSpaceUI::SaveToFile(const Platform::Path &filename) {
         }
     }
 
+    uint64_t inputHash = HashGenerationInputs(HashFilePrefix(fh, ftell(fh)));
+    // Written like a key, so that older versions load the file anyways.
+    fprintf(fh, "InputHash=%016llx\n", (unsigned long long)inputHash);
+
     // A group will have either a mesh or a shell, but not both; but the code
     // to print either of those just does nothing if the mesh/shell is empty.
 
@@ -406,70 +687,824 @@ bool SolveSpaceUI::SaveToFile(const Platform::Path &filename) {
     return true;
 }
 
+//-----------------------------------------------------------------------------
+// Find the entry of SAVED[] with the given key. Comparing the key against
+// every entry in turn costs more than the rest of loading a big file, so the
+// keys are hashed into an open-addressed table, built the first time through
+// and sized so that a lookup rarely probes more than one slot.
+//-----------------------------------------------------------------------------
+static uint32_t HashKey(const char *key) {
+    uint32_t hash = 2166136261u;
+    for(; *key; key++) {
+        hash = (hash ^ (uint8_t)*key) * 16777619u;
+    }
+    return hash;
+}
+
+static int FindSavedKey(const char *key) {
+    static const std::vector<int> table = [] {
+        size_t count = 0;
+        while(SolveSpaceUI::SAVED[count].type != 0) count++;
+        size_t size = 1;
+        while(size < 4 * count) size *= 2;
+
+        std::vector<int> table(size, -1);
+        for(size_t i = 0; i < count; i++) {
+            size_t slot = HashKey(SolveSpaceUI::SAVED[i].desc) & (size - 1);
+            while(table[slot] >= 0) slot = (slot + 1) & (size - 1);
+            table[slot] = (int)i;
+        }
+        return table;
+    }();
+
+    size_t mask = table.size() - 1;
+    for(size_t slot = HashKey(key) & mask; table[slot] >= 0; slot = (slot + 1) & mask) {
+        if(strcmp(SolveSpaceUI::SAVED[table[slot]].desc, key) == 0) return table[slot];
+    }
+    return -1;
+}
+
+// The most significant 128 bits of 5^q, for q from POWER_OF_FIVE_MIN up, as
+// the Eisel-Lemire algorithm needs them; for q < 0, those of 1/5^-q, rounded up.
+static const int POWER_OF_FIVE_MIN = -32;
+static const uint64_t POWERS_OF_FIVE_128[][2] = {
+    { 0xcfb11ead453994ba, 0x67de18eda5814af2 }, // 5^-32
+    { 0x81ceb32c4b43fcf4, 0x80eacf948770ced7 }, // 5^-31
+    { 0xa2425ff75e14fc31, 0xa1258379a94d028d }, // 5^-30
+    { 0xcad2f7f5359a3b3e, 0x096ee45813a04330 }, // 5^-29
+    { 0xfd87b5f28300ca0d, 0x8bca9d6e188853fc }, // 5^-28
+    { 0x9e74d1b791e07e48, 0x775ea264cf55347e }, // 5^-27
+    { 0xc612062576589dda, 0x95364afe032a819e }, // 5^-26
+    { 0xf79687aed3eec551, 0x3a83ddbd83f52205 }, // 5^-25
+    { 0x9abe14cd44753b52, 0xc4926a9672793543 }, // 5^-24
+    { 0xc16d9a0095928a27, 0x75b7053c0f178294 }, // 5^-23
+    { 0xf1c90080baf72cb1, 0x5324c68b12dd6339 }, // 5^-22
+    { 0x971da05074da7bee, 0xd3f6fc16ebca5e04 }, // 5^-21
+    { 0xbce5086492111aea, 0x88f4bb1ca6bcf585 }, // 5^-20
+    { 0xec1e4a7db69561a5, 0x2b31e9e3d06c32e6 }, // 5^-19
+    { 0x9392ee8e921d5d07, 0x3aff322e62439fd0 }, // 5^-18
+    { 0xb877aa3236a4b449, 0x09befeb9fad487c3 }, // 5^-17
+    { 0xe69594bec44de15b, 0x4c2ebe687989a9b4 }, // 5^-16
+    { 0x901d7cf73ab0acd9, 0x0f9d37014bf60a11 }, // 5^-15
+    { 0xb424dc35095cd80f, 0x538484c19ef38c95 }, // 5^-14
+    { 0xe12e13424bb40e13, 0x2865a5f206b06fba }, // 5^-13
+    { 0x8cbccc096f5088cb, 0xf93f87b7442e45d4 }, // 5^-12
+    { 0xafebff0bcb24aafe, 0xf78f69a51539d749 }, // 5^-11
+    { 0xdbe6fecebdedd5be, 0xb573440e5a884d1c }, // 5^-10
+    { 0x89705f4136b4a597, 0x31680a88f8953031 }, // 5^-9
+    { 0xabcc77118461cefc, 0xfdc20d2b36ba7c3e }, // 5^-8
+    { 0xd6bf94d5e57a42bc, 0x3d32907604691b4d }, // 5^-7
+    { 0x8637bd05af6c69b5, 0xa63f9a49c2c1b110 }, // 5^-6
+    { 0xa7c5ac471b478423, 0x0fcf80dc33721d54 }, // 5^-5
+    { 0xd1b71758e219652b, 0xd3c36113404ea4a9 }, // 5^-4
+    { 0x83126e978d4fdf3b, 0x645a1cac083126ea }, // 5^-3
+    { 0xa3d70a3d70a3d70a, 0x3d70a3d70a3d70a4 }, // 5^-2
+    { 0xcccccccccccccccc, 0xcccccccccccccccd }, // 5^-1
+    { 0x8000000000000000, 0x0000000000000000 }, // 5^0
+    { 0xa000000000000000, 0x0000000000000000 }, // 5^1
+    { 0xc800000000000000, 0x0000000000000000 }, // 5^2
+    { 0xfa00000000000000, 0x0000000000000000 }, // 5^3
+    { 0x9c40000000000000, 0x0000000000000000 }, // 5^4
+    { 0xc350000000000000, 0x0000000000000000 }, // 5^5
+    { 0xf424000000000000, 0x0000000000000000 }, // 5^6
+    { 0x9896800000000000, 0x0000000000000000 }, // 5^7
+    { 0xbebc200000000000, 0x0000000000000000 }, // 5^8
+    { 0xee6b280000000000, 0x0000000000000000 }, // 5^9
+    { 0x9502f90000000000, 0x0000000000000000 }, // 5^10
+    { 0xba43b74000000000, 0x0000000000000000 }, // 5^11
+    { 0xe8d4a51000000000, 0x0000000000000000 }, // 5^12
+    { 0x9184e72a00000000, 0x0000000000000000 }, // 5^13
+    { 0xb5e620f480000000, 0x0000000000000000 }, // 5^14
+    { 0xe35fa931a0000000, 0x0000000000000000 }, // 5^15
+    { 0x8e1bc9bf04000000, 0x0000000000000000 }, // 5^16
+    { 0xb1a2bc2ec5000000, 0x0000000000000000 }, // 5^17
+    { 0xde0b6b3a76400000, 0x0000000000000000 }, // 5^18
+    { 0x8ac7230489e80000, 0x0000000000000000 }, // 5^19
+    { 0xad78ebc5ac620000, 0x0000000000000000 }, // 5^20
+    { 0xd8d726b7177a8000, 0x0000000000000000 }, // 5^21
+    { 0x878678326eac9000, 0x0000000000000000 }, // 5^22
+    { 0xa968163f0a57b400, 0x0000000000000000 }, // 5^23
+    { 0xd3c21bcecceda100, 0x0000000000000000 }, // 5^24
+    { 0x84595161401484a0, 0x0000000000000000 }, // 5^25
+    { 0xa56fa5b99019a5c8, 0x0000000000000000 }, // 5^26
+    { 0xcecb8f27f4200f3a, 0x0000000000000000 }, // 5^27
+    { 0x813f3978f8940984, 0x4000000000000000 }, // 5^28
+    { 0xa18f07d736b90be5, 0x5000000000000000 }, // 5^29
+    { 0xc9f2c9cd04674ede, 0xa400000000000000 }, // 5^30
+    { 0xfc6f7c4045812296, 0x4d00000000000000 }, // 5^31
+    { 0x9dc5ada82b70b59d, 0xf020000000000000 }, // 5^32
+};
+
+static void Multiply64x64(uint64_t a, uint64_t b, uint64_t *hi, uint64_t *lo) {
+    uint64_t ll = (a & 0xffffffff) * (b & 0xffffffff),
+             lh = (a & 0xffffffff) * (b >> 32),
+             hl = (a >> 32) * (b & 0xffffffff),
+             hh = (a >> 32) * (b >> 32);
+    uint64_t mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+    *lo = (mid << 32) | (ll & 0xffffffff);
+    *hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+}
+
+// Round w*10^q to the nearest double, by the Eisel-Lemire algorithm. Returns
+// false when q is outside our table, or the result would be subnormal or
+// infinite; the caller must then take the slow path.
+static bool EiselLemire(uint64_t w, int q, double *result) {
+    if(w == 0) {
+        *result = 0;
+        return true;
+    }
+    int index = q - POWER_OF_FIVE_MIN;
+    if(index < 0 || index >= (int)(sizeof(POWERS_OF_FIVE_128) / sizeof(POWERS_OF_FIVE_128[0]))) {
+        return false;
+    }
+
+    int lz = 0;
+    for(int step = 32; step > 0; step /= 2) {
+        if(!(w >> (64 - step))) {
+            w <<= step;
+            lz += step;
+        }
+    }
+
+    // The first 128 bits of the product; we need 55 bits (the mantissa, plus
+    // one to round, plus one for where the leading bit lands) to be certain,
+    // and use the lower half of the power only when they might not be.
+    uint64_t hi, lo;
+    Multiply64x64(w, POWERS_OF_FIVE_128[index][0], &hi, &lo);
+    const uint64_t PRECISION_MASK = ~0ull >> 55;
+    if((hi & PRECISION_MASK) == PRECISION_MASK) {
+        uint64_t hi2, lo2;
+        Multiply64x64(w, POWERS_OF_FIVE_128[index][1], &hi2, &lo2);
+        lo += hi2;
+        if(hi2 > lo) hi++;
+    }
+
+    int upperBit = (int)(hi >> 63);
+    int shift    = upperBit + 9;
+    uint64_t mantissa = hi >> shift;
+    // floor(q*log2(10)) + 63, plus the IEEE bias
+    int power2 = ((217706 * q) >> 16) + 63 + upperBit - lz + 1023;
+    if(power2 <= 0 || power2 >= 2047) return false;
+
+    // Round half to even; an exact tie is only possible for small q.
+    if(lo <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == hi) {
+        mantissa &= ~1ull;
+    }
+    mantissa += (mantissa & 1);
+    mantissa >>= 1;
+    if(mantissa >= (2ull << 52)) {
+        mantissa = (1ull << 52);
+        power2++;
+        if(power2 >= 2047) return false;
+    }
+    mantissa &= ~(1ull << 52);
+
+    uint64_t bits = mantissa | ((uint64_t)power2 << 52);
+    memcpy(result, &bits, sizeof(bits));
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Parse a number as written by "%.20f", correctly rounded and without regard
+// to the locale. Printing twenty decimals writes out more of the binary value
+// than a double holds, so most of these have more than the 19 significant
+// digits that fit in a uint64_t. We keep the first 19, and convert both that
+// and that plus one unit in its last place with Eisel-Lemire; the true value
+// lies between them, so if they round to the same double then so does it.
+// Short numbers that are exact in a double just need one exact multiply or
+// divide. Anything else goes through strtod, with the decimal point spelled
+// the way the current locale expects it.
+//-----------------------------------------------------------------------------
+static double ParseDouble(const char *str) {
+    static const double POWERS_OF_TEN[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    const char *p = str;
+    bool negative = (*p == '-');
+    if(*p == '-' || *p == '+') p++;
+
+    uint64_t mantissa = 0;
+    int digits   = 0,    // significant digits in the mantissa
+        zeros    = 0,    // digits since the last one in it, taken as zeros
+        exponent = 0;
+    bool fraction = false, any = false, truncated = false;
+    for(;; p++) {
+        if(*p == '.' && !fraction) {
+            fraction = true;
+            continue;
+        }
+        if(*p < '0' || *p > '9') break;
+        any = true;
+        if(fraction) exponent--;
+        if(*p == '0') {
+            if(digits > 0) zeros++;
+            continue;
+        }
+        if(truncated || digits + zeros + 1 > 19) {
+            truncated = true;
+            zeros++;
+            continue;
+        }
+        for(; zeros > 0; zeros--, digits++) mantissa *= 10;
+        mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+        digits++;
+    }
+    exponent += zeros;
+
+    if(any && *p == '\0') {
+        double value, upper;
+        if(!truncated && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22) {
+            value = (double)mantissa;
+            if(exponent < 0) {
+                value /= POWERS_OF_TEN[-exponent];
+            } else {
+                value *= POWERS_OF_TEN[exponent];
+            }
+            return negative ? -value : value;
+        }
+        if(EiselLemire(mantissa, exponent, &value) &&
+           (!truncated || (EiselLemire(mantissa + 1, exponent, &upper) && EXACT(value == upper)))) {
+            return negative ? -value : value;
+        }
+    }
+
+    // Our lines are read into a fixed buffer, so this one is always enough.
+    char copy[1024];
+    char point = *localeconv()->decimal_point;
+    size_t i;
+    for(i = 0; str[i] != '\0' && i < sizeof(copy) - 1; i++) {
+        copy[i] = (str[i] == '.') ? point : str[i];
+    }
+    copy[i] = '\0';
+    return strtod(copy, NULL);
+}
+
 void SolveSpaceUI::LoadUsingTable(const Platform::Path &filename, char *key, char *val) {
-    int i;
-    for(i = 0; SAVED[i].type != 0; i++) {
-        if(strcmp(SAVED[i].desc, key)==0) {
-            SAVEDptr *p = (SAVEDptr *)SAVED[i].ptr;
-            unsigned int u = 0;
-            switch(SAVED[i].fmt) {
-                case 'S': p->S() = val;                     break;
-                case 'b': p->b() = (atoi(val) != 0);        break;
-                case 'd': p->d() = atoi(val);               break;
-                case 'f': p->f() = atof(val);               break;
-                case 'x': sscanf(val, "%x", &u); p->x()= u; break;
-
-                case 'P': {
-                    Platform::Path path = Platform::Path::FromPortable(val);
-                    if(!path.IsEmpty()) {
-                        p->P() = filename.Parent().Join(path).Expand();
-                    }
-                    break;
-                }
+    int i = FindSavedKey(key);
+    if(i < 0) {
+        fileLoadError = true;
+        return;
+    }
 
-                case 'c':
-                    sscanf(val, "%x", &u);
-                    p->c() = RgbaColor::FromPackedInt(u);
-                    break;
+    SAVEDptr *p = (SAVEDptr *)SAVED[i].ptr;
+    switch(SAVED[i].fmt) {
+        case 'S': p->S() = val;                               break;
+        case 'b': p->b() = (atoi(val) != 0);                  break;
+        case 'd': p->d() = atoi(val);                         break;
+        case 'f': p->f() = ParseDouble(val);                  break;
+        case 'x': p->x() = (uint32_t)strtoul(val, NULL, 16);  break;
+
+        case 'P': {
+            Platform::Path path = Platform::Path::FromPortable(val);
+            if(!path.IsEmpty()) {
+                p->P() = filename.Parent().Join(path).Expand();
+            }
+            break;
+        }
+
+        case 'c':
+            p->c() = RgbaColor::FromPackedInt((uint32_t)strtoul(val, NULL, 16));
+            break;
 
-                case 'M': {
-                    p->M().clear();
-                    for(;;) {
-                        EntityKey ek;
-                        EntityId ei;
-                        char line2[1024];
-                        if (fgets(line2, (int)sizeof(line2), fh) == NULL)
-                            break;
-                        if(sscanf(line2, "%d %x %d", &(ei.v), &(ek.input.v),
-                                                     &(ek.copyNumber)) == 3) {
-                            if(ei.v == Entity::NO_ENTITY.v) {
-                                // Commit bd84bc1a mistakenly introduced code that would remap
-                                // some entities to NO_ENTITY. This was fixed in commit bd84bc1a,
-                                // but files created meanwhile are corrupt, and can cause crashes.
-                                //
-                                // To fix this, we skip any such remaps when loading; they will be
-                                // recreated on the next regeneration. Any resulting orphans will
-                                // be pruned in the usual way, recovering to a well-defined state.
-                                continue;
-                            }
-                            p->M().insert({ ek, ei });
-                        } else {
-                            break;
-                        }
+        case 'M': {
+            p->M().clear();
+            for(;;) {
+                EntityKey ek;
+                EntityId ei;
+                char line2[1024];
+                if (fgets(line2, (int)sizeof(line2), fh) == NULL)
+                    break;
+                if(sscanf(line2, "%d %x %d", &(ei.v), &(ek.input.v),
+                                             &(ek.copyNumber)) == 3) {
+                    if(ei.v == Entity::NO_ENTITY.v) {
+                        // Commit bd84bc1a mistakenly introduced code that would remap
+                        // some entities to NO_ENTITY. This was fixed in commit bd84bc1a,
+                        // but files created meanwhile are corrupt, and can cause crashes.
+                        //
+                        // To fix this, we skip any such remaps when loading; they will be
+                        // recreated on the next regeneration. Any resulting orphans will
+                        // be pruned in the usual way, recovering to a well-defined state.
+                        continue;
                     }
+                    p->M().insert({ ek, ei });
+                } else {
                     break;
                 }
+            }
+            break;
+        }
+
+        case 'i': break;
+
+        default: ssassert(false, "Unexpected value format");
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Parse one record of the mesh or shell that is saved after the sketch, into
+// m and sh; srf and crv accumulate the surface or curve being read. Returns
+// false if the line isn't such a record; and sets *malformed if it is, but
+// can't be parsed.
+//-----------------------------------------------------------------------------
+static bool LoadShellOrMeshRecord(const char *line, SMesh *m, SShell *sh,
+                                  SSurface *srf, SCurve *crv, bool *malformed)
+{
+    *malformed = false;
+    if(StrStartsWith(line, "Triangle ")) {
+        STriangle tr = {};
+        unsigned int rgba = 0;
+        if(sscanf(line, "Triangle %x %x  "
+                         "%lf %lf %lf  %lf %lf %lf  %lf %lf %lf",
+            &(tr.meta.face), &rgba,
+            &(tr.a.x), &(tr.a.y), &(tr.a.z),
+            &(tr.b.x), &(tr.b.y), &(tr.b.z),
+            &(tr.c.x), &(tr.c.y), &(tr.c.z)) != 11) {
+            *malformed = true;
+            return true;
+        }
+        tr.meta.color = RgbaColor::FromPackedInt((uint32_t)rgba);
+        m->AddTriangle(&tr);
+    } else if(StrStartsWith(line, "Surface ")) {
+        unsigned int rgba = 0;
+        if(sscanf(line, "Surface %x %x %x %d %d",
+            &(srf->h.v), &rgba, &(srf->face),
+            &(srf->degm), &(srf->degn)) != 5 ||
+           srf->degm < 1 || srf->degm > 3 || srf->degn < 1 || srf->degn > 3) {
+            *malformed = true;
+            return true;
+        }
+        srf->color = RgbaColor::FromPackedInt((uint32_t)rgba);
+    } else if(StrStartsWith(line, "SCtrl ")) {
+        int i, j;
+        Vector c;
+        double w;
+        if(sscanf(line, "SCtrl %d %d %lf %lf %lf Weight %lf",
+                            &i, &j, &(c.x), &(c.y), &(c.z), &w) != 6 ||
+           i < 0 || i > 3 || j < 0 || j > 3)
+        {
+            *malformed = true;
+            return true;
+        }
+        srf->ctrl[i][j] = c;
+        srf->weight[i][j] = w;
+    } else if(StrStartsWith(line, "TrimBy ")) {
+        STrimBy stb = {};
+        int backwards;
+        if(sscanf(line, "TrimBy %x %d  %lf %lf %lf  %lf %lf %lf",
+            &(stb.curve.v), &backwards,
+            &(stb.start.x), &(stb.start.y), &(stb.start.z),
+            &(stb.finish.x), &(stb.finish.y), &(stb.finish.z)) != 8)
+        {
+            *malformed = true;
+            return true;
+        }
+        stb.backwards = (backwards != 0);
+        srf->trim.Add(&stb);
+    } else if(strcmp(line, "AddSurface")==0) {
+        sh->surface.Add(srf);
+        *srf = {};
+    } else if(StrStartsWith(line, "Curve ")) {
+        int isExact;
+        if(sscanf(line, "Curve %x %d %d %x %x",
+            &(crv->h.v),
+            &(isExact),
+            &(crv->exact.deg),
+            &(crv->surfA.v), &(crv->surfB.v)) != 5 ||
+           crv->exact.deg < 0 || crv->exact.deg > 3)
+        {
+            *malformed = true;
+            return true;
+        }
+        crv->isExact = (isExact != 0);
+    } else if(StrStartsWith(line, "CCtrl ")) {
+        int i;
+        Vector c;
+        double w;
+        if(sscanf(line, "CCtrl %d %lf %lf %lf Weight %lf",
+                            &i, &(c.x), &(c.y), &(c.z), &w) != 5 ||
+           i < 0 || i > 3)
+        {
+            *malformed = true;
+            return true;
+        }
+        crv->exact.ctrl[i] = c;
+        crv->exact.weight[i] = w;
+    } else if(StrStartsWith(line, "CurvePt ")) {
+        SCurvePt scpt;
+        int vertex;
+        if(sscanf(line, "CurvePt %d %lf %lf %lf",
+            &vertex,
+            &(scpt.p.x), &(scpt.p.y), &(scpt.p.z)) != 4)
+        {
+            *malformed = true;
+            return true;
+        }
+        scpt.vertex = (vertex != 0);
+        crv->pts.Add(&scpt);
+    } else if(strcmp(line, "AddCurve")==0) {
+        sh->curve.Add(crv);
+        *crv = {};
+    } else {
+        return false;
+    }
+    return true;
+}
 
-                case 'i': break;
+//-----------------------------------------------------------------------------
+// What's read from a file besides the sketch: the mesh and shell that were
+// saved with it, if they're hashed, so that we can tell whether they're still
+// what we would regenerate.
+//-----------------------------------------------------------------------------
+struct SavedGeometry {
+    bool        inputHashFound;
+    uint64_t    inputHash;
+    uint64_t    savedInputHash;
+    SMesh       mesh;
+    SShell      shell;
+};
+
+// Add the record read into SS.sv to the sketch; returns false if the type of
+// record is unknown.
+static bool AddLoadedRecord(int type) {
+    switch(type) {
+        case 'g':
+            // legacy files have a spurious dependency between linked groups
+            // and their parent groups, remove
+            if(SS.sv.g.type == Group::Type::LINKED)
+                SS.sv.g.opA.v = 0;
 
-                default: ssassert(false, "Unexpected value format");
+            SK.group.Add(&(SS.sv.g));
+            SS.sv.g = {};
+            SS.sv.g.scale = 1; // default is 1, not 0; so legacy files need this
+            return true;
+
+        case 'p':
+            // params are regenerated, but we want to preload the values
+            // for initial guesses
+            SK.param.Add(&(SS.sv.p));
+            SS.sv.p = {};
+            return true;
+
+        case 'e':
+            // entities are regenerated
+            SS.sv.e = {};
+            return true;
+
+        case 'r':
+            SK.request.Add(&(SS.sv.r));
+            SS.sv.r = {};
+            return true;
+
+        case 'c':
+            SK.constraint.Add(&(SS.sv.c));
+            SS.sv.c = {};
+            return true;
+
+        case 's':
+            SK.style.Add(&(SS.sv.s));
+            SS.sv.s = {};
+            Style::FillDefaultStyle(&SS.sv.s);
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+// Add the record read into SS.sv to a linked part; only its entities and
+// styles are kept. Returns false if the type of record is unknown.
+static bool AddLinkedRecord(int type, LinkedPart *lp) {
+    switch(type) {
+        case 'g': SS.sv.g = {}; return true;
+        case 'p': SS.sv.p = {}; return true;
+        case 'r': SS.sv.r = {}; return true;
+        case 'c': SS.sv.c = {}; return true;
+
+        case 'e':
+            lp->entity.Add(&(SS.sv.e));
+            SS.sv.e = {};
+            return true;
+
+        case 's':
+            // Imported by the groups that link this file, if we don't
+            // have it yet.
+            lp->style.Add(&(SS.sv.s));
+            SS.sv.s = {};
+            Style::FillDefaultStyle(&SS.sv.s);
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+class BinaryReader {
+public:
+    const uint8_t   *p;
+    const uint8_t   *end;
+    bool            ok;
+
+    BinaryReader(const void *data, size_t size) :
+        p((const uint8_t *)data), end((const uint8_t *)data + size), ok(true) {}
+
+    bool AtEnd() const { return !ok || p >= end; }
+
+    const uint8_t *Take(size_t n) {
+        if(!ok || (size_t)(end - p) < n) {
+            ok = false;
+            return NULL;
+        }
+        const uint8_t *at = p;
+        p += n;
+        return at;
+    }
+
+    uint8_t U8() {
+        const uint8_t *at = Take(1);
+        return at ? at[0] : 0;
+    }
+    uint32_t U32() {
+        const uint8_t *at = Take(4);
+        uint32_t v = 0;
+        for(int i = 0; at && i < 4; i++) v |= (uint32_t)at[i] << (8 * i);
+        return v;
+    }
+    uint64_t U64() {
+        const uint8_t *at = Take(8);
+        uint64_t v = 0;
+        for(int i = 0; at && i < 8; i++) v |= (uint64_t)at[i] << (8 * i);
+        return v;
+    }
+    double F64() {
+        uint64_t u = U64();
+        double v;
+        memcpy(&v, &u, sizeof(v));
+        return v;
+    }
+    Vector Vec() {
+        Vector v;
+        v.x = F64();
+        v.y = F64();
+        v.z = F64();
+        return v;
+    }
+    std::string String() {
+        uint32_t n = U32();
+        const uint8_t *at = Take(n);
+        return at ? std::string((const char *)at, n) : std::string();
+    }
+};
+
+// Read one value in the given format; and store it, unless p is NULL because
+// we don't know the field.
+static void LoadBinaryValue(BinaryReader *r, const Platform::Path &filename,
+                            int fmt, SAVEDptr *p) {
+    switch(fmt) {
+        case 'S': {
+            std::string v = r->String();
+            if(p) p->S() = v;
+            break;
+        }
+        case 'P': {
+            Platform::Path path = Platform::Path::FromPortable(r->String());
+            if(p && !path.IsEmpty()) {
+                p->P() = filename.Parent().Join(path).Expand();
             }
             break;
         }
+        case 'b': { bool v = (r->U8() != 0);                        if(p) p->b() = v; break; }
+        case 'c': { RgbaColor v = RgbaColor::FromPackedInt(r->U32()); if(p) p->c() = v; break; }
+        case 'd': { int v = (int)r->U32();                          if(p) p->d() = v; break; }
+        case 'f': { double v = r->F64();                            if(p) p->f() = v; break; }
+        case 'x': { uint32_t v = r->U32();                          if(p) p->x() = v; break; }
+
+        case 'M': {
+            if(p) p->M().clear();
+            uint32_t n = r->U32();
+            for(uint32_t i = 0; i < n && r->ok; i++) {
+                EntityKey ek;
+                EntityId ei;
+                ei.v = r->U32();
+                ek.input.v = r->U32();
+                ek.copyNumber = (int)r->U32();
+                // See the text format; these are corrupt, and get recreated.
+                if(ei.v == Entity::NO_ENTITY.v) continue;
+                if(p) p->M().insert({ ek, ei });
+            }
+            break;
+        }
+
+        default:
+            r->ok = false;
+            break;
     }
-    if(SAVED[i].type == 0) {
-        fileLoadError = true;
+}
+
+static bool LoadShellFromBinary(BinaryReader *r, SShell *sh) {
+    uint32_t surfaces = r->U32();
+    for(uint32_t k = 0; k < surfaces && r->ok; k++) {
+        SSurface srf = {};
+        srf.h.v   = r->U32();
+        srf.color = RgbaColor::FromPackedInt(r->U32());
+        srf.face  = r->U32();
+        srf.degm  = (int)r->U32();
+        srf.degn  = (int)r->U32();
+        if(srf.degm < 1 || srf.degm > 3 || srf.degn < 1 || srf.degn > 3) {
+            r->ok = false;
+            return false;
+        }
+        for(int i = 0; i <= srf.degm; i++) {
+            for(int j = 0; j <= srf.degn; j++) {
+                srf.ctrl[i][j]   = r->Vec();
+                srf.weight[i][j] = r->F64();
+            }
+        }
+        uint32_t trims = r->U32();
+        for(uint32_t i = 0; i < trims && r->ok; i++) {
+            STrimBy stb = {};
+            stb.curve.v   = r->U32();
+            stb.backwards = (r->U8() != 0);
+            stb.start     = r->Vec();
+            stb.finish    = r->Vec();
+            srf.trim.Add(&stb);
+        }
+        sh->surface.Add(&srf);
+    }
+
+    uint32_t curves = r->U32();
+    for(uint32_t k = 0; k < curves && r->ok; k++) {
+        SCurve crv = {};
+        crv.h.v       = r->U32();
+        crv.isExact   = (r->U8() != 0);
+        crv.exact.deg = (int)r->U32();
+        crv.surfA.v   = r->U32();
+        crv.surfB.v   = r->U32();
+        if(crv.exact.deg < 0 || crv.exact.deg > 3) {
+            r->ok = false;
+            return false;
+        }
+        if(crv.isExact) {
+            for(int i = 0; i <= crv.exact.deg; i++) {
+                crv.exact.ctrl[i]   = r->Vec();
+                crv.exact.weight[i] = r->F64();
+            }
+        }
+        uint32_t pts = r->U32();
+        for(uint32_t i = 0; i < pts && r->ok; i++) {
+            SCurvePt scpt;
+            scpt.vertex = (r->U8() != 0);
+            scpt.p      = r->Vec();
+            crv.pts.Add(&scpt);
+        }
+        sh->curve.Add(&crv);
+    }
+    return r->ok;
+}
+
+// Load a file in the binary encoding into the sketch, and the geometry saved
+// with it into saved; or, if lp isn't NULL, load it as a linked part instead,
+// with the geometry whether or not it's up to date. Returns false if it's
+// malformed; except for the saved geometry of a sketch, which is then just
+// dropped, to be regenerated.
+static bool LoadFromBinaryFile(const Platform::Path &filename, SavedGeometry *saved,
+                               LinkedPart *lp = NULL) {
+    std::string data;
+    if(!ReadFile(filename, &data)) return false;
+
+    size_t magicLength = strlen(BINARY_MAGIC);
+    BinaryReader r(data.data() + magicLength, data.size() - magicLength);
+
+    // For each of the file's keys, its index in SAVED[], or -1 if we don't
+    // know it; and the format that it's stored in.
+    std::vector<int> keyIndex;
+    std::vector<int> keyFormat;
+
+    while(!r.AtEnd()) {
+        size_t sectionStart = (size_t)((const char *)r.p - data.data());
+        const uint8_t *tag = r.Take(4);
+        uint64_t length = r.U64();
+        const uint8_t *at = r.Take((size_t)length);
+        if(!r.ok) return false;
+
+        BinaryReader s(at, (size_t)length);
+        if(memcmp(tag, "KEYS", 4) == 0) {
+            uint32_t n = s.U32();
+            for(uint32_t k = 0; k < n && s.ok; k++) {
+                int fmt = s.U8();
+                std::string desc = s.String();
+                int index = FindSavedKey(desc.c_str());
+                if(index >= 0 && SolveSpaceUI::SAVED[index].fmt != fmt) index = -1;
+                keyIndex.push_back(index);
+                keyFormat.push_back(fmt);
+            }
+        } else if(memcmp(tag, "SKCH", 4) == 0) {
+            while(!s.AtEnd()) {
+                int type = s.U8();
+                uint32_t n = s.U32();
+                for(uint32_t k = 0; k < n && s.ok; k++) {
+                    uint32_t key = s.U32();
+                    if(key >= keyIndex.size()) return false;
+
+                    SAVEDptr *p = NULL;
+                    if(keyIndex[key] >= 0) {
+                        p = (SAVEDptr *)SolveSpaceUI::SAVED[keyIndex[key]].ptr;
+                    } else {
+                        SS.fileLoadError = true;
+                    }
+                    LoadBinaryValue(&s, filename, keyFormat[key], p);
+                }
+                if(s.ok && !(lp ? AddLinkedRecord(type, lp) : AddLoadedRecord(type))) {
+                    SS.fileLoadError = true;
+                }
+            }
+        } else if(memcmp(tag, "HASH", 4) == 0 && !lp) {
+            saved->inputHashFound = true;
+            saved->inputHash = HashBytes(data.data(), sectionStart);
+            saved->savedInputHash = s.U64();
+        } else if(memcmp(tag, "MESH", 4) == 0 && (lp || saved->inputHashFound)) {
+            SMesh *m = lp ? &lp->mesh : &saved->mesh;
+            uint32_t n = s.U32();
+            for(uint32_t k = 0; k < n && s.ok; k++) {
+                STriangle tr = {};
+                tr.meta.face  = s.U32();
+                tr.meta.color = RgbaColor::FromPackedInt(s.U32());
+                tr.a = s.Vec();
+                tr.b = s.Vec();
+                tr.c = s.Vec();
+                m->AddTriangle(&tr);
+            }
+        } else if(memcmp(tag, "SHEL", 4) == 0 && (lp || saved->inputHashFound)) {
+            LoadShellFromBinary(&s, lp ? &lp->shell : &saved->shell);
+        } else {
+            // A section from a newer version, or geometry that we regenerate
+            // anyways; skip it.
+        }
+        if(!s.ok) {
+            bool geometry = memcmp(tag, "MESH", 4) == 0 || memcmp(tag, "SHEL", 4) == 0;
+            if(lp || !geometry) return false;
+            // The geometry is damaged, but we can regenerate it.
+            saved->inputHashFound = false;
+            saved->mesh.Clear();
+            saved->shell.Clear();
+        }
     }
+    return r.ok;
+}
+
+static bool IsBinaryFile(FILE *f) {
+    char magic[sizeof(BINARY_MAGIC) - 1];
+    bool binary = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+                  memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+    fseek(f, 0, SEEK_SET);
+    return binary;
+}
+
+// What's common to loading either encoding, once the sketch is read.
+static bool FinishLoading(const Platform::Path &filename, bool canCancel, bool fileIsEmpty,
+                          SavedGeometry *saved) {
+    if(fileIsEmpty) {
+        Error(_("The file is empty. It may be corrupt."));
+        SS.NewFile();
+    }
+
+    if(SS.fileLoadError) {
+        Error(_("Unrecognized data in file. This file may be corrupt, or "
+                "from a newer version of the program."));
+        // At least leave the program in a non-crashing state.
+        if(SK.group.IsEmpty()) {
+            SS.NewFile();
+        }
+    }
+    if(!SS.ReloadAllLinked(filename, canCancel)) {
+        saved->mesh.Clear();
+        saved->shell.Clear();
+        return false;
+    }
+    SS.UpgradeLegacyData();
+
+    // If nothing that the geometry was generated from has changed since it
+    // was saved, then install it as the running shell and mesh of the last
+    // group, and let AfterNewFile() skip generating the shells.
+    if(saved->inputHashFound && !SS.fileLoadError && !SK.group.IsEmpty() &&
+       HashGenerationInputs(saved->inputHash) == saved->savedInputHash) {
+        Group *last = NULL;
+        for(Group &g : SK.group) {
+            if(last == NULL || g.order > last->order) last = &g;
+        }
+        last->runningMesh.Clear();
+        last->runningMesh = saved->mesh;
+        last->runningShell.Clear();
+        last->runningShell = saved->shell;
+        last->displayDirty = true;
+        SS.useSavedGeometry = true;
+    } else {
+        saved->mesh.Clear();
+        saved->shell.Clear();
+    }
+
+    return true;
 }
 
 bool SolveSpaceUI::LoadFromFile(const Platform::Path &filename, bool canCancel) {
@@ -489,7 +1524,21 @@ bool SolveSpaceUI::LoadFromFile(const Platform::Path &filename, bool canCancel)
     sv.g.scale = 1; // default is 1, not 0; so legacy files need this
     Style::FillDefaultStyle(&sv.s);
 
+    SavedGeometry saved = {};
+    if(IsBinaryFile(fh)) {
+        fclose(fh);
+        if(!LoadFromBinaryFile(filename, &saved)) {
+            fileLoadError = true;
+        }
+        return FinishLoading(filename, canCancel, /*fileIsEmpty=*/false, &saved);
+    }
+
+    SSurface srf = {};
+    SCurve crv = {};
+    bool malformed;
+
     char line[1024];
+    long lineStart = ftell(fh);
     while(fgets(line, (int)sizeof(line), fh)) {
         fileIsEmpty = false;
 
@@ -506,35 +1555,46 @@ bool SolveSpaceUI::LoadFromFile(const Platform::Path &filename, bool canCancel)
         if(e) {
             *e = '\0';
             char *key = line, *val = e+1;
-            LoadUsingTable(filename, key, val);
+            if(strcmp(key, "InputHash")==0) {
+                unsigned long long u = 0;
+                if(sscanf(val, "%llx", &u) == 1) {
+                    saved.inputHashFound = true;
+                    saved.inputHash = HashFilePrefix(fh, lineStart);
+                    saved.savedInputHash = (uint64_t)u;
+                } else {
+                    fileLoadError = true;
+                }
+            } else {
+                LoadUsingTable(filename, key, val);
+            }
         } else if(strcmp(line, "AddGroup")==0) {
-            // legacy files have a spurious dependency between linked groups
-            // and their parent groups, remove
-            if(sv.g.type == Group::Type::LINKED)
-                sv.g.opA.v = 0;
-
-            SK.group.Add(&(sv.g));
-            sv.g = {};
-            sv.g.scale = 1; // default is 1, not 0; so legacy files need this
+            AddLoadedRecord('g');
         } else if(strcmp(line, "AddParam")==0) {
-            // params are regenerated, but we want to preload the values
-            // for initial guesses
-            SK.param.Add(&(sv.p));
-            sv.p = {};
+            AddLoadedRecord('p');
         } else if(strcmp(line, "AddEntity")==0) {
-            // entities are regenerated
+            AddLoadedRecord('e');
         } else if(strcmp(line, "AddRequest")==0) {
-            SK.request.Add(&(sv.r));
-            sv.r = {};
+            AddLoadedRecord('r');
         } else if(strcmp(line, "AddConstraint")==0) {
-            SK.constraint.Add(&(sv.c));
-            sv.c = {};
+            AddLoadedRecord('c');
         } else if(strcmp(line, "AddStyle")==0) {
-            SK.style.Add(&(sv.s));
-            sv.s = {};
-            Style::FillDefaultStyle(&sv.s);
+            AddLoadedRecord('s');
         } else if(strcmp(line, VERSION_STRING)==0) {
             // do nothing, version string
+        } else if(saved.inputHashFound &&
+                  LoadShellOrMeshRecord(line, &saved.mesh, &saved.shell, &srf, &crv,
+                                        &malformed)) {
+            // the mesh or shell, which we may not need to regenerate; unless
+            // it's damaged, and then we regenerate it after all
+            if(malformed) {
+                saved.inputHashFound = false;
+                saved.mesh.Clear();
+                saved.shell.Clear();
+                srf.Clear();
+                crv.Clear();
+                srf = {};
+                crv = {};
+            }
         } else if(StrStartsWith(line, "Triangle ")      ||
                   StrStartsWith(line, "Surface ")       ||
                   StrStartsWith(line, "SCtrl ")         ||
@@ -549,29 +1609,12 @@ bool SolveSpaceUI::LoadFromFile(const Platform::Path &filename, bool canCancel)
         } else {
             fileLoadError = true;
         }
+        lineStart = ftell(fh);
     }
 
     fclose(fh);
 
-    if(fileIsEmpty) {
-        Error(_("The file is empty. It may be corrupt."));
-        NewFile();
-    }
-
-    if(fileLoadError) {
-        Error(_("Unrecognized data in file. This file may be corrupt, or "
-                "from a newer version of the program."));
-        // At least leave the program in a non-crashing state.
-        if(SK.group.IsEmpty()) {
-            NewFile();
-        }
-    }
-    if(!ReloadAllLinked(filename, canCancel)) {
-        return false;
-    }
-    UpgradeLegacyData();
-
-    return true;
+    return FinishLoading(filename, canCancel, fileIsEmpty, &saved);
 }
 
 void SolveSpaceUI::UpgradeLegacyData() {
@@ -713,9 +1756,10 @@ void SolveSpaceUI::UpgradeLegacyData() {
     oldParam.Clear();
 }
 
-bool SolveSpaceUI::LoadEntitiesFromFile(const Platform::Path &filename, EntityList *le,
-                                        SMesh *m, SShell *sh)
-{
+bool SolveSpaceUI::LoadEntitiesFromFile(const Platform::Path &filename, LinkedPart *lp) {
+    EntityList *le = &lp->entity;
+    SMesh *m = &lp->mesh;
+    SShell *sh = &lp->shell;
     if(strcmp(filename.Extension().c_str(), "emn")==0) {
         return LinkIDF(filename, le, m, sh);
     } else if(strcmp(filename.Extension().c_str(), "EMN")==0) {
@@ -725,15 +1769,17 @@ bool SolveSpaceUI::LoadEntitiesFromFile(const Platform::Path &filename, EntityLi
     } else if(strcmp(filename.Extension().c_str(), "STL")==0) {
         return LinkStl(filename, le, m, sh);    
     } else {
-        return LoadEntitiesFromSlvs(filename, le, m, sh);
+        return LoadEntitiesFromSlvs(filename, lp);
     }
 }
 
-bool SolveSpaceUI::LoadEntitiesFromSlvs(const Platform::Path &filename, EntityList *le,
-                                        SMesh *m, SShell *sh)
-{
+bool SolveSpaceUI::LoadEntitiesFromSlvs(const Platform::Path &filename, LinkedPart *lp) {
+    EntityList *le = &lp->entity;
+    SMesh *m = &lp->mesh;
+    SShell *sh = &lp->shell;
     SSurface srf = {};
     SCurve crv = {};
+    bool malformed;
 
     fh = OpenFile(filename, "rb");
     if(!fh) return false;
@@ -741,6 +1787,11 @@ bool SolveSpaceUI::LoadEntitiesFromSlvs(const Platform::Path &filename, EntityLi
     le->Clear();
     sv = {};
 
+    if(IsBinaryFile(fh)) {
+        fclose(fh);
+        return LoadFromBinaryFile(filename, /*saved=*/NULL, lp);
+    }
+
     char line[1024];
     while(fgets(line, (int)sizeof(line), fh)) {
         char *s = strchr(line, '\n');
@@ -756,7 +1807,9 @@ bool SolveSpaceUI::LoadEntitiesFromSlvs(const Platform::Path &filename, EntityLi
         if(e) {
             *e = '\0';
             char *key = line, *val = e+1;
-            LoadUsingTable(filename, key, val);
+            if(strcmp(key, "InputHash")!=0) {
+                LoadUsingTable(filename, key, val);
+            }
         } else if(strcmp(line, "AddGroup")==0) {
             // These get allocated whether we want them or not.
             sv.g.remap.clear();
@@ -770,98 +1823,16 @@ bool SolveSpaceUI::LoadEntitiesFromSlvs(const Platform::Path &filename, EntityLi
         } else if(strcmp(line, "AddConstraint")==0) {
 
         } else if(strcmp(line, "AddStyle")==0) {
-            // Linked file contains a style that we don't have yet,
-            // so import it.
-            if (SK.style.FindByIdNoOops(sv.s.h) == nullptr) {
-                SK.style.Add(&(sv.s));
-            }
+            // Imported by the groups that link this file, if we don't
+            // have it yet.
+            lp->style.Add(&(sv.s));
             sv.s = {};
             Style::FillDefaultStyle(&sv.s);
         } else if(strcmp(line, VERSION_STRING)==0) {
 
-        } else if(StrStartsWith(line, "Triangle ")) {
-            STriangle tr = {};
-            unsigned int rgba = 0;
-            if(sscanf(line, "Triangle %x %x  "
-                             "%lf %lf %lf  %lf %lf %lf  %lf %lf %lf",
-                &(tr.meta.face), &rgba,
-                &(tr.a.x), &(tr.a.y), &(tr.a.z),
-                &(tr.b.x), &(tr.b.y), &(tr.b.z),
-                &(tr.c.x), &(tr.c.y), &(tr.c.z)) != 11) {
-                ssassert(false, "Unexpected Triangle format");
-            }
-            tr.meta.color = RgbaColor::FromPackedInt((uint32_t)rgba);
-            m->AddTriangle(&tr);
-        } else if(StrStartsWith(line, "Surface ")) {
-            unsigned int rgba = 0;
-            if(sscanf(line, "Surface %x %x %x %d %d",
-                &(srf.h.v), &rgba, &(srf.face),
-                &(srf.degm), &(srf.degn)) != 5) {
-                ssassert(false, "Unexpected Surface format");
-            }
-            srf.color = RgbaColor::FromPackedInt((uint32_t)rgba);
-        } else if(StrStartsWith(line, "SCtrl ")) {
-            int i, j;
-            Vector c;
-            double w;
-            if(sscanf(line, "SCtrl %d %d %lf %lf %lf Weight %lf",
-                                &i, &j, &(c.x), &(c.y), &(c.z), &w) != 6)
-            {
-                ssassert(false, "Unexpected SCtrl format");
-            }
-            srf.ctrl[i][j] = c;
-            srf.weight[i][j] = w;
-        } else if(StrStartsWith(line, "TrimBy ")) {
-            STrimBy stb = {};
-            int backwards;
-            if(sscanf(line, "TrimBy %x %d  %lf %lf %lf  %lf %lf %lf",
-                &(stb.curve.v), &backwards,
-                &(stb.start.x), &(stb.start.y), &(stb.start.z),
-                &(stb.finish.x), &(stb.finish.y), &(stb.finish.z)) != 8)
-            {
-                ssassert(false, "Unexpected TrimBy format");
-            }
-            stb.backwards = (backwards != 0);
-            srf.trim.Add(&stb);
-        } else if(strcmp(line, "AddSurface")==0) {
-            sh->surface.Add(&srf);
-            srf = {};
-        } else if(StrStartsWith(line, "Curve ")) {
-            int isExact;
-            if(sscanf(line, "Curve %x %d %d %x %x",
-                &(crv.h.v),
-                &(isExact),
-                &(crv.exact.deg),
-                &(crv.surfA.v), &(crv.surfB.v)) != 5)
-            {
-                ssassert(false, "Unexpected Curve format");
-            }
-            crv.isExact = (isExact != 0);
-        } else if(StrStartsWith(line, "CCtrl ")) {
-            int i;
-            Vector c;
-            double w;
-            if(sscanf(line, "CCtrl %d %lf %lf %lf Weight %lf",
-                                &i, &(c.x), &(c.y), &(c.z), &w) != 5)
-            {
-                ssassert(false, "Unexpected CCtrl format");
-            }
-            crv.exact.ctrl[i] = c;
-            crv.exact.weight[i] = w;
-        } else if(StrStartsWith(line, "CurvePt ")) {
-            SCurvePt scpt;
-            int vertex;
-            if(sscanf(line, "CurvePt %d %lf %lf %lf",
-                &vertex,
-                &(scpt.p.x), &(scpt.p.y), &(scpt.p.z)) != 4)
-            {
-                ssassert(false, "Unexpected CurvePt format");
-            }
-            scpt.vertex = (vertex != 0);
-            crv.pts.Add(&scpt);
-        } else if(strcmp(line, "AddCurve")==0) {
-            sh->curve.Add(&crv);
-            crv = {};
+        } else if(LoadShellOrMeshRecord(line, m, sh, &srf, &crv, &malformed)) {
+            // part of the mesh or shell that the file was saved with
+            ssassert(!malformed, "Unexpected mesh or shell format");
         } else ssassert(false, "Unexpected operation");
     }
 
@@ -869,6 +1840,39 @@ bool SolveSpaceUI::LoadEntitiesFromSlvs(const Platform::Path &filename, EntityLi
     return true;
 }
 
+std::shared_ptr<LinkedPart> SolveSpaceUI::LoadLinkedPart(const Platform::Path &filename) {
+    // Reading a file is much faster than parsing it, so keep what we parsed,
+    // for as long as the contents of the file stay the same. And if its size
+    // and modification time are the same, don't even read it.
+    Platform::FileStamp stamp;
+    if(!GetFileStamp(filename, &stamp)) return nullptr;
+
+    // The board outlines are approximated to the current chord tolerance.
+    double chordTol = filename.HasExtension("emn") ? chordTolCalculated : 0.0;
+
+    auto it = linkedParts.find(filename);
+    if(it != linkedParts.end() && EXACT(it->second.chordTol == chordTol) &&
+       it->second.stamp == stamp) {
+        return it->second.part;
+    }
+
+    std::string data;
+    if(!ReadFile(filename, &data)) return nullptr;
+    uint64_t hash = HashBytes(data.data(), data.size());
+    if(it != linkedParts.end() && EXACT(it->second.chordTol == chordTol) &&
+       it->second.hash == hash) {
+        it->second.stamp = stamp;
+        return it->second.part;
+    }
+
+    std::shared_ptr<LinkedPart> part = std::make_shared<LinkedPart>();
+    if(!LoadEntitiesFromFile(filename, part.get())) {
+        return nullptr;
+    }
+    linkedParts[filename] = { stamp, hash, chordTol, part };
+    return part;
+}
+
 static Platform::MessageDialog::Response LocateImportedFile(const Platform::Path &filename,
                                                             bool canCancel) {
     Platform::MessageDialogRef dialog = CreateMessageDialog(SS.GW.window);
@@ -896,15 +1900,15 @@ bool SolveSpaceUI::ReloadAllLinked(const Platform::Path &saveFile, bool canCance
     Platform::SettingsRef settings = Platform::GetSettings();
 
     std::map<Platform::Path, Platform::Path, Platform::PathLess> linkMap;
+    std::map<Platform::Path, std::shared_ptr<LinkedPart>, Platform::PathLess> partMap;
 
     allConsistent = false;
 
     for(Group &g : SK.group) {
         if(g.type != Group::Type::LINKED) continue;
 
-        g.impEntity.Clear();
-        g.impMesh.Clear();
-        g.impShell.Clear();
+        std::shared_ptr<LinkedPart> oldPart = g.impPart;
+        g.impPart = nullptr;
 
         // If we prompted for this specific file before, don't ask again.
         if(linkMap.count(g.linkFile)) {
@@ -912,9 +1916,30 @@ bool SolveSpaceUI::ReloadAllLinked(const Platform::Path &saveFile, bool canCance
         }
 
 try_again:
-        if(LoadEntitiesFromFile(g.linkFile, &g.impEntity, &g.impMesh, &g.impShell)) {
+        // Many groups may link the same file; check it only once.
+        if(partMap.count(g.linkFile) == 0) {
+            partMap[g.linkFile] = LoadLinkedPart(g.linkFile);
+        }
+        g.impPart = partMap[g.linkFile];
+        if(g.impPart != oldPart) {
+            // The group's entities come from the file, so if what we loaded
+            // from it changed, then the group has to be generated again, and
+            // so do the groups that depend on it. That doesn't change what
+            // gets saved, though.
+            bool wasUnsaved = unsaved;
+            MarkGroupDirty(g.h);
+            unsaved = wasUnsaved;
+        }
+        if(g.impPart != nullptr) {
             // We loaded the data, good. Now import its dependencies as well.
-            for(Entity &e : g.impEntity) {
+            for(Style &s : g.impPart->style) {
+                // Linked file contains a style that we don't have yet,
+                // so import it.
+                if(SK.style.FindByIdNoOops(s.h) == nullptr) {
+                    SK.style.Add(&s);
+                }
+            }
+            for(Entity &e : g.impPart->entity) {
                 if(e.type != Entity::Type::IMAGE) continue;
                 if(!ReloadLinkedImage(g.linkFile, &e.file, canCancel)) {
                     return false;
@@ -959,6 +1984,15 @@ try_again:
         }
     }
 
+    // Forget the files that no group links any more.
+    for(auto it = linkedParts.begin(); it != linkedParts.end();) {
+        if(partMap.count(it->first) == 0) {
+            it = linkedParts.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
     for(Request &r : SK.request) {
         if(r.type != Request::Type::IMAGE) continue;
 
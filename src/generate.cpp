@@ -8,6 +8,10 @@
 //-----------------------------------------------------------------------------
 #include "solvespace.h"
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 namespace SolveSpace {
 
 void SolveSpaceUI::MarkGroupDirtyByEntity(hEntity he) {
@@ -16,15 +20,56 @@ void SolveSpaceUI::MarkGroupDirtyByEntity(hEntity he) {
 }
 
 void SolveSpaceUI::MarkGroupDirty(hGroup hg, bool onlyThis) {
+    // The groups after this one have to be solved again only if they depend
+    // on it, directly or through other groups: by their operands, or by the
+    // entities that they, their requests or their constraints refer to. The
+    // others keep their solution, and just have to redo their Booleans. A
+    // linked group also depends on the file that it links; ReloadAllLinked()
+    // marks it dirty from here when what it loaded from that file changes.
+    std::unordered_set<hGroup, HandleHasher<hGroup>> changed;
+    std::unordered_map<hGroup, std::vector<hEntity>, HandleHasher<hGroup>> refs;
+    auto entityChanged = [&](hEntity he) {
+        if(he == Entity::NO_ENTITY) return false;
+        Entity *e = SK.entity.FindByIdNoOops(he);
+        // If we can't tell where it comes from, then assume the worst.
+        return e == NULL || changed.count(e->group) > 0;
+    };
+
     bool go = false;
     for(auto const &gh : SK.groupOrder) {
         Group *g = SK.GetGroup(gh);
         if(g->h == hg) {
             go = true;
-        }
-        if(go) {
             g->clean = false;
             if(onlyThis) break;
+
+            changed.insert(g->h);
+            for(Request &r : SK.request) {
+                refs[r.group].push_back(r.workplane);
+            }
+            for(Constraint &c : SK.constraint) {
+                for(hEntity he : { c.workplane, c.ptA, c.ptB,
+                                   c.entityA, c.entityB, c.entityC, c.entityD }) {
+                    refs[c.group].push_back(he);
+                }
+            }
+            continue;
+        }
+        if(!go) continue;
+
+        bool depends = changed.count(g->opA) > 0 || changed.count(g->opB) > 0 ||
+                       entityChanged(g->predef.origin) ||
+                       entityChanged(g->predef.entityB) ||
+                       entityChanged(g->predef.entityC);
+        for(hEntity he : refs[g->h]) {
+            if(depends) break;
+            depends = entityChanged(he);
+        }
+        if(depends) {
+            g->clean = false;
+            changed.insert(g->h);
+        } else {
+            g->runningClean = false;
         }
     }
     unsaved = true;
@@ -166,6 +211,29 @@ void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox)
             return SK.GetGroup(ha)->order < SK.GetGroup(hb)->order;
         });
 
+    // The shell and mesh loaded with the file are the last group's running
+    // ones, and no group has generated any of its own. They stay good while
+    // the last group is active, and the groups to solve contribute no solid
+    // model; but anything else needs the shells of all the groups.
+    if(useSavedGeometry && !genForBBox) {
+        bool keep = (type == Generate::DIRTY || type == Generate::REGEN) &&
+                    !SK.groupOrder.IsEmpty() && SS.GW.activeGroup == *SK.groupOrder.Last();
+        for(hGroup hg : SK.groupOrder) {
+            Group *g = SK.GetGroup(hg);
+            if(type == Generate::DIRTY && (!g->clean || !g->IsSolvedOkay()) &&
+               g->type != Group::Type::DRAWING_3D &&
+               g->type != Group::Type::DRAWING_WORKPLANE) {
+                keep = false;
+            }
+        }
+        if(!keep) {
+            useSavedGeometry = false;
+            for(hGroup hg : SK.groupOrder) {
+                SK.GetGroup(hg)->clean = false;
+            }
+        }
+    }
+
     switch(type) {
         case Generate::DIRTY: {
             first = INT_MAX;
@@ -176,7 +244,7 @@ void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox)
             // Not using range-for because we're tracking the indices.
             for(i = 0; i < SK.groupOrder.n; i++) {
                 Group *g = SK.GetGroup(SK.groupOrder[i]);
-                if((!g->clean) || !g->IsSolvedOkay()) {
+                if((!g->clean) || (!g->runningClean) || !g->IsSolvedOkay()) {
                     first = min(first, i);
                 }
                 if(g->h == SS.GW.activeGroup) {
@@ -238,6 +306,11 @@ void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox)
     SK.entity.Clear();
     SK.entity.ReserveMore(oldEntityCount);
 
+    // Whether the running shell or mesh of any group so far was regenerated,
+    // so that those of all the groups after it must be too.
+    bool runningChanged = false;
+    std::vector<hGroup> thisShells, runningShells;
+
     // Not using range-for because we're using the index inside the loop.
     for(i = 0; i < SK.groupOrder.n; i++) {
         hGroup hg = SK.groupOrder[i];
@@ -287,18 +360,33 @@ void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox)
             Group *g = SK.GetGroup(hg);
             g->solved.how = SolveResult::OKAY;
             g->clean = true;
+            g->runningClean = true;
         } else {
+            Group *g = SK.GetGroup(hg);
             // this i is an index in groupOrder
-            if(i >= first && i <= last) {
+            bool inRange = (i >= first && i <= last);
+            // When regenerating only what's dirty, the groups in the range
+            // that don't depend on what changed keep their solution.
+            bool solve = inRange &&
+                (type != Generate::DIRTY || !g->clean || !g->IsSolvedOkay());
+            if(solve) {
                 // The group falls inside the range, so really solve it,
                 // and then regenerate the mesh based on the solved stuff.
-                Group *g = SK.GetGroup(hg);
                 if(genForBBox) {
                     SolveGroupAndReport(hg, andFindFree);
                     g->GenerateLoops();
-                } else {
-                    g->GenerateShellAndMesh();
+                } else if(useSavedGeometry) {
+                    // It contributes no solid model, so the running shell
+                    // and mesh are still the ones loaded with the file.
                     g->clean = true;
+                    g->runningClean = true;
+                } else {
+                    // The shells are generated once all the entities exist,
+                    // and the group is only clean once they are; we may yet
+                    // be pruned, and start over.
+                    thisShells.push_back(hg);
+                    runningShells.push_back(hg);
+                    runningChanged = true;
                 }
             } else {
                 // The group falls outside the range, so just assume that
@@ -310,10 +398,22 @@ void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox)
                     Param *prevp = prev.FindByIdNoOops(newp->h);
                     if(prevp) newp->known = true;
                 }
+                // Unless the groups before it have changed; then its own
+                // shell and mesh still hold, but not the running ones.
+                if(inRange && !genForBBox && (runningChanged || !g->runningClean)) {
+                    if(useSavedGeometry) {
+                        g->runningClean = true;
+                    } else {
+                        runningShells.push_back(hg);
+                        runningChanged = true;
+                    }
+                }
             }
         }
     }
 
+    GenerateShellsAndMeshes(thisShells, runningShells);
+
     // And update any reference dimensions with their new values
     for(auto &con : SK.constraint) {
         Constraint *c = &con;
@@ -380,6 +480,12 @@ void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox)
     Platform::FreeAllTemporary();
     allConsistent = true;
     SS.GW.persistentDirty = true;
+    // While dragging, this only moved things around; see UpdatePickIndex().
+    if(SS.GW.pending.operation == GraphicsWindow::Pending::NONE) {
+        SS.GW.pickIndex.dirty = true;
+    } else {
+        SS.GW.pickIndex.moved = true;
+    }
     SS.centerOfMass.dirty = true;
 
     endMillis = GetMilliseconds();
@@ -392,11 +498,16 @@ void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox)
             case Generate::REGEN:           typeStr = "REGEN";        break;
             case Generate::UNTIL_ACTIVE:    typeStr = "UNTIL_ACTIVE"; break;
         }
+        ExprArena::Stats eqStats  = sys.eqArena.GetStats(),
+                         jacStats = sys.jacobianArena.GetStats();
         if(endMillis)
-        dbp("Generate::%s%s took %lld ms",
+        dbp("Generate::%s%s took %lld ms; solver expressions peaked at %d kB "
+            "for the equations and %d kB for the Jacobian (%d kB reserved)",
             typeStr,
             (genForBBox ? " (for bounding box)" : ""),
-            GetMilliseconds() - startMillis);
+            GetMilliseconds() - startMillis,
+            (int)(eqStats.peakBytesUsed / 1024), (int)(jacStats.peakBytesUsed / 1024),
+            (int)((eqStats.bytesReserved + jacStats.bytesReserved) / 1024));
     }
 
     return;
@@ -409,6 +520,60 @@ pruned:
     GenerateAll(type, andFindFree, genForBBox);
 }
 
+void SolveSpaceUI::GenerateShellsAndMeshes(const std::vector<hGroup> &thisShells,
+                                           const std::vector<hGroup> &runningShells) {
+    // The groups' own shells don't depend on each other, except that a step
+    // and repeat needs the shell of the group that it repeats; so generate
+    // them concurrently, in waves that respect that. A step and repeat may
+    // also triangulate the shell it repeats, so two steps and repeats of
+    // the same group never share a wave either.
+    std::unordered_map<hGroup, int, HandleHasher<hGroup>> wave, lastRepeat;
+    int waves = 0;
+    for(hGroup hg : thisShells) {
+        Group *g = SK.GetGroup(hg);
+        int w = 0;
+        if(g->type == Group::Type::TRANSLATE || g->type == Group::Type::ROTATE) {
+            auto it = wave.find(g->opA);
+            if(it != wave.end()) w = it->second + 1;
+            it = lastRepeat.find(g->opA);
+            if(it != lastRepeat.end()) w = std::max(w, it->second + 1);
+            lastRepeat[g->opA] = w;
+        }
+        wave[hg] = w;
+        waves = std::max(waves, w + 1);
+    }
+    for(int w = 0; w < waves; w++) {
+        std::vector<Group *> groups;
+        for(hGroup hg : thisShells) {
+            if(wave[hg] == w) groups.push_back(SK.GetGroup(hg));
+        }
+        // A lone group gets the threads to itself, for the copies of a step
+        // and repeat. When there are several, the parallel loops inside each
+        // group's own work (the copies of a step and repeat, and the
+        // Booleans) are nested in this one, so they run serially on the
+        // thread that the group got; the concurrency is across the groups.
+#pragma omp parallel for schedule(dynamic) if(groups.size() > 1)
+        for(int i = 0; i < (int)groups.size(); i++) {
+            groups[i]->GenerateThisShellAndMesh();
+            groups[i]->clean = true;
+#if defined(_OPENMP)
+            // The calling thread's temporaries are freed with the rest.
+            if(omp_get_thread_num() != 0) {
+                Platform::FreeAllTemporary();
+            }
+#endif
+        }
+    }
+
+    // But each running shell is built on the one before it, so those must
+    // go in order.
+    for(hGroup hg : runningShells) {
+        Group *g = SK.GetGroup(hg);
+        g->GenerateRunningShellAndMesh();
+        g->runningClean = true;
+    }
+}
+
 void SolveSpaceUI::ForceReferences() {
     // Force the values of the parameters that define the three reference
     // coordinate systems.
@@ -29,14 +29,21 @@ void Group::Clear() {
     thisShell.Clear();
     runningShell.Clear();
     displayMesh.Clear();
+    displayMeshBvh.Clear();
+    displayMeshAdjacency.Clear();
     displayOutlines.Clear();
-    impMesh.Clear();
-    impShell.Clear();
-    impEntity.Clear();
+    impPart = nullptr;
     // remap is the only one that doesn't get recreated when we regen
     remap.clear();
 }
 
+LinkedPart::~LinkedPart() {
+    entity.Clear();
+    mesh.Clear();
+    shell.Clear();
+    style.Clear();
+}
+
 void Group::AddParam(ParamList *param, hParam hp, double v) {
     Param pa = {};
     pa.h = hp;
@@ -416,7 +423,8 @@ bool Group::IsForcedToMesh() const {
 
 bool Group::IsTriangleMeshAssembly() const {
     if (type != Type::LINKED) return false;
-    if (!impMesh.IsEmpty() && impShell.IsEmpty()) return true;
+    if (impPart == nullptr) return false;
+    if (!impPart->mesh.IsEmpty() && impPart->shell.IsEmpty()) return true;
     return false;
 }
 
@@ -776,9 +784,11 @@ void Group::Generate(EntityList *entity, ParamList *param)
             AddParam(param, h.param(5), 0);
             AddParam(param, h.param(6), 0);
 
+            if(impPart == nullptr) return;
+
             // Not using range-for here because we're changing the size of entity in the loop.
-            for(i = 0; i < impEntity.n; i++) {
-                Entity *ie = &(impEntity[i]);
+            for(i = 0; i < impPart->entity.n; i++) {
+                Entity *ie = &(impPart->entity[i]);
                 CopyEntity(entity, ie, 0, 0,
                     h.param(0), h.param(1), h.param(2),
                     h.param(3), h.param(4), h.param(5), h.param(6), NO_PARAM,
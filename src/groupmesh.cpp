@@ -7,6 +7,10 @@
 //-----------------------------------------------------------------------------
 #include "solvespace.h"
 
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
 namespace SolveSpace {
 
 void Group::AssembleLoops(bool *allClosed,
@@ -105,6 +109,39 @@ void SMesh::RemapFaces(Group *g, int remap) {
     }
 }
 
+//-----------------------------------------------------------------------------
+// Combine a list of shells or meshes, by union or by assembly, as a balanced
+// binary tree of pairs; so that each input gets combined about log(n) times,
+// not n times as if we combined them one by one. The inputs are consumed.
+//-----------------------------------------------------------------------------
+template<class T>
+static void CombineInTree(std::vector<T> *soFar, T *out, bool assemble) {
+    std::vector<T> scratch(soFar->size());
+    size_t n = soFar->size();
+    while(n > 1) {
+        for(size_t a = 0; a < n; a += 2) {
+            scratch[a/2] = {};
+            if(a == n-1) { // for an odd number just copy the last one
+                scratch[a/2].MakeFromCopyOf(&(soFar->at(a)));
+                (soFar->at(a)).Clear();
+            } else if(assemble) {
+                scratch[a/2].MakeFromAssemblyOf(&(soFar->at(a)), &(soFar->at(a+1)));
+                (soFar->at(a)).Clear();
+                (soFar->at(a+1)).Clear();
+            } else {
+                scratch[a/2].MakeFromUnionOf(&(soFar->at(a)), &(soFar->at(a+1)));
+                (soFar->at(a)).Clear();
+                (soFar->at(a+1)).Clear();
+            }
+        }
+        std::swap(scratch, *soFar);
+        n = (n+1)/2;
+    }
+    if(n == 1) {
+        *out = std::move(soFar->at(0));
+    }
+}
+
 template<class T>
 void Group::GenerateForStepAndRepeat(T *steps, T *outs, Group::CombineAs forWhat) {
 
@@ -116,13 +153,10 @@ void Group::GenerateForStepAndRepeat(T *steps, T *outs, Group::CombineAs forWhat
     int a;
     // create all the transformed copies
     std::vector <T> transd(n);
-    std::vector <T> workA(n);
-    workA[0] = {};
     // first generate a shell/mesh with each transformed copy
 #pragma omp parallel for
     for(a = a0; a < n; a++) {
         transd[a] = {};
-        workA[a] = {};
         int ap = a*2 - (subtype == Subtype::ONE_SIDED ? 0 : (n-1));
 
         if(type == Type::TRANSLATE) {
@@ -147,35 +181,64 @@ void Group::GenerateForStepAndRepeat(T *steps, T *outs, Group::CombineAs forWhat
         transd[a].RemapFaces(this, remap);
     }
 
-    std::vector<T> *soFar = &transd;
-    std::vector<T> *scratch = &workA;
-    // do the boolean operations on pairs of equal size
-    while(n > 1) {
-        for(a = 0; a < n; a+=2) {
-            scratch->at(a/2).Clear();
-            // combine a pair of shells
-            if((a==0) && (a0==1)) { // if the first was skipped just copy the 2nd
-                scratch->at(a/2).MakeFromCopyOf(&(soFar->at(a+1)));
-                (soFar->at(a+1)).Clear();
-                a0 = 0;
-            } else if (a == n-1) { // for an odd number just copy the last one
-                scratch->at(a/2).MakeFromCopyOf(&(soFar->at(a)));
-                (soFar->at(a)).Clear();
-            } else if(forWhat == CombineAs::ASSEMBLE) {
-                scratch->at(a/2).MakeFromAssemblyOf(&(soFar->at(a)), &(soFar->at(a+1)));
-                (soFar->at(a)).Clear();
-                (soFar->at(a+1)).Clear();
-            } else {
-                scratch->at(a/2).MakeFromUnionOf(&(soFar->at(a)), &(soFar->at(a+1)));
-                (soFar->at(a)).Clear();
-                (soFar->at(a+1)).Clear();
+    // Copies whose bounding boxes are disjoint can't intersect, so their
+    // union is just their assembly, which costs almost nothing. So sort the
+    // copies into clusters that overlap each other, union each cluster, and
+    // assemble those; a pattern of separate features then never needs a
+    // Boolean at all.
+    std::vector<int> cluster(n);
+    for(a = a0; a < n; a++) {
+        cluster[a] = a;
+    }
+    if(forWhat != CombineAs::ASSEMBLE) {
+        std::vector<Vector> vmax(n), vmin(n);
+        for(a = a0; a < n; a++) {
+            transd[a].GetBounding(&vmax[a], &vmin[a]);
+        }
+        auto root = [&](int i) {
+            while(cluster[i] != i) {
+                i = cluster[i] = cluster[cluster[i]];
+            }
+            return i;
+        };
+        for(a = a0; a < n; a++) {
+            for(int b = a + 1; b < n; b++) {
+                if(Vector::BoundingBoxesDisjoint(vmax[a], vmin[a], vmax[b], vmin[b])) continue;
+                int ra = root(a), rb = root(b);
+                cluster[max(ra, rb)] = min(ra, rb);
             }
         }
-        swap(scratch, soFar);
-        n = (n+1)/2;
+        for(a = a0; a < n; a++) {
+            cluster[a] = root(a);
+        }
+    }
+
+    // Each cluster is named by its first copy, so this keeps them (and the
+    // copies within them) in order. The clusters share nothing, so they're
+    // unioned concurrently, like the groups' own shells.
+    std::vector<int> roots;
+    for(a = a0; a < n; a++) {
+        if(cluster[a] == a) roots.push_back(a);
+    }
+    std::vector<T> clustered(roots.size());
+#pragma omp parallel for schedule(dynamic)
+    for(int i = 0; i < (int)roots.size(); i++) {
+        std::vector<T> members;
+        for(int b = roots[i]; b < n; b++) {
+            if(cluster[b] == roots[i]) members.push_back(std::move(transd[b]));
+        }
+        clustered[i] = {};
+        CombineInTree(&members, &clustered[i],
+                      /*assemble=*/forWhat == CombineAs::ASSEMBLE);
+#if defined(_OPENMP)
+        // The calling thread's temporaries are freed with the rest.
+        if(omp_get_thread_num() != 0) {
+            Platform::FreeAllTemporary();
+        }
+#endif
     }
     outs->Clear();
-    *outs = soFar->at(0);
+    CombineInTree(&clustered, outs, /*assemble=*/true);
 }
 
 template<class T>
@@ -209,16 +272,11 @@ void Group::GenerateForBoolean(T *prevs, T *thiss, T *outs, Group::CombineAs how
     }
 }
 
-void Group::GenerateShellAndMesh() {
-    bool prevBooleanFailed = booleanFailed;
-    booleanFailed = false;
-
+void Group::GenerateThisShellAndMesh() {
     Group *srcg = this;
 
     thisShell.Clear();
     thisMesh.Clear();
-    runningShell.Clear();
-    runningMesh.Clear();
 
     // Don't attempt a lathe or extrusion unless the source section is good:
     // planar and not self-intersecting.
@@ -384,16 +442,33 @@ void Group::GenerateShellAndMesh() {
             SK.GetParam(h.param(5))->val,
             SK.GetParam(h.param(6))->val };
 
-        thisMesh.MakeFromTransformationOf(&impMesh, offset, q, scale);
-        thisMesh.RemapFaces(this, 0);
+        if(impPart != nullptr) {
+            thisMesh.MakeFromTransformationOf(&impPart->mesh, offset, q, scale);
+            thisMesh.RemapFaces(this, 0);
 
-        thisShell.MakeFromTransformationOf(&impShell, offset, q, scale);
-        thisShell.RemapFaces(this, 0);
+            thisShell.MakeFromTransformationOf(&impPart->shell, offset, q, scale);
+            thisShell.RemapFaces(this, 0);
+        }
     }
 
     if(srcg->meshCombine != CombineAs::ASSEMBLE) {
         thisShell.MergeCoincidentSurfaces();
     }
+}
+
+void Group::GenerateRunningShellAndMesh() {
+    bool prevBooleanFailed = booleanFailed;
+    booleanFailed = false;
+
+    runningShell.Clear();
+    runningMesh.Clear();
+
+    // A step and repeat gets merged against the group's previous group,
+    // not our own previous group.
+    Group *srcg = this;
+    if(type == Type::TRANSLATE || type == Type::ROTATE) {
+        srcg = SK.GetGroup(opA);
+    }
 
     // So now we've got the mesh or shell for this group. Combine it with
     // the previous group's mesh or shell with the requested Boolean, and
@@ -458,7 +533,9 @@ void Group::GenerateDisplayItems() {
     // if its inputs have changed.
     if(displayDirty) {
         Group *pg = RunningMeshGroup();
-        if(pg && thisMesh.IsEmpty() && thisShell.IsEmpty()) {
+        bool fromPrevious = pg && !SS.useSavedGeometry &&
+                            thisMesh.IsEmpty() && thisShell.IsEmpty();
+        if(fromPrevious) {
             // We don't contribute any new solid model in this group, so our
             // display items are identical to the previous group's; which means
             // that we can just display those, and stop ourselves from
@@ -466,16 +543,13 @@ void Group::GenerateDisplayItems() {
             //
             // Note that this can end up recursing multiple times (if multiple
             // groups that contribute no solid model exist in sequence), but
-            // that's okay.
+            // that's okay. While the last group's running shell and mesh are
+            // the ones loaded with the file, though, no group has generated
+            // its own, so each just displays its running ones.
             pg->GenerateDisplayItems();
 
             displayMesh.Clear();
             displayMesh.MakeFromCopyOf(&(pg->displayMesh));
-
-            displayOutlines.Clear();
-            if(SS.GW.showEdges || SS.GW.showOutlines) {
-                displayOutlines.MakeFromCopyOf(&pg->displayOutlines);
-            }
         } else {
             // We do contribute new solid model, so we have to triangulate the
             // shell, and edge-find the mesh.
@@ -490,16 +564,32 @@ void Group::GenerateDisplayItems() {
                 trn.cn = n;
                 displayMesh.AddTriangle(&trn);
             }
+        }
 
-            displayOutlines.Clear();
+        // If we render this mesh, we need to know whether it's transparent,
+        // and we'll want all transparent triangles last, to make the depth test
+        // work correctly. That reorders the triangles, so anything that points
+        // into the mesh is built after it.
+        displayMesh.PrecomputeTransparency();
+        displayMeshBvh.Clear();
+        displayMeshAdjacency.Clear();
 
-            if(SS.GW.showEdges || SS.GW.showOutlines) {
+        displayOutlines.Clear();
+        if(SS.GW.showEdges || SS.GW.showOutlines) {
+            if(fromPrevious) {
+                displayOutlines.MakeFromCopyOf(&pg->displayOutlines);
+            } else {
                 SOutlineList rawOutlines = {};
                 if(!runningMesh.l.IsEmpty()) {
                     // Triangle mesh only; no shell or emphasized edges.
-                    runningMesh.MakeOutlinesInto(&rawOutlines, EdgeKind::EMPHASIZED);
+                    SMeshAdjacency adj = {};
+                    adj.Build(&runningMesh);
+                    runningMesh.MakeOutlinesInto(&rawOutlines, EdgeKind::EMPHASIZED, adj);
+                    adj.Clear();
                 } else {
-                    displayMesh.MakeOutlinesInto(&rawOutlines, EdgeKind::SHARP);
+                    displayMeshAdjacency.Build(&displayMesh);
+                    displayMesh.MakeOutlinesInto(&rawOutlines, EdgeKind::SHARP,
+                                                 displayMeshAdjacency);
                 }
 
                 PolylineBuilder builder;
@@ -509,11 +599,6 @@ void Group::GenerateDisplayItems() {
             }
         }
 
-        // If we render this mesh, we need to know whether it's transparent,
-        // and we'll want all transparent triangles last, to make the depth test
-        // work correctly.
-        displayMesh.PrecomputeTransparency();
-
         // Recalculate mass center if needed
         if(SS.centerOfMass.draw && SS.centerOfMass.dirty && h == SS.GW.activeGroup) {
             SS.UpdateCenterOfMass();
@@ -522,6 +607,24 @@ void Group::GenerateDisplayItems() {
     }
 }
 
+// The hierarchy for ray queries against the display mesh; built the first
+// time it's needed after the mesh changes, since most groups' meshes are
+// never picked from.
+const SMeshBvh *Group::DisplayMeshBvh() {
+    GenerateDisplayItems();
+    if(displayMeshBvh.IsEmpty()) displayMeshBvh.Build(&displayMesh);
+    return &displayMeshBvh;
+}
+
+// The adjacency of the display mesh, shared by the sharp outlines and the
+// naked edge and interference checks; built with the outlines, or else the
+// first time one of the checks needs it.
+const SMeshAdjacency *Group::DisplayMeshAdjacency() {
+    GenerateDisplayItems();
+    if(displayMeshAdjacency.IsEmpty()) displayMeshAdjacency.Build(&displayMesh);
+    return &displayMeshAdjacency;
+}
+
 Group *Group::PreviousGroup() const {
     Group *prev = nullptr;
     for(auto const &gh : SK.groupOrder) {
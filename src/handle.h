@@ -1,6 +1,7 @@
 #ifndef SOVLESPACE_HANDLE_H
 #define SOVLESPACE_HANDLE_H
 
+#include <cstdint>
 #include <functional>
 #include <type_traits>
 
@@ -42,6 +43,13 @@ struct HandleHasher {
     }
 };
 
+// How an IdList finds an element by its handle: by a binary search of its
+// sorted index, or through a hash table, which costs some memory per element
+// but makes the lookup O(1) for the big lists.
+enum class IdIndex : uint8_t { SORTED, HASHED };
+
+template<class T, class H, IdIndex Index = IdIndex::SORTED> class IdList;
+
 } // namespace SolveSpace
 
 #endif // !SOVLESPACE_HANDLE_H
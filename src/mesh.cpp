@@ -6,7 +6,7 @@
 //-----------------------------------------------------------------------------
 #include "solvespace.h"
 
-#include <set>
+#include <unordered_map>
 
 namespace SolveSpace {
 
@@ -86,17 +86,15 @@ void SMesh::MakeEdgesInPlaneInto(SEdgeList *sel, Vector n, double d) {
     // Select the naked edges in our resulting open mesh.
     SKdNode *root = SKdNode::From(&m);
     root->SnapToMesh(&m);
-    root->MakeCertainEdgesInto(sel, EdgeKind::NAKED_OR_SELF_INTER,
+    SMeshAdjacency adj = {};
+    adj.Build(&m);
+    root->MakeCertainEdgesInto(adj, sel, EdgeKind::NAKED_OR_SELF_INTER,
                                /*coplanarIsInter=*/false, NULL, NULL);
 
+    adj.Clear();
     m.Clear();
 }
 
-void SMesh::MakeOutlinesInto(SOutlineList *sol, EdgeKind edgeKind) {
-    SKdNode *root = SKdNode::From(this);
-    root->MakeOutlinesInto(sol, edgeKind);
-}
-
 //-----------------------------------------------------------------------------
 // When we are called, all of the triangles from l[start] to the end must
 // be coplanar. So we try to find a set of fewer triangles that covers the
@@ -339,10 +337,17 @@ void SMesh::MakeFromTransformationOf(SMesh *a, Vector trans,
 
 bool SMesh::IsEmpty() const { return (l.IsEmpty()); }
 
-uint32_t SMesh::FirstIntersectionWith(Point2d mp) const {
+uint32_t SMesh::FirstIntersectionWith(Point2d mp, const SMeshBvh *bvh) const {
     Vector rayPoint = SS.GW.UnProjectPoint3({mp.x, mp.y, 0.0});
     Vector rayDir = SS.GW.UnProjectPoint3({mp.x, mp.y, 1.0}).Minus(rayPoint);
 
+    if(bvh != NULL) {
+        double t;
+        int i = bvh->Raytrace(this, rayPoint, rayDir, &t,
+            [](const STriangle &tr) { return tr.meta.face != 0; });
+        return (i >= 0) ? l[i].meta.face : 0;
+    }
+
     uint32_t face = 0;
     double faceT = VERY_NEGATIVE;
     for(int i = 0; i < l.n; i++) {
@@ -360,6 +365,352 @@ uint32_t SMesh::FirstIntersectionWith(Point2d mp) const {
     return face;
 }
 
+//-----------------------------------------------------------------------------
+// Build the hierarchy top down, splitting each node at the median of its
+// triangles' centroids along the axis where those are most spread out, until
+// the leaves hold only a few triangles.
+//-----------------------------------------------------------------------------
+void SMeshBvh::Build(const SMesh *m) {
+    static const uint32_t LEAF_SIZE = 4;
+
+    Clear();
+    if(m->l.IsEmpty()) return;
+
+    std::vector<Vector> centroid;
+    centroid.reserve(m->l.n);
+    tris.reserve(m->l.n);
+    for(const STriangle &tr : m->l) {
+        centroid.push_back(tr.a.Plus(tr.b).Plus(tr.c).ScaledBy(1.0 / 3.0));
+        tris.push_back((uint32_t)tris.size());
+    }
+
+    Node root = {};
+    root.count = (uint32_t)tris.size();
+    nodes.push_back(root);
+
+    // Nodes whose triangles are yet to be bounded, and maybe split.
+    std::vector<uint32_t> pending = { 0 };
+    while(!pending.empty()) {
+        uint32_t ni = pending.back();
+        pending.pop_back();
+        uint32_t first = nodes[ni].first,
+                 count = nodes[ni].count;
+
+        Vector maxp  = Vector::From(VERY_NEGATIVE, VERY_NEGATIVE, VERY_NEGATIVE),
+               minp  = Vector::From(VERY_POSITIVE, VERY_POSITIVE, VERY_POSITIVE),
+               maxc  = maxp,
+               minc  = minp;
+        for(uint32_t k = first; k < first + count; k++) {
+            const STriangle &tr = m->l[tris[k]];
+            tr.a.MakeMaxMin(&maxp, &minp);
+            tr.b.MakeMaxMin(&maxp, &minp);
+            tr.c.MakeMaxMin(&maxp, &minp);
+            centroid[tris[k]].MakeMaxMin(&maxc, &minc);
+        }
+        // Pad the box, so that a ray that grazes an edge of a triangle by
+        // less than the tolerance still enters it.
+        Vector pad = Vector::From(LENGTH_EPS, LENGTH_EPS, LENGTH_EPS);
+        nodes[ni].maxp = maxp.Plus(pad);
+        nodes[ni].minp = minp.Minus(pad);
+
+        if(count <= LEAF_SIZE) continue;
+
+        Vector extent = maxc.Minus(minc);
+        int axis = (extent.x > extent.y) ? ((extent.x > extent.z) ? 0 : 2)
+                                         : ((extent.y > extent.z) ? 1 : 2);
+        // If all the centroids coincide there's no useful split, so this
+        // has to stay a (big) leaf.
+        if(extent.Element(axis) <= 0.0) continue;
+
+        uint32_t half = count / 2;
+        std::nth_element(tris.begin() + first, tris.begin() + first + half,
+                         tris.begin() + first + count,
+            [&](uint32_t a, uint32_t b) {
+                return centroid[a].Element(axis) < centroid[b].Element(axis);
+            });
+
+        uint32_t child = (uint32_t)nodes.size();
+        nodes[ni].first = child;
+        nodes[ni].count = 0;
+
+        Node lo = {}, hi = {};
+        lo.first = first;
+        lo.count = half;
+        hi.first = first + half;
+        hi.count = count - half;
+        nodes.push_back(lo);
+        nodes.push_back(hi);
+        pending.push_back(child);
+        pending.push_back(child + 1);
+    }
+}
+
+void SMeshBvh::Clear() {
+    nodes.clear();
+    tris.clear();
+}
+
+bool SMeshBvh::IsEmpty() const {
+    return nodes.empty();
+}
+
+// Clip the interval of the line p + t*d that lies within the slab lo..hi on
+// one axis; invD is 1/d, precomputed.
+static inline bool ClipToSlab(double p, double d, double invD, double lo, double hi,
+                              double *tmin, double *tmax) {
+    if(d == 0.0) return (p >= lo && p <= hi);
+    double t0 = (lo - p) * invD,
+           t1 = (hi - p) * invD;
+    if(t0 > t1) std::swap(t0, t1);
+    *tmin = std::max(*tmin, t0);
+    *tmax = std::min(*tmax, t1);
+    return *tmin <= *tmax;
+}
+
+//-----------------------------------------------------------------------------
+// Find the triangle, among those that accept() approves, that the line through
+// rayPoint along rayDir crosses with the greatest t, as STriangle::Raytrace
+// reports it; which is the nearest one to the viewer, when picking. Returns
+// its index in the mesh (the lowest one, if several tie), or -1 if none.
+// Subtrees are visited in order of the furthest t within their box, and those
+// that can't hold a better hit are skipped.
+//-----------------------------------------------------------------------------
+int SMeshBvh::Raytrace(const SMesh *m, Vector rayPoint, Vector rayDir, double *t,
+                       std::function<bool(const STriangle &)> const &accept) const {
+    if(nodes.empty()) return -1;
+
+    Vector invDir = Vector::From(rayDir.x == 0.0 ? 0.0 : 1.0 / rayDir.x,
+                                 rayDir.y == 0.0 ? 0.0 : 1.0 / rayDir.y,
+                                 rayDir.z == 0.0 ? 0.0 : 1.0 / rayDir.z);
+    auto FarthestInNode = [&](const Node &n, double *tmax) {
+        double tmin = -HUGE_VAL;
+        *tmax = HUGE_VAL;
+        return ClipToSlab(rayPoint.x, rayDir.x, invDir.x, n.minp.x, n.maxp.x, &tmin, tmax) &&
+               ClipToSlab(rayPoint.y, rayDir.y, invDir.y, n.minp.y, n.maxp.y, &tmin, tmax) &&
+               ClipToSlab(rayPoint.z, rayDir.z, invDir.z, n.minp.z, n.maxp.z, &tmin, tmax);
+    };
+
+    int    best  = -1;
+    double bestT = VERY_NEGATIVE;
+
+    std::vector<std::pair<uint32_t, double>> stack;
+    double rootT;
+    if(FarthestInNode(nodes[0], &rootT)) stack.emplace_back(0, rootT);
+    while(!stack.empty()) {
+        uint32_t ni    = stack.back().first;
+        double   nodeT = stack.back().second;
+        stack.pop_back();
+        if(nodeT < bestT) continue;
+
+        const Node &n = nodes[ni];
+        if(n.count > 0) {
+            for(uint32_t k = n.first; k < n.first + n.count; k++) {
+                const STriangle &tr = m->l[tris[k]];
+                if(!accept(tr)) continue;
+
+                double tt;
+                if(!tr.Raytrace(rayPoint, rayDir, &tt, NULL)) continue;
+                if(tt > bestT || (tt == bestT && (int)tris[k] < best)) {
+                    best  = (int)tris[k];
+                    bestT = tt;
+                }
+            }
+            continue;
+        }
+
+        double ta, tb;
+        bool hitA = FarthestInNode(nodes[n.first], &ta),
+             hitB = FarthestInNode(nodes[n.first + 1], &tb);
+        // Push the more promising child last, so that it's visited first.
+        if(hitA && hitB && ta > tb) {
+            stack.emplace_back(n.first + 1, tb);
+            stack.emplace_back(n.first, ta);
+        } else {
+            if(hitA) stack.emplace_back(n.first, ta);
+            if(hitB) stack.emplace_back(n.first + 1, tb);
+        }
+    }
+
+    *t = bestT;
+    return best;
+}
+
+//-----------------------------------------------------------------------------
+// Merges each point that it's given with the first earlier one within
+// LENGTH_EPS of it, in expected constant time per point. Points within
+// LENGTH_EPS of each other may hash to neighbouring cells, so we look in every
+// cell that the box of that size around a point touches.
+//-----------------------------------------------------------------------------
+class VertexWelder {
+public:
+    static constexpr double CELL = 2 * LENGTH_EPS;
+
+    std::vector<Vector>  welded;
+    std::vector<int32_t> nextInCell;
+    std::unordered_map<uint64_t, int32_t> cells;
+
+    static int64_t CellOf(double x) {
+        return (int64_t)floor(x / CELL);
+    }
+    static uint64_t CellKey(int64_t x, int64_t y, int64_t z) {
+        return ((uint64_t)x * 73856093u) ^ ((uint64_t)y * 19349663u) ^
+               ((uint64_t)z * 83492791u);
+    }
+
+    void Reserve(size_t n) {
+        cells.reserve(n);
+    }
+
+    uint32_t Weld(Vector p) {
+        int32_t found = -1;
+        for(int64_t x = CellOf(p.x - LENGTH_EPS); x <= CellOf(p.x + LENGTH_EPS); x++) {
+            for(int64_t y = CellOf(p.y - LENGTH_EPS); y <= CellOf(p.y + LENGTH_EPS); y++) {
+                for(int64_t z = CellOf(p.z - LENGTH_EPS); z <= CellOf(p.z + LENGTH_EPS); z++) {
+                    auto it = cells.find(CellKey(x, y, z));
+                    if(it == cells.end()) continue;
+                    for(int32_t v = it->second; v >= 0 && found < 0; v = nextInCell[v]) {
+                        if(welded[v].Equals(p)) found = v;
+                    }
+                }
+            }
+        }
+        if(found < 0) {
+            found = (int32_t)welded.size();
+            welded.push_back(p);
+            auto it = cells.emplace(CellKey(CellOf(p.x), CellOf(p.y), CellOf(p.z)), -1).first;
+            nextInCell.push_back(it->second);
+            it->second = found;
+        }
+        return (uint32_t)found;
+    }
+};
+
+//-----------------------------------------------------------------------------
+// Weld the vertices of the triangles in tl, and group their edges by the
+// welded vertices at their ends; in time linear in the number of triangles.
+//-----------------------------------------------------------------------------
+void SMeshAdjacency::Build(const std::vector<STriangle *> &tl) {
+    Clear();
+    tris = tl;
+    uint32_t n = 3 * (uint32_t)tris.size();
+
+    VertexWelder welder;
+    welder.Reserve(n);
+    vertex.resize(n);
+    for(uint32_t h = 0; h < n; h++) {
+        vertex[h] = welder.Weld(tris[h / 3]->vertices[h % 3]);
+    }
+
+    // Now group the half-edges, and find the mates of each group.
+    auto EdgeKey = [](uint32_t from, uint32_t to) {
+        return ((uint64_t)from << 32) | to;
+    };
+    auto EndOf = [&](uint32_t h) {
+        return vertex[h - h % 3 + (h + 1) % 3];
+    };
+
+    std::unordered_map<uint64_t, uint32_t> groups;
+    groups.reserve(n);
+    group.resize(n);
+    for(uint32_t h = 0; h < n; h++) {
+        auto it = groups.emplace(EdgeKey(vertex[h], EndOf(h)), (uint32_t)groups.size()).first;
+        group[h] = it->second;
+    }
+
+    uint32_t ngroups = (uint32_t)groups.size();
+    mateGroup.assign(ngroups, -1);
+    groupStart.assign(ngroups + 1, 0);
+    for(uint32_t h = 0; h < n; h++) {
+        groupStart[group[h] + 1]++;
+        auto it = groups.find(EdgeKey(EndOf(h), vertex[h]));
+        if(it != groups.end()) mateGroup[group[h]] = (int32_t)it->second;
+    }
+    for(uint32_t g = 0; g < ngroups; g++) {
+        groupStart[g + 1] += groupStart[g];
+    }
+    std::vector<uint32_t> filled(groupStart.begin(), groupStart.end() - 1);
+    groupEdges.resize(n);
+    for(uint32_t h = 0; h < n; h++) {
+        groupEdges[filled[group[h]]++] = h;
+    }
+}
+
+void SMeshAdjacency::Build(SMesh *m) {
+    std::vector<STriangle *> tl;
+    tl.reserve(m->l.n);
+    for(STriangle &tr : m->l) {
+        tl.push_back(&tr);
+    }
+    Build(tl);
+}
+
+void SMeshAdjacency::Clear() {
+    tris.clear();
+    vertex.clear();
+    group.clear();
+    mateGroup.clear();
+    groupStart.clear();
+    groupEdges.clear();
+}
+
+bool SMeshAdjacency::IsEmpty() const {
+    return tris.empty();
+}
+
+int SMeshAdjacency::CountMates(uint32_t h) const {
+    int32_t g = mateGroup[group[h]];
+    if(g < 0) return 0;
+    return (int)(groupStart[g + 1] - groupStart[g]);
+}
+
+int SMeshAdjacency::CountParallel(uint32_t h) const {
+    uint32_t g = group[h];
+    return (int)(groupStart[g + 1] - groupStart[g]);
+}
+
+uint32_t SMeshAdjacency::FirstMate(uint32_t h) const {
+    int32_t g = mateGroup[group[h]];
+    ssassert(g >= 0, "Half-edge has no mates");
+    return groupEdges[groupStart[g]];
+}
+
+//-----------------------------------------------------------------------------
+// Weld the vertices of the triangles in m, and store each distinct normal
+// once. Most vertices of a closed mesh are shared by about six triangles, and
+// most normals by several, so what is written or uploaded from this is much
+// smaller than the mesh; but it is built in addition to the mesh, so only
+// worth it for output that outlives the call.
+//-----------------------------------------------------------------------------
+void SWeldedMesh::MakeFromMesh(const SMesh *m) {
+    Clear();
+    triangles.reserve(m->l.n);
+
+    VertexWelder vertexWelder, normalWelder;
+    vertexWelder.Reserve(m->l.n);
+    normalWelder.Reserve(m->l.n);
+    for(const STriangle &tr : m->l) {
+        Triangle t;
+        t.meta = tr.meta;
+        bool flat = tr.an.EqualsExactly(Vector::From(0, 0, 0));
+        for(int i = 0; i < 3; i++) {
+            Vector n = flat ? tr.Normal() : tr.normals[i];
+            // A degenerate triangle has no normal, and keeps the zero vector.
+            if(!n.EqualsExactly(Vector::From(0, 0, 0))) n = n.WithMagnitude(1);
+            t.vertex[i] = vertexWelder.Weld(tr.vertices[i]);
+            t.normal[i] = normalWelder.Weld(n);
+        }
+        triangles.push_back(t);
+    }
+    vertices = std::move(vertexWelder.welded);
+    normals  = std::move(normalWelder.welded);
+}
+
+void SWeldedMesh::Clear() {
+    vertices.clear();
+    normals.clear();
+    triangles.clear();
+}
+
 Vector SMesh::GetCenterOfMass() const {
     Vector center = {};
     double vol = 0.0;
@@ -790,11 +1141,29 @@ void SKdNode::SplitLinesAgainstTriangle(SEdgeList *sel, STriangle *tr) const {
     }
 }
 
+//-----------------------------------------------------------------------------
+// Number the triangles through their tags, from 1, counting them in n; the
+// tags must be cleared first.
+//-----------------------------------------------------------------------------
+void SKdNode::NumberTriangles(int *n) const {
+    if(gt && lt) {
+        gt->NumberTriangles(n);
+        lt->NumberTriangles(n);
+    } else {
+        STriangleLl *ll;
+        for(ll = tris; ll; ll = ll->next) {
+            if(ll->tri->tag) continue;
+            ll->tri->tag = ++(*n);
+        }
+    }
+}
+
 //-----------------------------------------------------------------------------
 // Given an edge orig, occlusion test it against our mesh. We output an edge
-// list in sel, where only invisible portions of the edge are tagged.
+// list in sel, where only invisible portions of the edge are tagged. A fresh
+// stamp in marks says which triangles this edge has been split against.
 //-----------------------------------------------------------------------------
-void SKdNode::OcclusionTestLine(SEdge orig, SEdgeList *sel, int cnt) const {
+void SKdNode::OcclusionTestLine(SEdge orig, SEdgeList *sel, OcclusionMarks *marks) const {
     if(gt && lt) {
         double ac = (orig.a).Element(which),
                bc = (orig.b).Element(which);
@@ -804,53 +1173,75 @@ void SKdNode::OcclusionTestLine(SEdge orig, SEdgeList *sel, int cnt) const {
            bc < c + KDTREE_EPS ||
            which == 2)
         {
-            lt->OcclusionTestLine(orig, sel, cnt);
+            lt->OcclusionTestLine(orig, sel, marks);
         }
         if(ac > c - KDTREE_EPS ||
            bc > c - KDTREE_EPS ||
            which == 2)
         {
-            gt->OcclusionTestLine(orig, sel, cnt);
+            gt->OcclusionTestLine(orig, sel, marks);
         }
     } else {
         STriangleLl *ll;
         for(ll = tris; ll; ll = ll->next) {
             STriangle *tr = ll->tri;
 
-            if(tr->tag == cnt) continue;
+            int &mark = marks->mark[tr->tag];
+            if(mark == marks->stamp) continue;
 
             SplitLinesAgainstTriangle(sel, tr);
-            tr->tag = cnt;
+            mark = marks->stamp;
         }
     }
 }
 
 //-----------------------------------------------------------------------------
-// Search the mesh for a triangle with an edge from b to a (i.e., the mate
-// for the edge from a to b), and increment info->count each time that we
-// find one. If a triangle is found, then report whether it is front- or
-// back-facing using info->frontFacing. And regardless of whether a mate is
-// found, report whether the edge intersects the mesh with info->intersectsMesh;
-// if coplanarIsInter then we count the edge as intersecting if it's coplanar
-// with a triangle in the mesh, otherwise not.
+// Occlusion test all the edges in orig, spread over the threads. The pieces
+// of the i-th edge go into the i-th list of sels, with the invisible ones
+// tagged, and with the auxA of the edge that they came from.
 //-----------------------------------------------------------------------------
-void SKdNode::FindEdgeOn(Vector a, Vector b, int cnt, bool coplanarIsInter,
-                         EdgeOnInfo *info) const
-{
+void SKdNode::OcclusionTestLines(SEdgeList *orig, std::vector<SEdgeList> *sels) const {
+    int n = 0;
+    ClearTags();
+    NumberTriangles(&n);
+
+    sels->clear();
+    sels->resize(orig->l.n);
+#pragma omp parallel
+    {
+        OcclusionMarks marks = {};
+        marks.mark.resize(n + 1);
+#pragma omp for schedule(dynamic, 64)
+        for(int i = 0; i < orig->l.n; i++) {
+            SEdge *se = &(orig->l[i]);
+            SEdgeList *sel = &((*sels)[i]);
+            sel->AddEdge(se->a, se->b, se->auxA);
+            marks.stamp++;
+            OcclusionTestLine(*se, sel, &marks);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Report whether the edge from a to b intersects the mesh, other than at the
+// triangles that it's an edge of; if coplanarIsInter then we count the edge as
+// intersecting if it's coplanar with a triangle in the mesh, otherwise not.
+//-----------------------------------------------------------------------------
+bool SKdNode::EdgeIntersectsMesh(Vector a, Vector b, int cnt, bool coplanarIsInter) const {
     if(gt && lt) {
         double ac = a.Element(which),
                bc = b.Element(which);
         if(ac < c + KDTREE_EPS ||
            bc < c + KDTREE_EPS)
         {
-            lt->FindEdgeOn(a, b, cnt, coplanarIsInter, info);
+            if(lt->EdgeIntersectsMesh(a, b, cnt, coplanarIsInter)) return true;
         }
         if(ac > c - KDTREE_EPS ||
            bc > c - KDTREE_EPS)
         {
-            gt->FindEdgeOn(a, b, cnt, coplanarIsInter, info);
+            if(gt->EdgeIntersectsMesh(a, b, cnt, coplanarIsInter)) return true;
         }
-        return;
+        return false;
     }
 
     // We are a leaf node; so we iterate over all the triangles in our
@@ -860,86 +1251,79 @@ void SKdNode::FindEdgeOn(Vector a, Vector b, int cnt, bool coplanarIsInter,
         STriangle *tr = ll->tri;
 
         if(tr->tag == cnt) continue;
+        // Ensure that we don't test this triangle twice if it appears
+        // in two buckets of the kd tree.
+        tr->tag = cnt;
 
-        // Test if this triangle matches up with the given edge
         if((a.Equals(tr->b) && b.Equals(tr->a)) ||
            (a.Equals(tr->c) && b.Equals(tr->b)) ||
-           (a.Equals(tr->a) && b.Equals(tr->c)))
-        {
-            info->count++;
-            // Record whether this triangle is front- or back-facing.
-            if(tr->Normal().z > LENGTH_EPS) {
-                info->frontFacing = true;
-            } else {
-                info->frontFacing = false;
-            }
-            // Record the triangle
-            info->tr = tr;
-            // And record which vertices a and b correspond to
-            info->ai = a.Equals(tr->a) ? 0 : (a.Equals(tr->b) ? 1 : 2);
-            info->bi = b.Equals(tr->a) ? 0 : (b.Equals(tr->b) ? 1 : 2);
-        } else if(((a.Equals(tr->a) && b.Equals(tr->b)) ||
-                   (a.Equals(tr->b) && b.Equals(tr->c)) ||
-                   (a.Equals(tr->c) && b.Equals(tr->a))))
+           (a.Equals(tr->a) && b.Equals(tr->c)) ||
+           (a.Equals(tr->a) && b.Equals(tr->b)) ||
+           (a.Equals(tr->b) && b.Equals(tr->c)) ||
+           (a.Equals(tr->c) && b.Equals(tr->a)))
         {
             // It's an edge of this triangle, okay.
-        } else {
-            // Check for self-intersection
-            Vector n = (tr->Normal()).WithMagnitude(1);
-            double d = (tr->a).Dot(n);
-            double pa = a.Dot(n) - d, pb = b.Dot(n) - d;
-            // It's an intersection if neither point lies in-plane,
-            // and the edge crosses the plane (should handle in-plane
-            // intersections separately but don't yet).
-            if((pa < -LENGTH_EPS || pa > LENGTH_EPS) &&
-               (pb < -LENGTH_EPS || pb > LENGTH_EPS) &&
-               (pa*pb < 0))
-            {
-                // The edge crosses the plane of the triangle; now see if
-                // it crosses inside the triangle.
-                if(tr->ContainsPointProjd(b.Minus(a), a)) {
-                    if(coplanarIsInter) {
-                        info->intersectsMesh = true;
+            continue;
+        }
+
+        // Check for self-intersection
+        Vector n = (tr->Normal()).WithMagnitude(1);
+        double d = (tr->a).Dot(n);
+        double pa = a.Dot(n) - d, pb = b.Dot(n) - d;
+        // It's an intersection if neither point lies in-plane,
+        // and the edge crosses the plane (should handle in-plane
+        // intersections separately but don't yet).
+        if((pa < -LENGTH_EPS || pa > LENGTH_EPS) &&
+           (pb < -LENGTH_EPS || pb > LENGTH_EPS) &&
+           (pa*pb < 0))
+        {
+            // The edge crosses the plane of the triangle; now see if
+            // it crosses inside the triangle.
+            if(tr->ContainsPointProjd(b.Minus(a), a)) {
+                if(coplanarIsInter) {
+                    return true;
+                } else {
+                    Vector p = Vector::AtIntersectionOfPlaneAndLine(
+                                            n, d, a, b, NULL);
+                    Vector ta = tr->a,
+                           tb = tr->b,
+                           tc = tr->c;
+                    if((p.DistanceToLine(ta, tb.Minus(ta)) < LENGTH_EPS) ||
+                       (p.DistanceToLine(tb, tc.Minus(tb)) < LENGTH_EPS) ||
+                       (p.DistanceToLine(tc, ta.Minus(tc)) < LENGTH_EPS))
+                    {
+                        // Intersection lies on edge. This happens when
+                        // our edge is from a triangle coplanar with
+                        // another triangle in the mesh. We don't test
+                        // the edge against triangles whose plane contains
+                        // that edge, but we do end up testing against
+                        // the coplanar triangle's neighbours, which we
+                        // will intersect on their edges.
                     } else {
-                        Vector p = Vector::AtIntersectionOfPlaneAndLine(
-                                                n, d, a, b, NULL);
-                        Vector ta = tr->a,
-                               tb = tr->b,
-                               tc = tr->c;
-                        if((p.DistanceToLine(ta, tb.Minus(ta)) < LENGTH_EPS) ||
-                           (p.DistanceToLine(tb, tc.Minus(tb)) < LENGTH_EPS) ||
-                           (p.DistanceToLine(tc, ta.Minus(tc)) < LENGTH_EPS))
-                        {
-                            // Intersection lies on edge. This happens when
-                            // our edge is from a triangle coplanar with
-                            // another triangle in the mesh. We don't test
-                            // the edge against triangles whose plane contains
-                            // that edge, but we do end up testing against
-                            // the coplanar triangle's neighbours, which we
-                            // will intersect on their edges.
-                        } else {
-                            info->intersectsMesh = true;
-                        }
+                        return true;
                     }
                 }
             }
         }
-
-        // Ensure that we don't count this triangle twice if it appears
-        // in two buckets of the kd tree.
-        tr->tag = cnt;
     }
+    return false;
 }
 
-static bool CheckAndAddTrianglePair(std::set<std::pair<STriangle *, STriangle *>> *pairs,
-                                    STriangle *a, STriangle *b)
-{
-    if(pairs->find(std::make_pair(a, b)) != pairs->end() ||
-       pairs->find(std::make_pair(b, a)) != pairs->end())
-        return true;
-
-    pairs->emplace(a, b);
-    return false;
+// Whether the two triangles that meet at half-edge h of triangle tr, and at
+// its mate m, have different normals along it; then they meet at a sharp
+// angle, which implies they come from different faces.
+static bool IsSharpEdge(const SMeshAdjacency &adj, uint32_t h, uint32_t m) {
+    const STriangle *tr = adj.tris[h / 3],
+                    *mt = adj.tris[m / 3];
+    int j = h % 3;
+    // The mate runs the other way, from our b to our a.
+    int ai = (m + 1) % 3, bi = m % 3;
+    Vector na0 = tr->normals[j].WithMagnitude(1.0);
+    Vector nb0 = tr->normals[(j + 1) % 3].WithMagnitude(1.0);
+    Vector na1 = mt->normals[ai].WithMagnitude(1.0);
+    Vector nb1 = mt->normals[bi].WithMagnitude(1.0);
+    return !((na0.Equals(na1) && nb0.Equals(nb1)) ||
+             (na0.Equals(nb1) && nb0.Equals(na1)));
 }
 
 //-----------------------------------------------------------------------------
@@ -950,153 +1334,131 @@ static bool CheckAndAddTrianglePair(std::set<std::pair<STriangle *, STriangle *>
 //      a back-facing triangle)
 //    * emphasized edges (i.e., edges where a triangle from one face joins
 //      a triangle from a different face)
+// The neighbours of each edge come from adj, the adjacency of the mesh that
+// this tree was made from; the tree is only searched for self-intersections.
 //-----------------------------------------------------------------------------
-void SKdNode::MakeCertainEdgesInto(SEdgeList *sel, EdgeKind how, bool coplanarIsInter,
-                                   bool *inter, bool *leaky, int auxA) const
+void SKdNode::MakeCertainEdgesInto(const SMeshAdjacency &adj, SEdgeList *sel, EdgeKind how,
+                                   bool coplanarIsInter, bool *inter, bool *leaky,
+                                   int auxA) const
 {
     if(inter) *inter = false;
     if(leaky) *leaky = false;
 
-    std::vector<STriangle *> tris;
     ClearTags();
-    ListTrianglesInto(&tris);
+    const std::vector<STriangle *> &tris = adj.tris;
 
-    std::set<std::pair<STriangle *, STriangle *>> edgeTris;
+    // The mates of edges that we've already output, so that we don't output
+    // the same edge again from the triangle on its other side.
+    std::vector<bool> done(3 * tris.size());
     int cnt = 1234;
-    for(STriangle *tr : tris) {
-        for(int j = 0; j < 3; j++) {
-            Vector a = tr->vertices[j];
-            Vector b = tr->vertices[(j + 1) % 3];
-
-            SKdNode::EdgeOnInfo info = {};
-            FindEdgeOn(a, b, cnt, coplanarIsInter, &info);
-
-            switch(how) {
-                case EdgeKind::NAKED_OR_SELF_INTER:
-                    // there should be one anti-parllel edge
-                    if(info.count != 1) {
-                        // but there may be multiple parallel coincident edges
-                        SKdNode::EdgeOnInfo parallelInfo = {};
-                        FindEdgeOn(b, a, -cnt, coplanarIsInter, &parallelInfo);
-                        if (info.count != parallelInfo.count) {
-                            sel->AddEdge(a, b, auxA);
-                            if(leaky) *leaky = true;
-                        }
-                    }
-                    if(info.intersectsMesh) {
-                        sel->AddEdge(a, b, auxA);
-                        if(inter) *inter = true;
-                    }
-                    break;
-
-                case EdgeKind::SELF_INTER:
-                    if(info.intersectsMesh) {
-                        sel->AddEdge(a, b, auxA);
-                        if(inter) *inter = true;
-                    }
-                    break;
+    for(uint32_t h = 0; h < 3 * tris.size(); h++) {
+        STriangle *tr = tris[h / 3];
+        Vector a = tr->vertices[h % 3];
+        Vector b = tr->vertices[(h + 1) % 3];
+        int mates = adj.CountMates(h);
+
+        switch(how) {
+            case EdgeKind::NAKED_OR_SELF_INTER:
+                // there should be one anti-parllel edge, but there may be
+                // multiple parallel coincident edges
+                if(mates != 1 && mates != adj.CountParallel(h)) {
+                    sel->AddEdge(a, b, auxA);
+                    if(leaky) *leaky = true;
+                }
+                if(EdgeIntersectsMesh(a, b, cnt, coplanarIsInter)) {
+                    sel->AddEdge(a, b, auxA);
+                    if(inter) *inter = true;
+                }
+                break;
 
-                case EdgeKind::TURNING:
-                    if((tr->Normal().z < LENGTH_EPS) &&
-                       (info.count == 1) &&
-                       info.frontFacing)
-                    {
-                        if(CheckAndAddTrianglePair(&edgeTris, tr, info.tr))
-                            break;
-                        // This triangle is back-facing (or on edge), and
-                        // this edge has exactly one mate, and that mate is
-                        // front-facing. So this is a turning edge.
-                        sel->AddEdge(a, b, auxA);
-                    }
-                    break;
+            case EdgeKind::SELF_INTER:
+                if(EdgeIntersectsMesh(a, b, cnt, coplanarIsInter)) {
+                    sel->AddEdge(a, b, auxA);
+                    if(inter) *inter = true;
+                }
+                break;
 
-                case EdgeKind::EMPHASIZED:
-                    if(info.count == 1 && tr->meta.face != info.tr->meta.face) {
-                        if(CheckAndAddTrianglePair(&edgeTris, tr, info.tr))
-                            break;
-                        // The two triangles that join at this edge come from
-                        // different faces; either really different faces,
-                        // or one is from a face and the other is zero (i.e.,
-                        // not from a face).
-                        sel->AddEdge(a, b, auxA);
-                    }
-                    break;
+            case EdgeKind::TURNING: {
+                if(mates != 1 || done[h]) break;
+                uint32_t m = adj.FirstMate(h);
+                if((tr->Normal().z < LENGTH_EPS) &&
+                   (tris[m / 3]->Normal().z > LENGTH_EPS))
+                {
+                    // This triangle is back-facing (or on edge), and
+                    // this edge has exactly one mate, and that mate is
+                    // front-facing. So this is a turning edge.
+                    sel->AddEdge(a, b, auxA);
+                    done[m] = true;
+                }
+                break;
+            }
 
-                case EdgeKind::SHARP:
-                    if(info.count == 1) {
-                        Vector na0 = tr->normals[j].WithMagnitude(1.0);
-                        Vector nb0 = tr->normals[(j + 1) % 3].WithMagnitude(1.0);
-                        Vector na1 = info.tr->normals[info.ai].WithMagnitude(1.0);
-                        Vector nb1 = info.tr->normals[info.bi].WithMagnitude(1.0);
-                        if(!((na0.Equals(na1) && nb0.Equals(nb1)) ||
-                             (na0.Equals(nb1) && nb0.Equals(na1)))) {
-                            if(CheckAndAddTrianglePair(&edgeTris, tr, info.tr))
-                                break;
-                            // The two triangles that join at this edge meet at a sharp
-                            // angle. This implies they come from different faces.
-                            sel->AddEdge(a, b, auxA);
-                        }
-                    }
-                    break;
+            case EdgeKind::EMPHASIZED: {
+                if(mates != 1 || done[h]) break;
+                uint32_t m = adj.FirstMate(h);
+                if(tr->meta.face != tris[m / 3]->meta.face) {
+                    // The two triangles that join at this edge come from
+                    // different faces; either really different faces,
+                    // or one is from a face and the other is zero (i.e.,
+                    // not from a face).
+                    sel->AddEdge(a, b, auxA);
+                    done[m] = true;
+                }
+                break;
             }
 
-            cnt++;
+            case EdgeKind::SHARP: {
+                if(mates != 1 || done[h]) break;
+                uint32_t m = adj.FirstMate(h);
+                if(IsSharpEdge(adj, h, m)) {
+                    sel->AddEdge(a, b, auxA);
+                    done[m] = true;
+                }
+                break;
+            }
         }
+
+        cnt++;
     }
 }
 
-void SKdNode::MakeOutlinesInto(SOutlineList *sol, EdgeKind edgeKind) const
-{
-    std::vector<STriangle *> tris;
-    ClearTags();
-    ListTrianglesInto(&tris);
-
-    std::set<std::pair<STriangle *, STriangle *>> edgeTris;
-    int cnt = 1234;
-    for(STriangle *tr : tris) {
-        for(int j = 0; j < 3; j++) {
-            Vector a = tr->vertices[j];
-            Vector b = tr->vertices[(j + 1) % 3];
-
-            SKdNode::EdgeOnInfo info = {};
-            FindEdgeOn(a, b, cnt, /*coplanarIsInter=*/false, &info);
-            cnt++;
-            if(info.count != 1) continue;
-            if(CheckAndAddTrianglePair(&edgeTris, tr, info.tr))
-                continue;
-
-            int tag = 0;
-            switch(edgeKind) {
-                case EdgeKind::EMPHASIZED:
-                    if(tr->meta.face != info.tr->meta.face) {
-                        tag = 1;
-                    }
-                    break;
+// The outlines of the mesh, found through adj, its adjacency.
+void SMesh::MakeOutlinesInto(SOutlineList *sol, EdgeKind edgeKind, const SMeshAdjacency &adj) {
+    const std::vector<STriangle *> &tris = adj.tris;
+
+    std::vector<bool> done(3 * tris.size());
+    for(uint32_t h = 0; h < 3 * tris.size(); h++) {
+        if(adj.CountMates(h) != 1 || done[h]) continue;
+        uint32_t m = adj.FirstMate(h);
+        done[m] = true;
+
+        STriangle *tr = tris[h / 3],
+                  *mt = tris[m / 3];
+        int tag = 0;
+        switch(edgeKind) {
+            case EdgeKind::EMPHASIZED:
+                if(tr->meta.face != mt->meta.face) {
+                    tag = 1;
+                }
+                break;
 
-                case EdgeKind::SHARP: {
-                        Vector na0 = tr->normals[j].WithMagnitude(1.0);
-                        Vector nb0 = tr->normals[(j + 1) % 3].WithMagnitude(1.0);
-                        Vector na1 = info.tr->normals[info.ai].WithMagnitude(1.0);
-                        Vector nb1 = info.tr->normals[info.bi].WithMagnitude(1.0);
-                        if(!((na0.Equals(na1) && nb0.Equals(nb1)) ||
-                             (na0.Equals(nb1) && nb0.Equals(na1)))) {
-                            tag = 1;
-                        }
-                    }
-                    break;
+            case EdgeKind::SHARP:
+                if(IsSharpEdge(adj, h, m)) {
+                    tag = 1;
+                }
+                break;
 
-                default:
-                    ssassert(false, "Unexpected edge kind");
-            }
+            default:
+                ssassert(false, "Unexpected edge kind");
+        }
 
-            Vector nl = tr->Normal().WithMagnitude(1.0);
-            Vector nr = info.tr->Normal().WithMagnitude(1.0);
+        Vector nl = tr->Normal().WithMagnitude(1.0);
+        Vector nr = mt->Normal().WithMagnitude(1.0);
 
-            // We don't add edges with the same left and right
-            // normals because they can't produce outlines.
-            if(tag == 0 && nl.Equals(nr)) continue;
-            sol->AddEdge(a, b, nl, nr, tag);
-        }
+        // We don't add edges with the same left and right
+        // normals because they can't produce outlines.
+        if(tag == 0 && nl.Equals(nr)) continue;
+        sol->AddEdge(tr->vertices[h % 3], tr->vertices[(h + 1) % 3], nl, nr, tag);
     }
 }
 
@@ -1154,55 +1516,58 @@ void SMesh::RemoveDegenerateTriangles() {
     l.RemoveTagged();
 }
 
+// The signed volume between the triangle and the xy plane.
+static double VolumeUnder(STriangle tr) {
+    // Translate to place vertex A at (x, y, 0)
+    Vector trans = {tr.a.x, tr.a.y, 0};
+    tr.a = (tr.a).Minus(trans);
+    tr.b = (tr.b).Minus(trans);
+    tr.c = (tr.c).Minus(trans);
+
+    // Rotate to place vertex B on the y-axis. Depending on
+    // whether the triangle is CW or CCW, C is either to the
+    // right or to the left of the y-axis. This handles the
+    // sign of our normal.
+    Vector u = {-tr.b.y, tr.b.x, 0};
+    u = u.WithMagnitude(1);
+    Vector v = {tr.b.x, tr.b.y, 0};
+    v = v.WithMagnitude(1);
+    Vector n = {0, 0, 1};
+
+    tr.a = (tr.a).DotInToCsys(u, v, n);
+    tr.b = (tr.b).DotInToCsys(u, v, n);
+    tr.c = (tr.c).DotInToCsys(u, v, n);
+
+    n = tr.Normal().WithMagnitude(1);
+
+    // Triangles on edge don't contribute
+    if(fabs(n.z) < LENGTH_EPS) return 0;
+
+    // The plane has equation p dot n = a dot n
+    double d = (tr.a).Dot(n);
+    // nx*x + ny*y + nz*z = d
+    // nz*z = d - nx*x - ny*y
+    double A = -n.x/n.z, B = -n.y/n.z, C = d/n.z;
+
+    double mac = tr.c.y/tr.c.x, mbc = (tr.c.y - tr.b.y)/tr.c.x;
+    double xc = tr.c.x, yb = tr.b.y;
+
+    // I asked Maple for
+    //    int(int(A*x + B*y +C, y=mac*x..(mbc*x + yb)), x=0..xc);
+    return
+        (1.0/3)*(
+            A*(mbc-mac)+
+            (1.0/2)*B*(mbc*mbc-mac*mac)
+        )*(xc*xc*xc)+
+        (1.0/2)*(A*yb+B*yb*mbc+C*(mbc-mac))*xc*xc+
+        C*yb*xc+
+        (1.0/2)*B*yb*yb*xc;
+}
+
 double SMesh::CalculateVolume() const {
     double vol = 0;
-    for(STriangle tr : l) {
-        // Translate to place vertex A at (x, y, 0)
-        Vector trans = {tr.a.x, tr.a.y, 0};
-        tr.a = (tr.a).Minus(trans);
-        tr.b = (tr.b).Minus(trans);
-        tr.c = (tr.c).Minus(trans);
-
-        // Rotate to place vertex B on the y-axis. Depending on
-        // whether the triangle is CW or CCW, C is either to the
-        // right or to the left of the y-axis. This handles the
-        // sign of our normal.
-        Vector u = {-tr.b.y, tr.b.x, 0};
-        u = u.WithMagnitude(1);
-        Vector v = {tr.b.x, tr.b.y, 0};
-        v = v.WithMagnitude(1);
-        Vector n = {0, 0, 1};
-
-        tr.a = (tr.a).DotInToCsys(u, v, n);
-        tr.b = (tr.b).DotInToCsys(u, v, n);
-        tr.c = (tr.c).DotInToCsys(u, v, n);
-
-        n = tr.Normal().WithMagnitude(1);
-
-        // Triangles on edge don't contribute
-        if(fabs(n.z) < LENGTH_EPS) continue;
-
-        // The plane has equation p dot n = a dot n
-        double d = (tr.a).Dot(n);
-        // nx*x + ny*y + nz*z = d
-        // nz*z = d - nx*x - ny*y
-        double A = -n.x/n.z, B = -n.y/n.z, C = d/n.z;
-
-        double mac = tr.c.y/tr.c.x, mbc = (tr.c.y - tr.b.y)/tr.c.x;
-        double xc = tr.c.x, yb = tr.b.y;
-
-        // I asked Maple for
-        //    int(int(A*x + B*y +C, y=mac*x..(mbc*x + yb)), x=0..xc);
-        double integral =
-            (1.0/3)*(
-                A*(mbc-mac)+
-                (1.0/2)*B*(mbc*mbc-mac*mac)
-            )*(xc*xc*xc)+
-            (1.0/2)*(A*yb+B*yb*mbc+C*(mbc-mac))*xc*xc+
-            C*yb*xc+
-            (1.0/2)*B*yb*yb*xc;
-
-        vol += integral;
+    for(const STriangle &tr : l) {
+        vol += VolumeUnder(tr);
     }
     return vol;
 }
@@ -304,6 +304,8 @@ void GraphicsWindow::MouseMoved(double x, double y, bool leftDown,
     }
 
     havePainted = false;
+    // Whatever we drag moves on the screen, maybe without a regeneration.
+    pickIndex.moved = true;
     switch(pending.operation) {
         case Pending::DRAGGING_CONSTRAINT: {
             Constraint *c = SK.constraint.FindById(pending.constraint);
@@ -39,11 +39,10 @@ public:
     void Clear() {}
 };
 
-// Use a forward declaration in order to avoid pulling dsc.h in for units that
-// don't need to use `ParamList`
-template<class T, class H> class IdList;
-
-using ParamList = IdList<Param, hParam>;
+// IdList is forward declared in handle.h, in order to avoid pulling dsc.h in
+// for units that don't need to use `ParamList`. Params are looked up all the
+// time, and there are many of them, so they're hashed.
+using ParamList = IdList<Param, hParam, IdIndex::HASHED>;
 
 using ParamSet = std::unordered_set<hParam, HandleHasher<hParam>>;
 
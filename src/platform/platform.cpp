@@ -20,6 +20,7 @@
 // Conversely, include Microsoft headers after solvespace.h to avoid clashes.
 #   include <windows.h>
 #   include <shellapi.h>
+#   include <sys/stat.h>
 #else
 #   include <unistd.h>
 #   include <sys/stat.h>
@@ -440,6 +441,23 @@ void RemoveFile(const Platform::Path &filename) {
 #endif
 }
 
+bool GetFileStamp(const Platform::Path &filename, FileStamp *stamp) {
+    ssassert(filename.raw.length() == strlen(filename.raw.c_str()),
+             "Unexpected null byte in middle of a path");
+#if defined(WIN32)
+    struct _stat64 st;
+    if(_wstat64(Widen(filename.Expand(/*fromCurrentDirectory=*/true).raw).c_str(), &st) != 0)
+        return false;
+#else
+    struct stat st;
+    if(stat(filename.raw.c_str(), &st) != 0)
+        return false;
+#endif
+    stamp->size  = (uint64_t)st.st_size;
+    stamp->mtime = (int64_t)st.st_mtime;
+    return true;
+}
+
 bool ReadFile(const Platform::Path &filename, std::string *data) {
     FILE *f = OpenFile(filename, "rb");
     if(f == NULL) return false;
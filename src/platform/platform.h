@@ -71,6 +71,18 @@ bool ReadFile(const Platform::Path &filename, std::string *data);
 bool WriteFile(const Platform::Path &filename, const std::string &data);
 void RemoveFile(const Platform::Path &filename);
 
+// The size and modification time of a file, to notice cheaply that it may
+// have changed.
+struct FileStamp {
+    uint64_t    size;
+    int64_t     mtime;
+
+    bool operator==(const FileStamp &other) const {
+        return size == other.size && mtime == other.mtime;
+    }
+};
+bool GetFileStamp(const Platform::Path &filename, FileStamp *stamp);
+
 // Resource loading function.
 const void *LoadResource(const std::string &name, size_t *size);
 
@@ -22,6 +22,8 @@ class SPointList;
 class SPolygon;
 class SContour;
 class SMesh;
+class SMeshBvh;
+class SMeshAdjacency;
 class SSurface;
 class SBsp3;
 class SOutlineList;
@@ -290,7 +292,7 @@ public:
     void MakeFromAssemblyOf(SMesh *a, SMesh *b);
 
     void MakeEdgesInPlaneInto(SEdgeList *sel, Vector n, double d);
-    void MakeOutlinesInto(SOutlineList *sol, EdgeKind type);
+    void MakeOutlinesInto(SOutlineList *sol, EdgeKind type, const SMeshAdjacency &adj);
 
     void PrecomputeTransparency();
     void RemoveDegenerateTriangles();
@@ -300,7 +302,7 @@ public:
     bool IsEmpty() const;
     void RemapFaces(Group *g, int remap);
 
-    uint32_t FirstIntersectionWith(Point2d mp) const;
+    uint32_t FirstIntersectionWith(Point2d mp, const SMeshBvh *bvh = NULL) const;
 
     Vector GetCenterOfMass() const;
 };
@@ -336,13 +338,13 @@ public:
 
 class SKdNode {
 public:
-    struct EdgeOnInfo {
-        int        count;
-        bool       frontFacing;
-        bool       intersectsMesh;
-        STriangle *tr;
-        int        ai;
-        int        bi;
+    // Which triangles an edge has been split against already, since a
+    // triangle may lie in several leaves. Each thread keeps its own marks, so
+    // that the tree is only read during the test; the triangles are numbered
+    // by their tags for this, with NumberTriangles().
+    struct OcclusionMarks {
+        std::vector<int>    mark;
+        int                 stamp;
     };
 
     int which;  // whether c is x, y, or z
@@ -362,18 +364,86 @@ public:
     void ListTrianglesInto(std::vector<STriangle *> *tl) const;
     void ClearTags() const;
 
-    void FindEdgeOn(Vector a, Vector b, int cnt, bool coplanarIsInter, EdgeOnInfo *info) const;
-    void MakeCertainEdgesInto(SEdgeList *sel, EdgeKind how, bool coplanarIsInter,
-                              bool *inter, bool *leaky, int auxA = 0) const;
-    void MakeOutlinesInto(SOutlineList *sel, EdgeKind tagKind) const;
+    bool EdgeIntersectsMesh(Vector a, Vector b, int cnt, bool coplanarIsInter) const;
+    void MakeCertainEdgesInto(const SMeshAdjacency &adj, SEdgeList *sel, EdgeKind how,
+                              bool coplanarIsInter, bool *inter, bool *leaky,
+                              int auxA = 0) const;
 
-    void OcclusionTestLine(SEdge orig, SEdgeList *sel, int cnt) const;
+    void NumberTriangles(int *n) const;
+    void OcclusionTestLine(SEdge orig, SEdgeList *sel, OcclusionMarks *marks) const;
+    void OcclusionTestLines(SEdgeList *orig, std::vector<SEdgeList> *sels) const;
     void SplitLinesAgainstTriangle(SEdgeList *sel, STriangle *tr) const;
 
     void SnapToMesh(SMesh *m);
     void SnapToVertex(Vector v, SMesh *extras);
 };
 
+// A bounding volume hierarchy over the triangles of a mesh, for ray queries
+// such as picking faces. It refers to the triangles by their index, so must be
+// rebuilt whenever the mesh changes.
+class SMeshBvh {
+public:
+    struct Node {
+        Vector      minp, maxp;
+        uint32_t    first;  // first of two children, or of the triangles
+        uint32_t    count;  // triangles in this leaf, or 0 if not a leaf
+    };
+
+    std::vector<Node>     nodes;
+    std::vector<uint32_t> tris;  // indices into the mesh, leaf by leaf
+
+    void Build(const SMesh *m);
+    void Clear();
+    bool IsEmpty() const;
+
+    int Raytrace(const SMesh *m, Vector rayPoint, Vector rayDir, double *t,
+                 std::function<bool(const STriangle &)> const &accept) const;
+};
+
+// The connectivity of a mesh: its vertices welded together where they
+// coincide, and its triangle edges grouped by the welded vertices that they
+// run between. Edge j of triangle t is the half-edge 3*t + j, from vertex j to
+// vertex (j + 1) % 3; its mates are the half-edges that run the other way.
+// It refers to the triangles by pointer, so must be rebuilt whenever the mesh
+// changes; but it can be shared by everything that finds edges in that mesh.
+class SMeshAdjacency {
+public:
+    std::vector<STriangle *> tris;
+    std::vector<uint32_t>    vertex;     // welded vertex at the start of each half-edge
+    std::vector<uint32_t>    group;      // of the half-edges with the same start and end
+    std::vector<int32_t>     mateGroup;  // of each group, the group that runs the other way
+    std::vector<uint32_t>    groupStart; // the half-edges of each group, group by group
+    std::vector<uint32_t>    groupEdges;
+
+    void Build(const std::vector<STriangle *> &tl);
+    void Build(SMesh *m);
+    void Clear();
+    bool IsEmpty() const;
+
+    int CountMates(uint32_t h) const;
+    int CountParallel(uint32_t h) const;
+    uint32_t FirstMate(uint32_t h) const;
+};
+
+// The triangles of a mesh, with each vertex welded together with those that
+// coincide with it and each normal stored once, so that the triangles refer to
+// both by index. Triangles with no normals get the normal of their plane.
+class SWeldedMesh {
+public:
+    struct Triangle {
+        uint32_t    vertex[3];
+        uint32_t    normal[3];
+        STriMeta    meta;
+    };
+
+    std::vector<Vector>   vertices;
+    std::vector<Vector>   normals;
+    std::vector<Triangle> triangles;
+
+    void MakeFromMesh(const SMesh *m);
+    void Clear();
+};
+
 class PolylineBuilder {
 public:
     struct Edge;
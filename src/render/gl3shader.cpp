@@ -6,6 +6,8 @@
 #include "solvespace.h"
 #include "gl3shader.h"
 
+#include <unordered_map>
+
 namespace SolveSpace {
 
 //-----------------------------------------------------------------------------
@@ -238,43 +240,87 @@ void MeshRenderer::Clear() {
 }
 
 MeshRenderer::Handle MeshRenderer::Add(const SMesh &m, bool dynamic) {
-    Handle handle;
-    glGenBuffers(1, &handle.vertexBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, handle.vertexBuffer);
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t>   indices;
+    if(dynamic) {
+        // A dynamic mesh is drawn once and thrown away, so welding it would
+        // cost more than the smaller buffer saves; each triangle gets three
+        // vertices of its own, in order, and needs no index buffer.
+        vertices.reserve(m.l.n * 3);
+        for(const STriangle &t : m.l) {
+            bool flat = t.an.EqualsExactly(Vector::From(0, 0, 0));
+            for(int j = 0; j < 3; j++) {
+                MeshVertex mv;
+                mv.pos = Vector3f::From(t.vertices[j]);
+                mv.nor = Vector3f::From(flat ? t.Normal() : t.normals[j]);
+                mv.col = Vector4f::From(t.meta.color);
+                vertices.push_back(mv);
+            }
+        }
+        return Upload(vertices, indices, GL_DYNAMIC_DRAW);
+    }
 
-    MeshVertex *vertices = new MeshVertex[m.l.n * 3];
-    for(int i = 0; i < m.l.n; i++) {
-        const STriangle &t = m.l[i];
-        vertices[i * 3 + 0].pos = Vector3f::From(t.a);
-        vertices[i * 3 + 1].pos = Vector3f::From(t.b);
-        vertices[i * 3 + 2].pos = Vector3f::From(t.c);
-
-        if(t.an.EqualsExactly(Vector::From(0, 0, 0))) {
-            Vector3f normal = Vector3f::From(t.Normal());
-            vertices[i * 3 + 0].nor = normal;
-            vertices[i * 3 + 1].nor = normal;
-            vertices[i * 3 + 2].nor = normal;
-        } else {
-            vertices[i * 3 + 0].nor = Vector3f::From(t.an);
-            vertices[i * 3 + 1].nor = Vector3f::From(t.bn);
-            vertices[i * 3 + 2].nor = Vector3f::From(t.cn);
+    SWeldedMesh wm = {};
+    wm.MakeFromMesh(&m);
+
+    // Each distinct combination of vertex, normal and color becomes one
+    // vertex in the buffer, shared by every triangle that uses it.
+    struct CornerHash {
+        size_t operator()(const std::pair<uint64_t, uint32_t> &k) const {
+            return std::hash<uint64_t>()(k.first ^ ((uint64_t)k.second * 0x9e3779b97f4a7c15u));
         }
+    };
+    std::unordered_map<std::pair<uint64_t, uint32_t>, uint32_t, CornerHash> corners;
+    corners.reserve(wm.vertices.size());
 
+    indices.reserve(wm.triangles.size() * 3);
+    for(const SWeldedMesh::Triangle &t : wm.triangles) {
         for(int j = 0; j < 3; j++) {
-            vertices[i * 3 + j].col = Vector4f::From(t.meta.color);
+            auto key = std::make_pair(((uint64_t)t.vertex[j] << 32) | t.normal[j],
+                                      t.meta.color.ToPackedInt());
+            auto it = corners.emplace(key, (uint32_t)vertices.size());
+            if(it.second) {
+                MeshVertex mv;
+                mv.pos = Vector3f::From(wm.vertices[t.vertex[j]]);
+                mv.nor = Vector3f::From(wm.normals[t.normal[j]]);
+                mv.col = Vector4f::From(t.meta.color);
+                vertices.push_back(mv);
+            }
+            indices.push_back(it.first->second);
         }
+    }
+    return Upload(vertices, indices, GL_STATIC_DRAW);
+}
 
+MeshRenderer::Handle MeshRenderer::Upload(const std::vector<MeshVertex> &vertices,
+                                          const std::vector<uint32_t> &indices,
+                                          GLenum mode) {
+    Handle handle;
+    glGenBuffers(1, &handle.vertexBuffer);
+
+    glBindBuffer(GL_ARRAY_BUFFER, handle.vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(MeshVertex),
+                 vertices.data(), mode);
+
+    if(indices.empty()) {
+        handle.indexBuffer = 0;
+        handle.size = vertices.size();
+        return handle;
     }
-    glBufferData(GL_ARRAY_BUFFER, m.l.n * 3 * sizeof(MeshVertex),
-                 vertices, dynamic ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
-    handle.size = m.l.n * 3;
-    delete []vertices;
 
+    glGenBuffers(1, &handle.indexBuffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, handle.indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t),
+                 indices.data(), mode);
+    handle.size = indices.size();
     return handle;
 }
 
 void MeshRenderer::Remove(const MeshRenderer::Handle &handle) {
     glDeleteBuffers(1, &handle.vertexBuffer);
+    if(handle.indexBuffer != 0) {
+        glDeleteBuffers(1, &handle.indexBuffer);
+    }
 }
 
 void MeshRenderer::Draw(const MeshRenderer::Handle &handle,
@@ -302,7 +348,12 @@ void MeshRenderer::Draw(const MeshRenderer::Handle &handle,
         }
     }
 
-    glDrawArrays(GL_TRIANGLES, 0, handle.size);
+    if(handle.indexBuffer != 0) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, handle.indexBuffer);
+        glDrawElements(GL_TRIANGLES, handle.size, GL_UNSIGNED_INT, NULL);
+    } else {
+        glDrawArrays(GL_TRIANGLES, 0, handle.size);
+    }
 
     glDisableVertexAttribArray(ATTRIB_POS);
     if(selectedShader == &lightShader) {
@@ -311,6 +362,7 @@ void MeshRenderer::Draw(const MeshRenderer::Handle &handle,
     }
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
     selectedShader->Disable();
 }
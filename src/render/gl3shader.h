@@ -102,8 +102,12 @@ public:
         Vector4f    col;
     };
 
+    // A dynamic mesh has no index buffer (indexBuffer is 0); its vertices
+    // are drawn in order, three to a triangle, and size counts them. Else
+    // size counts the indices.
     struct Handle {
         GLuint      vertexBuffer;
+        GLuint      indexBuffer;
         GLsizei     size;
     };
 
@@ -115,6 +119,8 @@ public:
     void Clear();
 
     Handle Add(const SMesh &m, bool dynamic = false);
+    Handle Upload(const std::vector<MeshVertex> &vertices,
+                  const std::vector<uint32_t> &indices, GLenum mode);
     void Remove(const Handle &handle);
     void Draw(const Handle &handle, bool useColors = true, RgbaColor overrideColor = {});
     void Draw(const SMesh &mesh, bool useColors = true, RgbaColor overrideColor = {});
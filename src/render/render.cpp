@@ -456,4 +456,91 @@ bool ObjectPicker::Pick(const std::function<void()> &drawFn) {
     drawFn();
     return minDistance < selRadius;
 }
+
+//-----------------------------------------------------------------------------
+// A canvas that measures the screen-space extent of drawn geometry.
+//-----------------------------------------------------------------------------
+
+void BBoxMeasurer::Include(const Vector &p) {
+    Point2d pp = camera.ProjectPoint(p);
+    Vector v = Vector::From(pp.x, pp.y, 0.0);
+    if(hasBBox) {
+        bbox.Include(v);
+    } else {
+        bbox    = BBox::From(v, v);
+        hasBBox = true;
+    }
+}
+
+void BBoxMeasurer::IncludeStroke(hStroke hcs) {
+    maxWidth = std::max(maxWidth, strokes.FindById(hcs)->width);
+}
+
+void BBoxMeasurer::DrawLine(const Vector &a, const Vector &b, hStroke hcs) {
+    Include(a);
+    Include(b);
+    IncludeStroke(hcs);
+}
+
+void BBoxMeasurer::DrawEdges(const SEdgeList &el, hStroke hcs) {
+    for(const SEdge &e : el.l) {
+        Include(e.a);
+        Include(e.b);
+    }
+    IncludeStroke(hcs);
+}
+
+void BBoxMeasurer::DrawOutlines(const SOutlineList &ol, hStroke hcs, DrawOutlinesAs drawAs) {
+    ssassert(false, "Not implemented");
+}
+
+void BBoxMeasurer::DrawVectorText(const std::string &text, double height,
+                                  const Vector &o, const Vector &u, const Vector &v,
+                                  hStroke hcs) {
+    double w = VectorFont::Builtin()->GetWidth(height, text),
+           h = VectorFont::Builtin()->GetHeight(height);
+    Include(o);
+    Include(o.Plus(v.ScaledBy(h)));
+    Include(o.Plus(u.ScaledBy(w)).Plus(v.ScaledBy(h)));
+    Include(o.Plus(u.ScaledBy(w)));
+}
+
+void BBoxMeasurer::DrawQuad(const Vector &a, const Vector &b, const Vector &c, const Vector &d,
+                            hFill hcf) {
+    Include(a);
+    Include(b);
+    Include(c);
+    Include(d);
+}
+
+void BBoxMeasurer::DrawPoint(const Vector &o, Canvas::hStroke hcs) {
+    Include(o);
+    IncludeStroke(hcs);
+}
+
+void BBoxMeasurer::DrawPolygon(const SPolygon &p, hFill hcf) {
+    ssassert(false, "Not implemented");
+}
+
+void BBoxMeasurer::DrawMesh(const SMesh &m, hFill hcfFront, hFill hcfBack) {
+    ssassert(false, "Not implemented");
+}
+
+void BBoxMeasurer::DrawFaces(const SMesh &m, const std::vector<uint32_t> &faces, hFill hcf) {
+    ssassert(false, "Not implemented");
+}
+
+void BBoxMeasurer::DrawPixmap(std::shared_ptr<const Pixmap> pm,
+                              const Vector &o, const Vector &u, const Vector &v,
+                              const Point2d &ta, const Point2d &tb, Canvas::hFill hcf) {
+    DrawQuad(o, o.Plus(u), o.Plus(u).Plus(v), o.Plus(v), hcf);
+}
+
+bool BBoxMeasurer::Measure(const std::function<void()> &drawFn) {
+    hasBBox  = false;
+    maxWidth = 0.0;
+
+    drawFn();
+    return hasBBox;
+}
 }
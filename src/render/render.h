@@ -283,6 +283,44 @@ public:
     bool Pick(const std::function<void()> &drawFn);
 };
 
+// A canvas that finds the screen-space extent of drawn geometry, as the
+// ObjectPicker sees it, along with the widest stroke used to draw it.
+class BBoxMeasurer : public Canvas {
+public:
+    Camera      camera      = {};
+    // Measurement state.
+    BBox        bbox        = {};
+    bool        hasBBox     = false;
+    double      maxWidth    = 0.0;
+
+    const Camera &GetCamera() const override { return camera; }
+
+    void DrawLine(const Vector &a, const Vector &b, hStroke hcs) override;
+    void DrawEdges(const SEdgeList &el, hStroke hcs) override;
+    bool DrawBeziers(const SBezierList &bl, hStroke hcs) override { return false; }
+    void DrawOutlines(const SOutlineList &ol, hStroke hcs, DrawOutlinesAs drawAs) override;
+    void DrawVectorText(const std::string &text, double height,
+                        const Vector &o, const Vector &u, const Vector &v,
+                        hStroke hcs) override;
+
+    void DrawQuad(const Vector &a, const Vector &b, const Vector &c, const Vector &d,
+                  hFill hcf) override;
+    void DrawPoint(const Vector &o, hStroke hcs) override;
+    void DrawPolygon(const SPolygon &p, hFill hcf) override;
+    void DrawMesh(const SMesh &m, hFill hcfFront, hFill hcfBack) override;
+    void DrawFaces(const SMesh &m, const std::vector<uint32_t> &faces, hFill hcf) override;
+
+    void DrawPixmap(std::shared_ptr<const Pixmap> pm,
+                    const Vector &o, const Vector &u, const Vector &v,
+                    const Point2d &ta, const Point2d &tb, hFill hcf) override;
+    void InvalidatePixmap(std::shared_ptr<const Pixmap> pm) override {}
+
+    void Include(const Vector &p);
+    void IncludeStroke(hStroke hcs);
+
+    bool Measure(const std::function<void()> &drawFn);
+};
+
 template<class Key, class T>
 using handle_map = std::map<Key, T>;
 
@@ -263,9 +263,8 @@ void SurfaceRenderer::CullOccludedStrokes() {
 
     // Remove hidden lines (on NORMAL layers), or remove visible lines (on OCCLUDED layers).
     SKdNode *root = SKdNode::From(&mesh);
-    root->ClearTags();
 
-    int cnt = 1234;
+    std::vector<SEdgeList> oels;
     for(auto &eit : edges) {
         hStroke hcs = eit.first;
         SEdgeList &el = eit.second;
@@ -274,11 +273,12 @@ void SurfaceRenderer::CullOccludedStrokes() {
         if(stroke->layer != Layer::NORMAL &&
            stroke->layer != Layer::OCCLUDED) continue;
 
+        root->OcclusionTestLines(&el, &oels);
+
         SEdgeList nel = {};
-        for(const SEdge &e : el.l) {
-            SEdgeList oel = {};
-            oel.AddEdge(e.a, e.b);
-            root->OcclusionTestLine(e, &oel, cnt);
+        for(int i = 0; i < el.l.n; i++) {
+            const SEdge &e = el.l[i];
+            SEdgeList &oel = oels[i];
 
             if(stroke->layer == Layer::OCCLUDED) {
                 for(SEdge &oe : oel.l) {
@@ -293,7 +293,6 @@ void SurfaceRenderer::CullOccludedStrokes() {
             }
 
             oel.Clear();
-            cnt++;
         }
 
         el.l.Clear();
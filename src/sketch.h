@@ -9,6 +9,7 @@
 #define SOLVESPACE_SKETCH_H
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <tuple>
 #include <unordered_map>
@@ -133,7 +134,9 @@ template<>
 struct IsHandleOracle<hStyle> : std::true_type {};
 
 class Entity;
-using EntityList = IdList<Entity,hEntity>;
+class Style;
+// Imported drawings can make for a great many entities, so they are hashed.
+using EntityList = IdList<Entity,hEntity,IdIndex::HASHED>;
 
 struct EntityId {
     uint32_t v;     // entity ID, starting from 0
@@ -161,6 +164,19 @@ struct EntityKeyEqual {
 };
 typedef std::unordered_map<EntityKey, EntityId, EntityKeyHash, EntityKeyEqual> EntityMap;
 
+// The entities, mesh, shell and styles of a linked file. These are loaded once, and
+// then shared by all the groups that link the file, so they must not be
+// modified after loading, except to locate any images that they refer to.
+class LinkedPart {
+public:
+    EntityList              entity;
+    SMesh                   mesh;
+    SShell                  shell;
+    IdList<Style,hStyle>    style;
+
+    ~LinkedPart();
+};
+
 // A set of requests. Every request must have an associated group.
 class Group {
 public:
@@ -203,6 +219,10 @@ public:
     double      scale;
 
     bool        clean;
+    // Cleared when a group before this one changes in a way that this
+    // group's solution doesn't depend on; then only the Boolean with the
+    // groups before it has to be redone.
+    bool        runningClean;
     bool        dofCheckOk;
     hEntity     activeWorkplane;
     double      valA;
@@ -265,6 +285,8 @@ public:
 
     bool            displayDirty;
     SMesh           displayMesh;
+    SMeshBvh        displayMeshBvh;
+    SMeshAdjacency  displayMeshAdjacency;
     SOutlineList    displayOutlines;
 
     enum class CombineAs : uint32_t {
@@ -280,9 +302,7 @@ public:
     EntityMap remap;
 
     Platform::Path linkFile;
-    SMesh       impMesh;
-    SShell      impShell;
-    EntityList  impEntity;
+    std::shared_ptr<LinkedPart> impPart;
 
     std::string     name;
 
@@ -342,10 +362,16 @@ public:
     Group *RunningMeshGroup() const;
     bool IsMeshGroup();
 
-    void GenerateShellAndMesh();
+    // The shell or mesh for just this group, which needs only its own
+    // entities and those of its operand (its shell, for a step and repeat);
+    // and then the running one, combined with all the groups before it.
+    void GenerateThisShellAndMesh();
+    void GenerateRunningShellAndMesh();
     template<class T> void GenerateForStepAndRepeat(T *steps, T *outs, Group::CombineAs forWhat);
     template<class T> void GenerateForBoolean(T *a, T *b, T *o, Group::CombineAs how);
     void GenerateDisplayItems();
+    const SMeshBvh *DisplayMeshBvh();
+    const SMeshAdjacency *DisplayMeshAdjacency();
 
     enum class DrawMeshAs { DEFAULT, HOVERED, SELECTED };
     void DrawMesh(DrawMeshAs how, Canvas *canvas);
@@ -27,6 +27,155 @@ static JsSolveResult solveSketch(Slvs_hGroup g, bool calculateFaileds) {
   return jsResult;
 }
 
+// An independent sketch; see Slvs_Context. Must be freed with `.delete()`.
+class JsContext {
+  Slvs_Context *ctx;
+
+public:
+  JsContext() : ctx(Slvs_CreateContext()) {}
+  ~JsContext() { Slvs_DestroyContext(ctx); }
+  JsContext(const JsContext &) = delete;
+  JsContext &operator=(const JsContext &) = delete;
+
+  Slvs_Entity AddPoint2D(Slvs_hGroup g, double u, double v, Slvs_Entity wp) {
+    return Slvs_CtxAddPoint2D(ctx, g, u, v, wp);
+  }
+  Slvs_Entity AddPoint3D(Slvs_hGroup g, double x, double y, double z) {
+    return Slvs_CtxAddPoint3D(ctx, g, x, y, z);
+  }
+  Slvs_Entity AddNormal2D(Slvs_hGroup g, Slvs_Entity wp) {
+    return Slvs_CtxAddNormal2D(ctx, g, wp);
+  }
+  Slvs_Entity AddNormal3D(Slvs_hGroup g, double qw, double qx, double qy, double qz) {
+    return Slvs_CtxAddNormal3D(ctx, g, qw, qx, qy, qz);
+  }
+  Slvs_Entity AddDistance(Slvs_hGroup g, double value, Slvs_Entity wp) {
+    return Slvs_CtxAddDistance(ctx, g, value, wp);
+  }
+  Slvs_Entity AddLine2D(Slvs_hGroup g, Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity wp) {
+    return Slvs_CtxAddLine2D(ctx, g, ptA, ptB, wp);
+  }
+  Slvs_Entity AddLine3D(Slvs_hGroup g, Slvs_Entity ptA, Slvs_Entity ptB) {
+    return Slvs_CtxAddLine3D(ctx, g, ptA, ptB);
+  }
+  Slvs_Entity AddCubic(Slvs_hGroup g, Slvs_Entity ptA, Slvs_Entity ptB,
+                       Slvs_Entity ptC, Slvs_Entity ptD, Slvs_Entity wp) {
+    return Slvs_CtxAddCubic(ctx, g, ptA, ptB, ptC, ptD, wp);
+  }
+  Slvs_Entity AddArc(Slvs_hGroup g, Slvs_Entity normal, Slvs_Entity center,
+                     Slvs_Entity start, Slvs_Entity end, Slvs_Entity wp) {
+    return Slvs_CtxAddArc(ctx, g, normal, center, start, end, wp);
+  }
+  Slvs_Entity AddCircle(Slvs_hGroup g, Slvs_Entity normal, Slvs_Entity center,
+                        Slvs_Entity radius, Slvs_Entity wp) {
+    return Slvs_CtxAddCircle(ctx, g, normal, center, radius, wp);
+  }
+  Slvs_Entity AddWorkplane(Slvs_hGroup g, Slvs_Entity origin, Slvs_Entity nm) {
+    return Slvs_CtxAddWorkplane(ctx, g, origin, nm);
+  }
+  Slvs_Entity AddBase2D(Slvs_hGroup g) {
+    return Slvs_CtxAddBase2D(ctx, g);
+  }
+  Slvs_Constraint AddConstraint(Slvs_hGroup g, int type, Slvs_Entity wp, double val,
+                                Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity entityA,
+                                Slvs_Entity entityB, Slvs_Entity entityC, Slvs_Entity entityD,
+                                int other, int other2) {
+    return Slvs_CtxAddConstraint(ctx, g, type, wp, val, ptA, ptB,
+                                 entityA, entityB, entityC, entityD, other, other2);
+  }
+  Slvs_Constraint Coincident(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity wp) {
+    return Slvs_CtxCoincident(ctx, g, entityA, entityB, wp);
+  }
+  Slvs_Constraint Distance(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity entityB,
+                           double value, Slvs_Entity wp) {
+    return Slvs_CtxDistance(ctx, g, entityA, entityB, value, wp);
+  }
+  Slvs_Constraint Equal(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity wp) {
+    return Slvs_CtxEqual(ctx, g, entityA, entityB, wp);
+  }
+  Slvs_Constraint EqualAngle(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity entityB,
+                             Slvs_Entity entityC, Slvs_Entity entityD, Slvs_Entity wp) {
+    return Slvs_CtxEqualAngle(ctx, g, entityA, entityB, entityC, entityD, wp);
+  }
+  Slvs_Constraint EqualPointToLine(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity entityB,
+                                   Slvs_Entity entityC, Slvs_Entity entityD, Slvs_Entity wp) {
+    return Slvs_CtxEqualPointToLine(ctx, g, entityA, entityB, entityC, entityD, wp);
+  }
+  Slvs_Constraint Ratio(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity entityB,
+                        double value, Slvs_Entity wp) {
+    return Slvs_CtxRatio(ctx, g, entityA, entityB, value, wp);
+  }
+  Slvs_Constraint Symmetric(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity entityB,
+                            Slvs_Entity entityC, Slvs_Entity wp) {
+    return Slvs_CtxSymmetric(ctx, g, entityA, entityB, entityC, wp);
+  }
+  Slvs_Constraint SymmetricH(Slvs_hGroup g, Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity wp) {
+    return Slvs_CtxSymmetricH(ctx, g, ptA, ptB, wp);
+  }
+  Slvs_Constraint SymmetricV(Slvs_hGroup g, Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity wp) {
+    return Slvs_CtxSymmetricV(ctx, g, ptA, ptB, wp);
+  }
+  Slvs_Constraint Midpoint(Slvs_hGroup g, Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity wp) {
+    return Slvs_CtxMidpoint(ctx, g, ptA, ptB, wp);
+  }
+  Slvs_Constraint Horizontal(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity wp, Slvs_Entity entityB) {
+    return Slvs_CtxHorizontal(ctx, g, entityA, wp, entityB);
+  }
+  Slvs_Constraint Vertical(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity wp, Slvs_Entity entityB) {
+    return Slvs_CtxVertical(ctx, g, entityA, wp, entityB);
+  }
+  Slvs_Constraint Diameter(Slvs_hGroup g, Slvs_Entity entityA, double value) {
+    return Slvs_CtxDiameter(ctx, g, entityA, value);
+  }
+  Slvs_Constraint SameOrientation(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity entityB) {
+    return Slvs_CtxSameOrientation(ctx, g, entityA, entityB);
+  }
+  Slvs_Constraint Angle(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity entityB,
+                        double value, Slvs_Entity wp, int inverse) {
+    return Slvs_CtxAngle(ctx, g, entityA, entityB, value, wp, inverse);
+  }
+  Slvs_Constraint Perpendicular(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity entityB,
+                                Slvs_Entity wp, int inverse) {
+    return Slvs_CtxPerpendicular(ctx, g, entityA, entityB, wp, inverse);
+  }
+  Slvs_Constraint Parallel(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity wp) {
+    return Slvs_CtxParallel(ctx, g, entityA, entityB, wp);
+  }
+  Slvs_Constraint Tangent(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity wp) {
+    return Slvs_CtxTangent(ctx, g, entityA, entityB, wp);
+  }
+  Slvs_Constraint DistanceProj(Slvs_hGroup g, Slvs_Entity ptA, Slvs_Entity ptB, double value) {
+    return Slvs_CtxDistanceProj(ctx, g, ptA, ptB, value);
+  }
+  Slvs_Constraint LengthDiff(Slvs_hGroup g, Slvs_Entity entityA, Slvs_Entity entityB,
+                             double value, Slvs_Entity wp) {
+    return Slvs_CtxLengthDiff(ctx, g, entityA, entityB, value, wp);
+  }
+  Slvs_Constraint Dragged(Slvs_hGroup g, Slvs_Entity ptA, Slvs_Entity wp) {
+    return Slvs_CtxDragged(ctx, g, ptA, wp);
+  }
+
+  double GetParamValue(uint32_t ph) { return Slvs_CtxGetParamValue(ctx, ph); }
+  void SetParamValue(uint32_t ph, double value) { Slvs_CtxSetParamValue(ctx, ph, value); }
+  void MarkDragged(Slvs_Entity ptA) { Slvs_CtxMarkDragged(ctx, ptA); }
+  void ClearSketch() { Slvs_CtxClearSketch(ctx); }
+
+  JsSolveResult SolveSketch(Slvs_hGroup g, bool calculateFaileds) {
+    JsSolveResult jsResult = {};
+    Slvs_hConstraint *c = nullptr;
+    Slvs_SolveResult ret = Slvs_CtxSolveSketch(ctx, g, calculateFaileds ? &c : nullptr);
+    if(c) {
+      jsResult.bad = emscripten::val::global("Uint32Array").new_(ret.nbad);
+      jsResult.bad.call<void>("set", emscripten::typed_memory_view(ret.nbad, c));
+      free(c);
+    }
+    jsResult.result = ret.result;
+    jsResult.dof = ret.dof;
+    jsResult.nbad = ret.nbad;
+    return jsResult;
+  }
+};
+
 EMSCRIPTEN_BINDINGS(slvs) {
   emscripten::constant("C_POINTS_COINCIDENT",   SLVS_C_POINTS_COINCIDENT);
   emscripten::constant("C_PT_PT_DISTANCE",      SLVS_C_PT_PT_DISTANCE);
@@ -207,4 +356,46 @@ EMSCRIPTEN_BINDINGS(slvs) {
   emscripten::function("markDragged", &Slvs_MarkDragged);
   emscripten::function("solveSketch", &solveSketch);
   emscripten::function("clearSketch", &Slvs_ClearSketch);
+
+  emscripten::class_<JsContext>("Context")
+    .constructor<>()
+    .function("addPoint2D", &JsContext::AddPoint2D)
+    .function("addPoint3D", &JsContext::AddPoint3D)
+    .function("addNormal2D", &JsContext::AddNormal2D)
+    .function("addNormal3D", &JsContext::AddNormal3D)
+    .function("addDistance", &JsContext::AddDistance)
+    .function("addLine2D", &JsContext::AddLine2D)
+    .function("addLine3D", &JsContext::AddLine3D)
+    .function("addCubic", &JsContext::AddCubic)
+    .function("addArc", &JsContext::AddArc)
+    .function("addCircle", &JsContext::AddCircle)
+    .function("addWorkplane", &JsContext::AddWorkplane)
+    .function("addBase2D", &JsContext::AddBase2D)
+    .function("addConstraint", &JsContext::AddConstraint)
+    .function("coincident", &JsContext::Coincident)
+    .function("distance", &JsContext::Distance)
+    .function("equal", &JsContext::Equal)
+    .function("equalAngle", &JsContext::EqualAngle)
+    .function("equalPointToLine", &JsContext::EqualPointToLine)
+    .function("ratio", &JsContext::Ratio)
+    .function("symmetric", &JsContext::Symmetric)
+    .function("symmetricH", &JsContext::SymmetricH)
+    .function("symmetricV", &JsContext::SymmetricV)
+    .function("midpoint", &JsContext::Midpoint)
+    .function("horizontal", &JsContext::Horizontal)
+    .function("vertical", &JsContext::Vertical)
+    .function("diameter", &JsContext::Diameter)
+    .function("sameOrientation", &JsContext::SameOrientation)
+    .function("angle", &JsContext::Angle)
+    .function("perpendicular", &JsContext::Perpendicular)
+    .function("parallel", &JsContext::Parallel)
+    .function("tangent", &JsContext::Tangent)
+    .function("distanceProj", &JsContext::DistanceProj)
+    .function("lengthDiff", &JsContext::LengthDiff)
+    .function("dragged", &JsContext::Dragged)
+    .function("getParamValue", &JsContext::GetParamValue)
+    .function("setParamValue", &JsContext::SetParamValue)
+    .function("markDragged", &JsContext::MarkDragged)
+    .function("solveSketch", &JsContext::SolveSketch)
+    .function("clearSketch", &JsContext::ClearSketch);
 }
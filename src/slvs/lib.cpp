@@ -11,8 +11,6 @@
 
 namespace SolveSpace {
 
-Sketch SK = {};
-
 void Platform::FatalError(const std::string &message) {
     fprintf(stderr, "%s", message.c_str());
     abort();
@@ -26,8 +24,37 @@ void Group::GenerateEquations(IdList<Equation,hEquation> *) {
 
 using namespace SolveSpace;
 
-static System SYS;
-static ParamSet dragged;
+// Everything the library needs to solve one sketch. The legacy API without
+// an explicit context uses DefaultContext.
+struct Slvs_Context {
+    Sketch      sketch = {};
+    System      sys;
+    ParamSet    dragged;
+};
+
+static Slvs_Context DefaultContext;
+static thread_local Slvs_Context *Ctx = &DefaultContext;
+
+thread_local Sketch *SolveSpace::CurrentSketch = &DefaultContext.sketch;
+
+static void MakeContextCurrent(Slvs_Context *ctx) {
+    Ctx           = ctx;
+    CurrentSketch = &ctx->sketch;
+}
+
+// Makes a context current on the calling thread for the lifetime of the
+// scope, and restores the previous one afterwards.
+class ContextScope {
+    Slvs_Context *prev;
+public:
+    ContextScope(Slvs_Context *ctx) : prev(Ctx) {
+        ssassert(ctx != NULL, "Expected a solver context");
+        MakeContextCurrent(ctx);
+    }
+    ~ContextScope() {
+        MakeContextCurrent(prev);
+    }
+};
 
 extern "C" {
 
@@ -838,8 +865,8 @@ void Slvs_MakeQuaternion(double ux, double uy, double uz,
 
 void Slvs_ClearSketch()
 {
-    dragged.clear();
-    SYS.Clear();
+    Ctx->dragged.clear();
+    Ctx->sys.Clear();
     SK.param.Clear();
     SK.entity.Clear();
     SK.constraint.Clear();
@@ -850,7 +877,7 @@ void Slvs_MarkDragged(Slvs_Entity ptA) {
         const size_t params = Slvs_IsPoint3D(ptA) ? 3 : 2;
         for(size_t i = 0; i < params; ++i) {
             hParam p = hParam { ptA.param[i] };
-            dragged.insert(p);
+            Ctx->dragged.insert(p);
         }
     } else {
         SolveSpace::Platform::FatalError("Invalid entity for marking dragged");
@@ -859,7 +886,7 @@ void Slvs_MarkDragged(Slvs_Entity ptA) {
 
 Slvs_SolveResult Slvs_SolveSketch(uint32_t shg, Slvs_hConstraint **bad = nullptr)
 {
-    SYS.Clear();
+    Ctx->sys.Clear();
 
     Group g = {};
     g.h.v = shg;
@@ -876,7 +903,7 @@ Slvs_SolveResult Slvs_SolveSketch(uint32_t shg, Slvs_hConstraint **bad = nullptr
                 // get params for this entity and add it to the system
                 Param *p = SK.GetParam(parh);
                 p->known = false;
-                SYS.param.Add(p);
+                Ctx->sys.param.Add(p);
             }
         }
     }
@@ -892,7 +919,7 @@ Slvs_SolveResult Slvs_SolveSketch(uint32_t shg, Slvs_hConstraint **bad = nullptr
         // correctness issues, it does waste memory, so identify this case and regenerate
         // only if we actually need to.
         if(c->valP.v) {
-            SYS.param.Add(SK.GetParam(c->valP));
+            Ctx->sys.param.Add(SK.GetParam(c->valP));
             continue;
         }
         // If `valP` is 0, this is either a constraint which doesn't have a param, or one
@@ -900,7 +927,7 @@ Slvs_SolveResult Slvs_SolveSketch(uint32_t shg, Slvs_hConstraint **bad = nullptr
         // This generates at most a single additional param
         c->Generate(&SK.param);
         if(c->valP.v) {
-            SYS.param.Add(SK.GetParam(c->valP));
+            Ctx->sys.param.Add(SK.GetParam(c->valP));
 
             if(Slvs_CanInitiallySatisfy(*c)) {
                 c->ModifyToSatisfy();
@@ -909,15 +936,15 @@ Slvs_SolveResult Slvs_SolveSketch(uint32_t shg, Slvs_hConstraint **bad = nullptr
     }
 
     // mark dragged params
-    for(hParam p : dragged) {
-        SYS.dragged.insert(p);
+    for(hParam p : Ctx->dragged) {
+        Ctx->sys.dragged.insert(p);
     }
 
-    // for(hParam &par : SYS.dragged) {
+    // for(hParam &par : Ctx->sys.dragged) {
     //     std::cout << "DraggedParam( h:" << par.v << " )\n";
     // }
 
-    // for(Param &par : SYS.param) {
+    // for(Param &par : Ctx->sys.param) {
     //     std::cout << "SysParam( " << par.ToString() << " )\n";
     // }
 
@@ -933,7 +960,7 @@ Slvs_SolveResult Slvs_SolveSketch(uint32_t shg, Slvs_hConstraint **bad = nullptr
     bool andFindBad = bad != nullptr;
 
     int dof = 0;
-    SolveResult status = SYS.Solve(&g, &dof, &badList, andFindBad, false, false);
+    SolveResult status = Ctx->sys.Solve(&g, &dof, &badList, andFindBad, false, false);
     Slvs_SolveResult sr = {};
     sr.dof = dof;
     sr.nbad = badList.n;
@@ -965,10 +992,6 @@ Slvs_SolveResult Slvs_SolveSketch(uint32_t shg, Slvs_hConstraint **bad = nullptr
             sr.result = SLVS_RESULT_REDUNDANT_OKAY;
             return sr;
         }
-        case SolveResult::TOO_MANY_UNKNOWNS: {
-            sr.result = SLVS_RESULT_TOO_MANY_UNKNOWNS;
-            return sr;
-        }
     }
     return sr;
 }
@@ -987,7 +1010,7 @@ void Slvs_SetParamValue(uint32_t ph, double value)
 
 void Slvs_Solve(Slvs_System *ssys, uint32_t shg)
 {
-    SYS.Clear();
+    Ctx->sys.Clear();
     SK.param.Clear();
     SK.entity.Clear();
     SK.constraint.Clear();
@@ -1000,7 +1023,7 @@ void Slvs_Solve(Slvs_System *ssys, uint32_t shg)
         p.val = sp->val;
         SK.param.Add(&p);
         if(sp->group == shg) {
-            SYS.param.Add(&p);
+            Ctx->sys.param.Add(&p);
         }
     }
 
@@ -1047,7 +1070,7 @@ void Slvs_Solve(Slvs_System *ssys, uint32_t shg)
             for(Param &p : params) {
                 p.h = SK.param.AddAndAssignId(&p);
                 c.valP = p.h;
-                SYS.param.Add(&p);
+                Ctx->sys.param.Add(&p);
             }
             params.Clear();
 
@@ -1062,7 +1085,7 @@ void Slvs_Solve(Slvs_System *ssys, uint32_t shg)
     for(i = 0; i < ssys->ndragged; i++) {
         if(ssys->dragged[i]) {
             hParam hp = { ssys->dragged[i] };
-            SYS.dragged.insert(hp);
+            Ctx->sys.dragged.insert(hp);
         }
     }
 
@@ -1073,7 +1096,7 @@ void Slvs_Solve(Slvs_System *ssys, uint32_t shg)
 
     // Now we're finally ready to solve!
     bool andFindBad = ssys->calculateFaileds ? true : false;
-    SolveResult how = SYS.Solve(&g, &(ssys->dof), &bad, andFindBad, /*andFindFree=*/false);
+    SolveResult how = Ctx->sys.Solve(&g, &(ssys->dof), &bad, andFindBad, /*andFindFree=*/false);
 
     switch(how) {
         case SolveResult::OKAY:
@@ -1091,10 +1114,6 @@ void Slvs_Solve(Slvs_System *ssys, uint32_t shg)
         case SolveResult::REDUNDANT_OKAY:
             ssys->result = SLVS_RESULT_REDUNDANT_OKAY;
             break;
-
-        case SolveResult::TOO_MANY_UNKNOWNS:
-            ssys->result = SLVS_RESULT_TOO_MANY_UNKNOWNS;
-            break;
     }
 
     // Write the new parameter values back to our caller.
@@ -1113,7 +1132,7 @@ void Slvs_Solve(Slvs_System *ssys, uint32_t shg)
     }
 
     bad.Clear();
-    SYS.Clear();
+    Ctx->sys.Clear();
     SK.param.Clear();
     SK.entity.Clear();
     SK.constraint.Clear();
@@ -1121,4 +1140,249 @@ void Slvs_Solve(Slvs_System *ssys, uint32_t shg)
     Platform::FreeAllTemporary();
 }
 
+// contexts
+
+Slvs_Context *Slvs_CreateContext(void) {
+    return new Slvs_Context();
+}
+
+void Slvs_DestroyContext(Slvs_Context *ctx) {
+    if(ctx == NULL) return;
+    ssassert(ctx != &DefaultContext, "Cannot destroy the default context");
+    ssassert(ctx != Ctx, "Cannot destroy a context that is in use");
+    delete ctx;
+}
+
+Slvs_Entity Slvs_CtxAddPoint2D(Slvs_Context *ctx, uint32_t grouph, double u, double v, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_AddPoint2D(grouph, u, v, workplane);
+}
+
+Slvs_Entity Slvs_CtxAddPoint3D(Slvs_Context *ctx, uint32_t grouph, double x, double y, double z) {
+    ContextScope scope(ctx);
+    return Slvs_AddPoint3D(grouph, x, y, z);
+}
+
+Slvs_Entity Slvs_CtxAddNormal2D(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_AddNormal2D(grouph, workplane);
+}
+
+Slvs_Entity Slvs_CtxAddNormal3D(Slvs_Context *ctx, uint32_t grouph, double qw, double qx, double qy, double qz) {
+    ContextScope scope(ctx);
+    return Slvs_AddNormal3D(grouph, qw, qx, qy, qz);
+}
+
+Slvs_Entity Slvs_CtxAddDistance(Slvs_Context *ctx, uint32_t grouph, double value, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_AddDistance(grouph, value, workplane);
+}
+
+Slvs_Entity Slvs_CtxAddLine2D(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_AddLine2D(grouph, ptA, ptB, workplane);
+}
+
+Slvs_Entity Slvs_CtxAddLine3D(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity ptA, Slvs_Entity ptB) {
+    ContextScope scope(ctx);
+    return Slvs_AddLine3D(grouph, ptA, ptB);
+}
+
+Slvs_Entity Slvs_CtxAddCubic(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity ptA, Slvs_Entity ptB,
+                             Slvs_Entity ptC, Slvs_Entity ptD, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_AddCubic(grouph, ptA, ptB, ptC, ptD, workplane);
+}
+
+Slvs_Entity Slvs_CtxAddArc(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity normal,
+                           Slvs_Entity center, Slvs_Entity start, Slvs_Entity end,
+                           Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_AddArc(grouph, normal, center, start, end, workplane);
+}
+
+Slvs_Entity Slvs_CtxAddCircle(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity normal,
+                              Slvs_Entity center, Slvs_Entity radius, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_AddCircle(grouph, normal, center, radius, workplane);
+}
+
+Slvs_Entity Slvs_CtxAddWorkplane(Slvs_Context *ctx, uint32_t grouph, Slvs_Entity origin, Slvs_Entity nm) {
+    ContextScope scope(ctx);
+    return Slvs_AddWorkplane(grouph, origin, nm);
+}
+
+Slvs_Entity Slvs_CtxAddBase2D(Slvs_Context *ctx, uint32_t grouph) {
+    ContextScope scope(ctx);
+    return Slvs_AddBase2D(grouph);
+}
+
+Slvs_Constraint Slvs_CtxAddConstraint(Slvs_Context *ctx, uint32_t grouph,
+    int type, Slvs_Entity workplane, double val, Slvs_Entity ptA,
+    Slvs_Entity ptB, Slvs_Entity entityA,
+    Slvs_Entity entityB, Slvs_Entity entityC,
+    Slvs_Entity entityD, int other, int other2) {
+    ContextScope scope(ctx);
+    return Slvs_AddConstraint(grouph, type, workplane, val, ptA, ptB,
+                              entityA, entityB, entityC, entityD, other, other2);
+}
+
+Slvs_Constraint Slvs_CtxCoincident(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_Coincident(grouph, entityA, entityB, workplane);
+}
+
+Slvs_Constraint Slvs_CtxDistance(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity entityB, double value, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_Distance(grouph, entityA, entityB, value, workplane);
+}
+
+Slvs_Constraint Slvs_CtxEqual(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_Equal(grouph, entityA, entityB, workplane);
+}
+
+Slvs_Constraint Slvs_CtxEqualAngle(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity entityC, Slvs_Entity entityD,
+    Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_EqualAngle(grouph, entityA, entityB, entityC, entityD, workplane);
+}
+
+Slvs_Constraint Slvs_CtxEqualPointToLine(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity entityC, Slvs_Entity entityD,
+    Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_EqualPointToLine(grouph, entityA, entityB, entityC, entityD, workplane);
+}
+
+Slvs_Constraint Slvs_CtxRatio(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity entityB, double value, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_Ratio(grouph, entityA, entityB, value, workplane);
+}
+
+Slvs_Constraint Slvs_CtxSymmetric(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity entityC, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_Symmetric(grouph, entityA, entityB, entityC, workplane);
+}
+
+Slvs_Constraint Slvs_CtxSymmetricH(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_SymmetricH(grouph, ptA, ptB, workplane);
+}
+
+Slvs_Constraint Slvs_CtxSymmetricV(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_SymmetricV(grouph, ptA, ptB, workplane);
+}
+
+Slvs_Constraint Slvs_CtxMidpoint(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_Midpoint(grouph, ptA, ptB, workplane);
+}
+
+Slvs_Constraint Slvs_CtxHorizontal(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity workplane, Slvs_Entity entityB) {
+    ContextScope scope(ctx);
+    return Slvs_Horizontal(grouph, entityA, workplane, entityB);
+}
+
+Slvs_Constraint Slvs_CtxVertical(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity workplane, Slvs_Entity entityB) {
+    ContextScope scope(ctx);
+    return Slvs_Vertical(grouph, entityA, workplane, entityB);
+}
+
+Slvs_Constraint Slvs_CtxDiameter(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, double value) {
+    ContextScope scope(ctx);
+    return Slvs_Diameter(grouph, entityA, value);
+}
+
+Slvs_Constraint Slvs_CtxSameOrientation(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity entityB) {
+    ContextScope scope(ctx);
+    return Slvs_SameOrientation(grouph, entityA, entityB);
+}
+
+Slvs_Constraint Slvs_CtxAngle(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity entityB, double value, Slvs_Entity workplane, int inverse) {
+    ContextScope scope(ctx);
+    return Slvs_Angle(grouph, entityA, entityB, value, workplane, inverse);
+}
+
+Slvs_Constraint Slvs_CtxPerpendicular(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity workplane, int inverse) {
+    ContextScope scope(ctx);
+    return Slvs_Perpendicular(grouph, entityA, entityB, workplane, inverse);
+}
+
+Slvs_Constraint Slvs_CtxParallel(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_Parallel(grouph, entityA, entityB, workplane);
+}
+
+Slvs_Constraint Slvs_CtxTangent(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_Tangent(grouph, entityA, entityB, workplane);
+}
+
+Slvs_Constraint Slvs_CtxDistanceProj(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity ptA, Slvs_Entity ptB, double value) {
+    ContextScope scope(ctx);
+    return Slvs_DistanceProj(grouph, ptA, ptB, value);
+}
+
+Slvs_Constraint Slvs_CtxLengthDiff(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity entityA, Slvs_Entity entityB, double value, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_LengthDiff(grouph, entityA, entityB, value, workplane);
+}
+
+Slvs_Constraint Slvs_CtxDragged(Slvs_Context *ctx, uint32_t grouph,
+    Slvs_Entity ptA, Slvs_Entity workplane) {
+    ContextScope scope(ctx);
+    return Slvs_Dragged(grouph, ptA, workplane);
+}
+
+double Slvs_CtxGetParamValue(Slvs_Context *ctx, uint32_t ph) {
+    ContextScope scope(ctx);
+    return Slvs_GetParamValue(ph);
+}
+
+void Slvs_CtxSetParamValue(Slvs_Context *ctx, uint32_t ph, double value) {
+    ContextScope scope(ctx);
+    Slvs_SetParamValue(ph, value);
+}
+
+void Slvs_CtxSolve(Slvs_Context *ctx, Slvs_System *ssys, uint32_t shg) {
+    ContextScope scope(ctx);
+    Slvs_Solve(ssys, shg);
+}
+
+void Slvs_CtxMarkDragged(Slvs_Context *ctx, Slvs_Entity ptA) {
+    ContextScope scope(ctx);
+    Slvs_MarkDragged(ptA);
+}
+
+Slvs_SolveResult Slvs_CtxSolveSketch(Slvs_Context *ctx, uint32_t shg, Slvs_hConstraint **bad) {
+    ContextScope scope(ctx);
+    return Slvs_SolveSketch(shg, bad);
+}
+
+void Slvs_CtxClearSketch(Slvs_Context *ctx) {
+    ContextScope scope(ctx);
+    Slvs_ClearSketch();
+}
+
 } /* extern "C" */
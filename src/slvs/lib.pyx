@@ -92,6 +92,54 @@ cdef extern from "slvs.h" nogil:
     double Slvs_SetParamValue(int ph, double value)
     void Slvs_ClearSketch()
 
+    ctypedef struct Slvs_Context:
+        pass
+
+    Slvs_Context *Slvs_CreateContext()
+    void Slvs_DestroyContext(Slvs_Context *ctx)
+
+    Slvs_Entity Slvs_CtxAddPoint2D(Slvs_Context *ctx, Slvs_hGroup grouph, double u, double v, Slvs_Entity workplane)
+    Slvs_Entity Slvs_CtxAddPoint3D(Slvs_Context *ctx, Slvs_hGroup grouph, double x, double y, double z)
+    Slvs_Entity Slvs_CtxAddNormal2D(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity workplane)
+    Slvs_Entity Slvs_CtxAddNormal3D(Slvs_Context *ctx, Slvs_hGroup grouph, double qw, double qx, double qy, double qz)
+    Slvs_Entity Slvs_CtxAddDistance(Slvs_Context *ctx, Slvs_hGroup grouph, double value, Slvs_Entity workplane)
+    Slvs_Entity Slvs_CtxAddLine2D(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity workplane)
+    Slvs_Entity Slvs_CtxAddLine3D(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity ptA, Slvs_Entity ptB)
+    Slvs_Entity Slvs_CtxAddCubic(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity ptC, Slvs_Entity ptD, Slvs_Entity workplane)
+    Slvs_Entity Slvs_CtxAddArc(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity normal, Slvs_Entity center, Slvs_Entity start, Slvs_Entity end, Slvs_Entity workplane)
+    Slvs_Entity Slvs_CtxAddCircle(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity normal, Slvs_Entity center, Slvs_Entity radius, Slvs_Entity workplane)
+    Slvs_Entity Slvs_CtxAddWorkplane(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity origin, Slvs_Entity nm)
+    Slvs_Entity Slvs_CtxAddBase2D(Slvs_Context *ctx, Slvs_hGroup grouph)
+
+    Slvs_Constraint Slvs_CtxAddConstraint(Slvs_Context *ctx, Slvs_hGroup grouph, int type, Slvs_Entity workplane, double val, Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity entityC, Slvs_Entity entityD, int other, int other2)
+    Slvs_Constraint Slvs_CtxCoincident(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity workplane)
+    Slvs_Constraint Slvs_CtxDistance(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity entityB, double value, Slvs_Entity workplane)
+    Slvs_Constraint Slvs_CtxEqual(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity workplane)
+    Slvs_Constraint Slvs_CtxEqualAngle(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity entityC, Slvs_Entity entityD, Slvs_Entity workplane)
+    Slvs_Constraint Slvs_CtxEqualPointToLine(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity entityC, Slvs_Entity entityD, Slvs_Entity workplane)
+    Slvs_Constraint Slvs_CtxRatio(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity entityB, double value, Slvs_Entity workplane)
+    Slvs_Constraint Slvs_CtxSymmetric(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity entityC, Slvs_Entity workplane)
+    Slvs_Constraint Slvs_CtxSymmetricH(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity workplane)
+    Slvs_Constraint Slvs_CtxSymmetricV(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity workplane)
+    Slvs_Constraint Slvs_CtxMidpoint(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity ptA, Slvs_Entity ptB, Slvs_Entity workplane)
+    Slvs_Constraint Slvs_CtxHorizontal(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity workplane, Slvs_Entity entityB)
+    Slvs_Constraint Slvs_CtxVertical(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity workplane, Slvs_Entity entityB)
+    Slvs_Constraint Slvs_CtxDiameter(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, double value)
+    Slvs_Constraint Slvs_CtxSameOrientation(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity entityB)
+    Slvs_Constraint Slvs_CtxAngle(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity entityB, double value, Slvs_Entity workplane, int inverse)
+    Slvs_Constraint Slvs_CtxPerpendicular(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity workplane, int inverse)
+    Slvs_Constraint Slvs_CtxParallel(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity workplane)
+    Slvs_Constraint Slvs_CtxTangent(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity entityB, Slvs_Entity workplane)
+    Slvs_Constraint Slvs_CtxDistanceProj(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity ptA, Slvs_Entity ptB, double value)
+    Slvs_Constraint Slvs_CtxLengthDiff(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity entityA, Slvs_Entity entityB, double value, Slvs_Entity workplane)
+    Slvs_Constraint Slvs_CtxDragged(Slvs_Context *ctx, Slvs_hGroup grouph, Slvs_Entity ptA, Slvs_Entity workplane)
+
+    void Slvs_CtxMarkDragged(Slvs_Context *ctx, Slvs_Entity ptA)
+    Slvs_SolveResult Slvs_CtxSolveSketch(Slvs_Context *ctx, Slvs_hGroup hg, Slvs_hConstraint **bad) nogil
+    double Slvs_CtxGetParamValue(Slvs_Context *ctx, int ph)
+    void Slvs_CtxSetParamValue(Slvs_Context *ctx, int ph, double value)
+    void Slvs_CtxClearSketch(Slvs_Context *ctx)
+
     cdef Slvs_Entity _E_NONE "SLVS_E_NONE"
     cdef Slvs_Entity _E_FREE_IN_3D "SLVS_E_FREE_IN_3D"
 
@@ -389,3 +437,167 @@ def set_param_value(ph: int, value: float):
 
 def clear_sketch():
     Slvs_ClearSketch()
+
+# contexts
+cdef class Context:
+    """An independent sketch with its own parameters, entities and constraints.
+
+    The module level functions all work on one sketch shared by the whole
+    process. Each `Context` has a sketch of its own, so several of them can
+    be built and solved from different threads at the same time; solving
+    releases the GIL. A single context must not be used from two threads at
+    once, and handles are only meaningful in the context that created them.
+    """
+    cdef Slvs_Context *ctx
+
+    def __cinit__(self):
+        self.ctx = Slvs_CreateContext()
+        if self.ctx == NULL:
+            raise MemoryError()
+
+    def __dealloc__(self):
+        if self.ctx != NULL:
+            Slvs_DestroyContext(self.ctx)
+            self.ctx = NULL
+
+    # entities
+    def add_point_2d(self, grouph: int, u: float, v: float, workplane: Slvs_Entity) -> Slvs_Entity:
+        return Slvs_CtxAddPoint2D(self.ctx, grouph, u, v, workplane)
+
+    def add_point_3d(self, grouph: int, x: float, y: float, z: float) -> Slvs_Entity:
+        return Slvs_CtxAddPoint3D(self.ctx, grouph, x, y, z)
+
+    def add_normal_2d(self, grouph: int, workplane: Slvs_Entity) -> Slvs_Entity:
+        return Slvs_CtxAddNormal2D(self.ctx, grouph, workplane)
+
+    def add_normal_3d(self, grouph: int, qw: float, qx: float, qy: float, qz: float) -> Slvs_Entity:
+        return Slvs_CtxAddNormal3D(self.ctx, grouph, qw, qx, qy, qz)
+
+    def add_distance(self, grouph: int, value: float, workplane: Slvs_Entity) -> Slvs_Entity:
+        return Slvs_CtxAddDistance(self.ctx, grouph, value, workplane)
+
+    def add_line_2d(self, grouph: int, ptA: Slvs_Entity, ptB: Slvs_Entity, workplane: Slvs_Entity) -> Slvs_Entity:
+        return Slvs_CtxAddLine2D(self.ctx, grouph, ptA, ptB, workplane)
+
+    def add_line_3d(self, grouph: int, ptA: Slvs_Entity, ptB: Slvs_Entity) -> Slvs_Entity:
+        return Slvs_CtxAddLine3D(self.ctx, grouph, ptA, ptB)
+
+    def add_cubic(self, grouph: int, ptA: Slvs_Entity, ptB: Slvs_Entity, ptC: Slvs_Entity, ptD: Slvs_Entity, workplane: Slvs_Entity) -> Slvs_Entity:
+        return Slvs_CtxAddCubic(self.ctx, grouph, ptA, ptB, ptC, ptD, workplane)
+
+    def add_arc(self, grouph: int, normal: Slvs_Entity, center: Slvs_Entity, start: Slvs_Entity, end: Slvs_Entity, workplane: Slvs_Entity) -> Slvs_Entity:
+        return Slvs_CtxAddArc(self.ctx, grouph, normal, center, start, end, workplane)
+
+    def add_circle(self, grouph: int, normal: Slvs_Entity, center: Slvs_Entity, radius: Slvs_Entity, workplane: Slvs_Entity) -> Slvs_Entity:
+        return Slvs_CtxAddCircle(self.ctx, grouph, normal, center, radius, workplane)
+
+    def add_workplane(self, grouph: int, origin: Slvs_Entity, nm: Slvs_Entity) -> Slvs_Entity:
+        return Slvs_CtxAddWorkplane(self.ctx, grouph, origin, nm)
+
+    def add_base_2d(self, grouph: int) -> Slvs_Entity:
+        return Slvs_CtxAddBase2D(self.ctx, grouph)
+
+    # constraints
+    def add_constraint(self, grouph: int, c_type: int, workplane: Slvs_Entity, val: float, ptA: Slvs_Entity = E_NONE,
+            ptB: Slvs_Entity = E_NONE, entityA: Slvs_Entity = E_NONE,
+            entityB: Slvs_Entity = E_NONE, entityC: Slvs_Entity = E_NONE,
+            entityD: Slvs_Entity = E_NONE, other: int = 0, other2: int = 0) -> Slvs_Constraint:
+        return Slvs_CtxAddConstraint(self.ctx, grouph, c_type, workplane, val, ptA, ptB, entityA, entityB, entityC, entityD, other, other2)
+
+    def coincident(self, grouph: int, entityA: Slvs_Entity, entityB: Slvs_Entity, workplane: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint:
+        return Slvs_CtxCoincident(self.ctx, grouph, entityA, entityB, workplane)
+
+    def distance(self, grouph: int, entityA: Slvs_Entity, entityB: Slvs_Entity, value: float, workplane: Slvs_Entity) -> Slvs_Constraint:
+        return Slvs_CtxDistance(self.ctx, grouph, entityA, entityB, value, workplane)
+
+    def equal(self, grouph: int, entityA: Slvs_Entity, entityB: Slvs_Entity, workplane: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint:
+        return Slvs_CtxEqual(self.ctx, grouph, entityA, entityB, workplane)
+
+    def equal_angle(self, grouph: int, entityA: Slvs_Entity, entityB: Slvs_Entity, entityC: Slvs_Entity,
+                                            entityD: Slvs_Entity,
+                                            workplane: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint:
+        return Slvs_CtxEqualAngle(self.ctx, grouph, entityA, entityB, entityC, entityD, workplane)
+
+    def equal_point_to_line(self, grouph: int, entityA: Slvs_Entity, entityB: Slvs_Entity,
+                                            entityC: Slvs_Entity, entityD: Slvs_Entity,
+                                            workplane: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint:
+        return Slvs_CtxEqualPointToLine(self.ctx, grouph, entityA, entityB, entityC, entityD, workplane)
+
+    def ratio(self, grouph: int, entityA: Slvs_Entity, entityB: Slvs_Entity, value: float, workplane: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint:
+        return Slvs_CtxRatio(self.ctx, grouph, entityA, entityB, value, workplane)
+
+    def symmetric(self, grouph: int, entityA: Slvs_Entity, entityB: Slvs_Entity, entityC: Slvs_Entity = E_NONE, workplane: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint:
+        return Slvs_CtxSymmetric(self.ctx, grouph, entityA, entityB, entityC, workplane)
+
+    def symmetric_h(self, grouph: int, ptA: Slvs_Entity, ptB: Slvs_Entity, workplane: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint:
+        return Slvs_CtxSymmetricH(self.ctx, grouph, ptA, ptB, workplane)
+
+    def symmetric_v(self, grouph: int, ptA: Slvs_Entity, ptB: Slvs_Entity, workplane: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint:
+        return Slvs_CtxSymmetricV(self.ctx, grouph, ptA, ptB, workplane)
+
+    def midpoint(self, grouph: int, ptA: Slvs_Entity, ptB: Slvs_Entity, workplane: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint:
+        return Slvs_CtxMidpoint(self.ctx, grouph, ptA, ptB, workplane)
+
+    def horizontal(self, grouph: int, entityA: Slvs_Entity, workplane: Slvs_Entity, entityB: Slvs_Entity = E_NONE) -> Slvs_Constraint:
+        return Slvs_CtxHorizontal(self.ctx, grouph, entityA, workplane, entityB)
+
+    def vertical(self, grouph: int, entityA: Slvs_Entity, workplane: Slvs_Entity, entityB: Slvs_Entity = E_NONE) -> Slvs_Constraint:
+        return Slvs_CtxVertical(self.ctx, grouph, entityA, workplane, entityB)
+
+    def diameter(self, grouph: int, entityA: Slvs_Entity, value: float) -> Slvs_Constraint:
+        return Slvs_CtxDiameter(self.ctx, grouph, entityA, value)
+
+    def same_orientation(self, grouph: int, entityA: Slvs_Entity, entityB: Slvs_Entity) -> Slvs_Constraint:
+        return Slvs_CtxSameOrientation(self.ctx, grouph, entityA, entityB)
+
+    def angle(self, grouph: int, entityA: Slvs_Entity, entityB: Slvs_Entity, value: float, workplane: Slvs_Entity = E_FREE_IN_3D, inverse: bool = False) -> Slvs_Constraint:
+        return Slvs_CtxAngle(self.ctx, grouph, entityA, entityB, value, workplane, inverse)
+
+    def perpendicular(self, grouph: int, entityA: Slvs_Entity, entityB: Slvs_Entity, workplane: Slvs_Entity = E_FREE_IN_3D, inverse: bool = False) -> Slvs_Constraint:
+        return Slvs_CtxPerpendicular(self.ctx, grouph, entityA, entityB, workplane, inverse)
+
+    def parallel(self, grouph: int, entityA: Slvs_Entity, entityB: Slvs_Entity, workplane: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint:
+        return Slvs_CtxParallel(self.ctx, grouph, entityA, entityB, workplane)
+
+    def tangent(self, grouph: int, entityA: Slvs_Entity, entityB: Slvs_Entity, workplane: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint:
+        return Slvs_CtxTangent(self.ctx, grouph, entityA, entityB, workplane)
+
+    def distance_proj(self, grouph: int, ptA: Slvs_Entity, ptB: Slvs_Entity, value: float) -> Slvs_Constraint:
+        return Slvs_CtxDistanceProj(self.ctx, grouph, ptA, ptB, value)
+
+    def length_diff(self, grouph: int, entityA: Slvs_Entity, entityB: Slvs_Entity, value: float, workplane: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint:
+        return Slvs_CtxLengthDiff(self.ctx, grouph, entityA, entityB, value, workplane)
+
+    def dragged(self, grouph: int, ptA: Slvs_Entity, workplane: Slvs_Entity = E_FREE_IN_3D) -> Slvs_Constraint:
+        return Slvs_CtxDragged(self.ctx, grouph, ptA, workplane)
+
+    # solver
+    def mark_dragged(self, ptA: Slvs_Entity):
+        Slvs_CtxMarkDragged(self.ctx, ptA)
+
+    def solve_sketch(self, grouph: int, calculateFaileds: bool):
+        cdef Slvs_hConstraint *badp = NULL
+        cdef Slvs_hGroup hg = grouph
+        cdef Slvs_SolveResult result
+        if not calculateFaileds:
+            with nogil:
+                result = Slvs_CtxSolveSketch(self.ctx, hg, NULL)
+            return result
+        else:
+            with nogil:
+                result = Slvs_CtxSolveSketch(self.ctx, hg, &badp)
+            bad = []
+            if badp != NULL:
+                for i in range(0, result.nbad):
+                    bad.append(badp[i])
+                free(badp)
+            return result, bad
+
+    def get_param_value(self, ph: int):
+        return Slvs_CtxGetParamValue(self.ctx, ph)
+
+    def set_param_value(self, ph: int, value: float):
+        Slvs_CtxSetParamValue(self.ctx, ph, value)
+
+    def clear_sketch(self):
+        Slvs_CtxClearSketch(self.ctx)
@@ -77,6 +77,8 @@ void SolveSpaceUI::Init() {
     arcDimDefaultDiameter = settings->ThawBool("ArcDimDefaultDiameter", false);
     // Show full file path in the menu bar
     showFullFilePath = settings->ThawBool("ShowFullFilePath", true);
+    // Save files in the binary encoding, rather than as text
+    saveBinaryFiles = settings->ThawBool("SaveBinaryFiles", false);
     // Rewrite exported colors close to white into black (assuming white bg)
     fixExportColors = settings->ThawBool("FixExportColors", true);
     // Export background color
@@ -268,6 +270,8 @@ void SolveSpaceUI::Exit() {
     settings->FreezeBool("ArcDimDefaultDiameter", arcDimDefaultDiameter);
     // Show full file path in the menu bar
     settings->FreezeBool("ShowFullFilePath", showFullFilePath);
+    // Save files in the binary encoding, rather than as text
+    settings->FreezeBool("SaveBinaryFiles", saveBinaryFiles);
     // Rewrite exported colors close to white into black (assuming white bg)
     settings->FreezeBool("FixExportColors", fixExportColors);
     // Export background color
@@ -547,10 +551,29 @@ void SolveSpaceUI::AfterNewFile() {
     SS.GW.projRight = {1, 0, 0};
     SS.GW.projUp    = {0, 1, 0};
 
-    GenerateAll(Generate::ALL);
+    if(useSavedGeometry) {
+        // The shell and mesh saved with the file are what we would generate,
+        // so just solve the groups and generate their entities. GenerateAll()
+        // keeps using those until an edit needs the shells of other groups.
+        GenerateAll(Generate::ALL, /*andFindFree=*/false, /*genForBBox=*/true);
+        BBox box = SK.CalculateEntityBBox(/*includeInvisibles=*/true);
+        Vector size = box.maxp.Minus(box.minp);
+        double maxSize = std::max({ size.x, size.y, size.z });
+        chordTolCalculated = maxSize * chordTol / 100.0;
+    } else {
+        GenerateAll(Generate::ALL);
+    }
 
     GW.Init();
     TW.Init();
+    if(useSavedGeometry) {
+        // The groups are solved, and what their shells would make is loaded;
+        // but activating the last group marked it dirty, for good measure.
+        for(Group &g : SK.group) {
+            g.clean = true;
+            g.runningClean = true;
+        }
+    }
 
     unsaved = false;
 
@@ -905,10 +928,12 @@ void SolveSpaceUI::MenuAnalyze(Command id) {
         case Command::INTERFERENCE: {
             SS.nakedEdges.Clear();
 
-            SMesh *m = &(SK.GetGroup(SS.GW.activeGroup)->displayMesh);
+            Group *g = SK.GetGroup(SS.GW.activeGroup);
+            const SMeshAdjacency *adj = g->DisplayMeshAdjacency();
+            SMesh *m = &(g->displayMesh);
             SKdNode *root = SKdNode::From(m);
             bool inters, leaks;
-            root->MakeCertainEdgesInto(&(SS.nakedEdges),
+            root->MakeCertainEdgesInto(*adj, &(SS.nakedEdges),
                 EdgeKind::SELF_INTER, /*coplanarIsInter=*/false, &inters, &leaks);
 
             SS.GW.Invalidate();
@@ -1070,10 +1095,11 @@ void SolveSpaceUI::ShowNakedEdges(bool reportOnlyWhenNotOkay) {
     SS.nakedEdges.Clear();
 
     Group *g = SK.GetGroup(SS.GW.activeGroup);
+    const SMeshAdjacency *adj = g->DisplayMeshAdjacency();
     SMesh *m = &(g->displayMesh);
     SKdNode *root = SKdNode::From(m);
     bool inters, leaks;
-    root->MakeCertainEdgesInto(&(SS.nakedEdges),
+    root->MakeCertainEdgesInto(*adj, &(SS.nakedEdges),
         EdgeKind::NAKED_OR_SELF_INTER, /*coplanarIsInter=*/true, &inters, &leaks);
 
     if(reportOnlyWhenNotOkay && !inters && !leaks && SS.nakedEdges.l.IsEmpty()) {
@@ -1134,10 +1160,8 @@ PACKAGE_VERSION, 2026);
 
 void SolveSpaceUI::Clear() {
     sys.Clear();
-    for(int i = 0; i < MAX_UNDO; i++) {
-        if(i < undo.cnt) undo.d[i].Clear();
-        if(i < redo.cnt) redo.d[i].Clear();
-    }
+    UndoClearStack(&undo);
+    UndoClearStack(&redo);
     TW.window = NULL;
     GW.openRecentMenu = NULL;
     GW.linkRecentMenu = NULL;
@@ -47,8 +47,7 @@ enum class SolveResult : uint32_t {
     OKAY                     = 0,
     DIDNT_CONVERGE           = 10,
     REDUNDANT_OKAY           = 11,
-    REDUNDANT_DIDNT_CONVERGE = 12,
-    TOO_MANY_UNKNOWNS        = 20
+    REDUNDANT_DIDNT_CONVERGE = 12
 };
 
 // Utility functions that are provided in the platform-independent code.
@@ -80,7 +79,9 @@ public:
 
 class System {
 public:
-    enum { MAX_UNKNOWNS = 2048 };
+    // Past this many equations, the least squares step is found with a
+    // sparse Cholesky factorization instead of a sparse QR.
+    enum { MAX_DIRECT_UNKNOWNS = 2048 };
 
     EntityList                      entity;
     ParamList                       param;
@@ -97,6 +98,30 @@ public:
         VAR_DOF_TEST         = 10001,
         // and for equations:
         EQ_SUBSTITUTED       = 20000
+        // Independent clusters of both are tagged -1, -2, ...
+    };
+
+    struct JacobianEntry {
+        int      row, col;
+        uint32_t slot;
+    };
+
+    // The residuals and then the partials, compiled together so that the
+    // whole system can be evaluated in one pass.
+    struct CompiledJacobian {
+        ExprTape                    code;
+        // Slot of each residual; these all come before residualEnd
+        std::vector<uint32_t>       B;
+        size_t                      residualEnd;
+        // Slot of each nonzero partial, in column order
+        std::vector<JacobianEntry>  A;
+        // The params that were known, and so compiled in as constants, with
+        // their values at the time
+        std::vector<std::pair<hParam, double>> known;
+    };
+
+    struct SignatureHasher {
+        size_t operator()(const std::vector<uint64_t> &sig) const;
     };
 
     // The system Jacobian matrix
@@ -110,7 +135,8 @@ public:
         // We're solving AX = B
         int m, n;
         struct {
-            // This only observes the Expr - does not own them!
+            // This only observes the Expr - does not own them! Both sym
+            // members are left empty if the tape came from the cache.
             Eigen::SparseMatrix<Expr *> sym;
             Eigen::SparseMatrix<double> num;
         } A;
@@ -122,26 +148,52 @@ public:
             std::vector<Expr *> sym;
             Eigen::VectorXd     num;
         } B;
+
+        CompiledJacobian tape;
     } mat;
 
+    // Jacobians compiled for earlier solves, by the structure of the system
+    // they were written for; re-solving a system whose structure didn't
+    // change (e.g. while dragging) then only has to evaluate it. Only the
+    // clusters and the rank test go in, not the one-off systems of a single
+    // equation or of a probe for free params. The size is in bytes, counting
+    // the keys.
+    std::unordered_map<std::vector<uint64_t>, CompiledJacobian, SignatureHasher>
+                                    jacobianCache;
+    size_t                          jacobianCacheSize = 0;
+
+    // The expressions written while solving live in these arenas: those of
+    // the equations until the next solve, and those of the symbolic Jacobian
+    // until the next one is written.
+    ExprArena                       eqArena;
+    ExprArena                       jacobianArena;
+
     static const double CONVERGE_TOLERANCE;
+    static const double LEAST_SQUARES_SHIFT;
+    static const double RANK_PIVOT_TOLERANCE;
     int CalculateRank();
     bool TestRank(int *dof = NULL, int *rank = NULL);
     static bool SolveLinearSystem(const Eigen::SparseMatrix<double> &A,
                                   const Eigen::VectorXd &B, Eigen::VectorXd *X);
     bool SolveLeastSquares();
 
-    bool WriteJacobian(int tag);
+    void WriteJacobian(int tag, bool useCache = false);
+    void WriteJacobianSignature(std::vector<uint64_t> *sig);
+    bool KnownParamsUnchanged(const CompiledJacobian &cj);
+    void CompileJacobian();
     void EvalJacobian();
+    void EvalResiduals();
 
     void WriteEquationsExceptFor(hConstraint hc, Group *g);
     void FindWhichToRemoveToFixJacobian(Group *g, List<hConstraint> *bad,
                                         bool forceDofCheck);
     SubstitutionMap SolveBySubstitution();
+    int TagClusters();
 
     bool IsDragged(hParam p);
 
     bool NewtonSolve();
+    void MarkUnsatisfied(List<hConstraint> *bad);
 
     void MarkParamsFree(bool findFree);
 
@@ -405,7 +457,7 @@ public:
     IdList<Style,hStyle>            style;
 
     // These are generated from the above.
-    IdList<ENTITY,hEntity>          entity;
+    IdList<ENTITY,hEntity,IdIndex::HASHED> entity;
     ParamList                       param;
 
     inline CONSTRAINT *GetConstraint(hConstraint h)
@@ -430,7 +482,9 @@ public:
     TextWindow                 &TW;
     GraphicsWindow              GW;
 
-    // The state for undo/redo
+    // The state for undo/redo. Only the most recent state on each stack is
+    // kept in full; each one before it is kept as the records that differ
+    // from the state after it.
     typedef struct UndoState {
         IdList<Group,hGroup>            group;
         List<hGroup>                    groupOrder;
@@ -442,15 +496,36 @@ public:
 
         void Clear() {
             group.Clear();
+            groupOrder.Clear();
             request.Clear();
             constraint.Clear();
             param.Clear();
             style.Clear();
         }
     } UndoState;
+    typedef struct UndoDelta {
+        // The records to put back, replacing any with the same handle...
+        UndoState                       changed;
+        // ...and the handles of those to remove.
+        std::vector<hGroup>             removedGroup;
+        std::vector<hRequest>           removedRequest;
+        std::vector<hConstraint>        removedConstraint;
+        std::vector<hParam>             removedParam;
+        std::vector<hStyle>             removedStyle;
+
+        void Clear() {
+            changed.Clear();
+            removedGroup.clear();
+            removedRequest.clear();
+            removedConstraint.clear();
+            removedParam.clear();
+            removedStyle.clear();
+        }
+    } UndoDelta;
     enum { MAX_UNDO = 100 };
     typedef struct {
-        UndoState   d[MAX_UNDO];
+        UndoState   top;
+        UndoDelta   d[MAX_UNDO];
         int         cnt;
         int         write;
     } UndoStack;
@@ -467,8 +542,8 @@ public:
     void UndoRedo();
     void PushFromCurrentOnto(UndoStack *uk);
     void PopOntoCurrentFrom(UndoStack *uk);
-    void UndoClearState(UndoState *ut);
     void UndoClearStack(UndoStack *uk);
+    size_t UndoMemoryUsage();
 
     // Little bits of extra configuration state
     enum { MODEL_COLORS = 8 };
@@ -489,6 +564,7 @@ public:
     double   exportOffset;
     bool     arcDimDefaultDiameter;
     bool     showFullFilePath;
+    bool     saveBinaryFiles;
     bool     fixExportColors;
     bool     exportBackgroundColor;
     bool     drawBackFaces;
@@ -566,6 +642,9 @@ public:
     void AddToRecentList(const Platform::Path &filename);
     Platform::Path saveFile;
     bool        fileLoadError;
+    // Set while the last group's running shell and mesh are the ones loaded
+    // with the file, and no group has generated its own.
+    bool        useSavedGeometry;
     bool        unsaved;
     typedef struct {
         char        type;
@@ -603,11 +682,19 @@ public:
     std::function<void(const Platform::Path &filename, bool is_saveAs, bool is_autosave)> OnSaveFinished;
     bool LoadFromFile(const Platform::Path &filename, bool canCancel = false);
     void UpgradeLegacyData();
-    bool LoadEntitiesFromFile(const Platform::Path &filename, EntityList *le,
-                              SMesh *m, SShell *sh);
-    bool LoadEntitiesFromSlvs(const Platform::Path &filename, EntityList *le,
-                              SMesh *m, SShell *sh);
+    bool LoadEntitiesFromFile(const Platform::Path &filename, LinkedPart *lp);
+    bool LoadEntitiesFromSlvs(const Platform::Path &filename, LinkedPart *lp);
     bool ReloadAllLinked(const Platform::Path &filename, bool canCancel = false);
+    // Every linked file that is loaded, parsed only once and then shared by
+    // all the groups that link it; parsed again only if the file changes.
+    struct LinkedPartEntry {
+        Platform::FileStamp         stamp;
+        uint64_t                    hash;
+        double                      chordTol;   // for outlines approximated to it
+        std::shared_ptr<LinkedPart> part;
+    };
+    std::map<Platform::Path, LinkedPartEntry, Platform::PathLess> linkedParts;
+    std::shared_ptr<LinkedPart> LoadLinkedPart(const Platform::Path &filename);
     // And the various export options
     void ExportAsPngTo(const Platform::Path &filename);
     void ExportMeshTo(const Platform::Path &filename);
@@ -693,6 +780,8 @@ public:
     SolveResult TestRankForGroup(hGroup hg, int *rank = NULL);
     void WriteEqSystemForGroup(hGroup hg);
     void MarkDraggedParams();
+    void GenerateShellsAndMeshes(const std::vector<hGroup> &thisShells,
+                                 const std::vector<hGroup> &runningShells);
     void ForceReferences();
     void UpdateCenterOfMass();
 
@@ -742,7 +831,14 @@ bool LinkIDF(const Platform::Path &filename, EntityList *le, SMesh *m, SShell *s
 bool LinkStl(const Platform::Path &filename, EntityList *le, SMesh *m, SShell *sh);
 
 extern SolveSpaceUI SS;
+#if defined(LIBRARY)
+// The library can hold several independent sketches at once (one per
+// Slvs_Context); the solver always works on the one current for this thread.
+extern thread_local Sketch *CurrentSketch;
+#   define SK (*SolveSpace::CurrentSketch)
+#else
 extern Sketch SK;
+#endif
 
 } // namespace SolveSpace
 
@@ -8,8 +8,6 @@
 
 namespace SolveSpace {
 
-static int I;
-
 void SShell::MakeFromUnionOf(SShell *a, SShell *b) {
     MakeFromBoolean(a, b, SSurface::CombineAs::UNION);
 }
@@ -544,21 +542,22 @@ SSurface SSurface::MakeCopyTrimAgainst(SShell *parent,
             if(sc.surfB != h) continue;
             ss = sha->surface.FindById(sc.surfA);
         }
+        SProjectionGuess sguess = {}, tguess = {};
         int i;
         for(i = 1; i < sc.pts.n; i++) {
             Vector a = sc.pts[i-1].p,
                    b = sc.pts[i].p;
 
             Point2d auv, buv;
-            ss->ClosestPointTo(a, &(auv.x), &(auv.y));
-            ss->ClosestPointTo(b, &(buv.x), &(buv.y));
+            ss->ClosestPointTo(a, &(auv.x), &(auv.y), /*mustConverge=*/true, &sguess);
+            ss->ClosestPointTo(b, &(buv.x), &(buv.y), /*mustConverge=*/true, &sguess);
 
             SBspUv::Class c = (ss->bsp) ? ss->bsp->ClassifyEdge(auv, buv, ss) : SBspUv::Class::OUTSIDE;
             if(c != SBspUv::Class::OUTSIDE) {
                 Vector ta = {};
                 Vector tb = {};
-                ret.ClosestPointTo(a, &(ta.x), &(ta.y));
-                ret.ClosestPointTo(b, &(tb.x), &(tb.y));
+                ret.ClosestPointTo(a, &(ta.x), &(ta.y), /*mustConverge=*/true, &tguess);
+                ret.ClosestPointTo(b, &(tb.x), &(tb.y), /*mustConverge=*/true, &tguess);
 
                 Vector tn = ret.NormalAt(ta.x, ta.y);
                 Vector sn = ss->NormalAt(auv.x, auv.y);
@@ -649,7 +648,7 @@ SSurface SSurface::MakeCopyTrimAgainst(SShell *parent,
                                 ret.PointAt(auv), ret.PointAt(buv), pt,
                                 enin, enout, surfn))
         {
-            dbp("MakeCopyTrimAgainst: failed to classify orig edge (I=%d)", I+dbg_index);
+            dbp("MakeCopyTrimAgainst: failed to classify orig edge (I=%d)", dbg_index);
         }
 
         if(KeepEdge(type, opA, indir_shell, outdir_shell,
@@ -707,7 +706,7 @@ SSurface SSurface::MakeCopyTrimAgainst(SShell *parent,
                                 ret.PointAt(auv), ret.PointAt(buv), pt,
                                 enin, enout, surfn))
         {
-            dbp("MakeCopyTrimAgainst: failed to classify inter edge (I=%d)", I+dbg_index);
+            dbp("MakeCopyTrimAgainst: failed to classify inter edge (I=%d)", dbg_index);
         }
 
         if(KeepEdge(type, opA, indir_shell, outdir_shell,
@@ -735,7 +734,7 @@ SSurface SSurface::MakeCopyTrimAgainst(SShell *parent,
 #pragma omp critical
     {
         into->booleanFailed = true;
-        dbp("failed: I=%d, avoid=%d", I+dbg_index, choosing.l.n);
+        dbp("failed: I=%d, avoid=%d", dbg_index, choosing.l.n);
         DEBUGEDGELIST(&final, &ret);
     }
     poly.Clear();
@@ -749,30 +748,175 @@ SSurface SSurface::MakeCopyTrimAgainst(SShell *parent,
 
 void SShell::CopySurfacesTrimAgainst(SShell *sha, SShell *shb, SShell *into, SSurface::CombineAs type) {
     std::vector <SSurface> ssn(surface.n);
+    // For debugging, number the surfaces of both shells in turn.
+    int dbg_first = (this == shb) ? sha->surface.n : 0;
 #pragma omp parallel for
     for (int i = 0; i < surface.n; i++)
     {
         SSurface *ss = &surface[i];
-        ssn[i] = ss->MakeCopyTrimAgainst(this, sha, shb, into, type, i);
+        ssn[i] = ss->MakeCopyTrimAgainst(this, sha, shb, into, type, dbg_first + i);
     }
 
     for (int i = 0; i < surface.n; i++)
     {
         surface[i].newH = into->surface.AddAndAssignId(&ssn[i]);
     }
-    I += surface.n;
+}
+
+//-----------------------------------------------------------------------------
+// Build the hierarchy, splitting the surfaces at the median of the centers of
+// their boxes along the longest axis, until the leaves are small.
+//-----------------------------------------------------------------------------
+void SShellBvh::Build(SShell *shell) {
+    static const uint32_t LEAF_SIZE = 4;
+
+    Clear();
+    if(shell->surface.IsEmpty()) return;
+
+    std::vector<Vector> center;
+    center.reserve(shell->surface.n);
+    for(SSurface &ss : shell->surface) {
+        Vector smax, smin;
+        ss.GetTrimmedBounding(shell, &smax, &smin);
+        maxp.push_back(smax);
+        minp.push_back(smin);
+        center.push_back(smax.Plus(smin).ScaledBy(0.5));
+        surfaces.push_back((uint32_t)surfaces.size());
+    }
+
+    Node root = {};
+    root.count = (uint32_t)surfaces.size();
+    nodes.push_back(root);
+
+    // Nodes whose surfaces are yet to be bounded, and maybe split.
+    std::vector<uint32_t> pending = { 0 };
+    while(!pending.empty()) {
+        uint32_t ni = pending.back();
+        pending.pop_back();
+        uint32_t first = nodes[ni].first,
+                 count = nodes[ni].count;
+
+        Vector nmax = Vector::From(VERY_NEGATIVE, VERY_NEGATIVE, VERY_NEGATIVE),
+               nmin = Vector::From(VERY_POSITIVE, VERY_POSITIVE, VERY_POSITIVE),
+               cmax = nmax,
+               cmin = nmin;
+        for(uint32_t k = first; k < first + count; k++) {
+            maxp[surfaces[k]].MakeMaxMin(&nmax, &nmin);
+            minp[surfaces[k]].MakeMaxMin(&nmax, &nmin);
+            center[surfaces[k]].MakeMaxMin(&cmax, &cmin);
+        }
+        nodes[ni].maxp = nmax;
+        nodes[ni].minp = nmin;
+
+        if(count <= LEAF_SIZE) continue;
+
+        Vector extent = cmax.Minus(cmin);
+        int axis = (extent.x > extent.y) ? ((extent.x > extent.z) ? 0 : 2)
+                                         : ((extent.y > extent.z) ? 1 : 2);
+        if(extent.Element(axis) <= 0.0) continue;
+
+        uint32_t half = count / 2;
+        std::nth_element(surfaces.begin() + first, surfaces.begin() + first + half,
+                         surfaces.begin() + first + count,
+            [&](uint32_t a, uint32_t b) {
+                return center[a].Element(axis) < center[b].Element(axis);
+            });
+
+        uint32_t child = (uint32_t)nodes.size();
+        nodes[ni].first = child;
+        nodes[ni].count = 0;
+
+        Node lo = {}, hi = {};
+        lo.first = first;
+        lo.count = half;
+        hi.first = first + half;
+        hi.count = count - half;
+        nodes.push_back(lo);
+        nodes.push_back(hi);
+        pending.push_back(child);
+        pending.push_back(child + 1);
+    }
+}
+
+void SShellBvh::Clear() {
+    nodes.clear();
+    surfaces.clear();
+    minp.clear();
+    maxp.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Find every pair of a surface from our shell and one from b whose boxes
+// overlap, by descending both hierarchies together; always into the bigger
+// of the two nodes, so that they stay about the same size.
+//-----------------------------------------------------------------------------
+void SShellBvh::FindOverlapsWith(const SShellBvh *b,
+                                 std::vector<std::pair<uint32_t, uint32_t>> *pairs) const
+{
+    if(nodes.empty() || b->nodes.empty()) return;
+
+    std::vector<std::pair<uint32_t, uint32_t>> stack = { { 0, 0 } };
+    while(!stack.empty()) {
+        uint32_t ia = stack.back().first,
+                 ib = stack.back().second;
+        stack.pop_back();
+        const Node &na = nodes[ia],
+                   &nb = b->nodes[ib];
+        if(Vector::BoundingBoxesDisjoint(na.maxp, na.minp, nb.maxp, nb.minp)) continue;
+
+        if(na.count > 0 && nb.count > 0) {
+            for(uint32_t ka = na.first; ka < na.first + na.count; ka++) {
+                uint32_t sa = surfaces[ka];
+                for(uint32_t kb = nb.first; kb < nb.first + nb.count; kb++) {
+                    uint32_t sb = b->surfaces[kb];
+                    if(Vector::BoundingBoxesDisjoint(maxp[sa], minp[sa],
+                                                     b->maxp[sb], b->minp[sb])) continue;
+                    pairs->emplace_back(sa, sb);
+                }
+            }
+            continue;
+        }
+
+        Vector ea = na.maxp.Minus(na.minp),
+               eb = nb.maxp.Minus(nb.minp);
+        bool splitA = (nb.count > 0) ||
+                      (na.count == 0 && ea.x + ea.y + ea.z > eb.x + eb.y + eb.z);
+        if(splitA) {
+            stack.emplace_back(na.first, ib);
+            stack.emplace_back(na.first + 1, ib);
+        } else {
+            stack.emplace_back(ia, nb.first);
+            stack.emplace_back(ia, nb.first + 1);
+        }
+    }
 }
 
 void SShell::MakeIntersectionCurvesAgainst(SShell *agnst, SShell *into) {
+    // Intersect every surface from our shell against every surface from
+    // agnst whose bounding box it overlaps; the rest cannot possibly
+    // intersect it. Each pair will add zero or more curves to the curve list
+    // for into, in the same order as if we'd tried them all.
+    SShellBvh bvh, agnstBvh;
+    bvh.Build(this);
+    agnstBvh.Build(agnst);
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    bvh.FindOverlapsWith(&agnstBvh, &pairs);
+    std::sort(pairs.begin(), pairs.end());
+
+    std::vector<size_t> firstPair(surface.n + 1, pairs.size());
+    for(size_t k = pairs.size(); k > 0; k--) {
+        firstPair[pairs[k - 1].first] = k - 1;
+    }
+    for(int i = surface.n - 1; i >= 0; i--) {
+        firstPair[i] = min(firstPair[i], firstPair[i + 1]);
+    }
+
 #pragma omp parallel for
     for(int i = 0; i< surface.n; i++) {
         SSurface *sa = &surface[i];
 
-        for(SSurface &sb : agnst->surface){
-            // Intersect every surface from our shell against every surface
-            // from agnst; this will add zero or more curves to the curve
-            // list for into.
-            sa->IntersectAgainst(&sb, this, agnst, into);
+        for(size_t k = firstPair[i]; k < firstPair[i + 1]; k++) {
+            sa->IntersectAgainst(&agnst->surface[pairs[k].second], this, agnst, into);
         }
     }
 }
@@ -878,11 +1022,6 @@ void SShell::MakeFromBoolean(SShell *a, SShell *b, SSurface::CombineAs type) {
     a->MakeClassifyingBsps(this);
     b->MakeClassifyingBsps(this);
 
-    if(b->surface.IsEmpty() || a->surface.IsEmpty()) {
-        I = 1000000;
-    } else {
-        I = 0;
-    }
     // Then trim and copy the surfaces
     a->CopySurfacesTrimAgainst(a, b, this, type);
     b->CopySurfacesTrimAgainst(a, b, this, type);
@@ -908,6 +1047,9 @@ void SShell::MakeClassifyingBsps(SShell *useCurvesFrom) {
 }
 
 void SSurface::MakeClassifyingBsp(SShell *shell, SShell *useCurvesFrom) {
+    // First, so that projecting the edges below can use it too.
+    MakeSampleGrid();
+
     SEdgeList el = {};
 
     MakeEdgesInto(shell, &el, MakeAs::UV, useCurvesFrom);
@@ -619,10 +619,11 @@ void SBezierLoopSetSet::FindOuterFacesFrom(SBezierList *sbl, SPolygon *spxyz,
     SContour *sc;
     for(sc = spxyz->l.First(); sc; sc = spxyz->l.NextAfter(sc)) {
         spuv.AddEmptyContour();
+        SProjectionGuess guess = {};
         SPoint *pt;
         for(pt = sc->l.First(); pt; pt = sc->l.NextAfter(pt)) {
             double u, v;
-            srfuv->ClosestPointTo(pt->p, &u, &v);
+            srfuv->ClosestPointTo(pt->p, &u, &v, /*mustConverge=*/true, &guess);
             spuv.l.Last()->AddPoint({u, v, 0});
         }
     }
@@ -808,6 +809,7 @@ void SCurve::RemoveShortSegments(SSurface *srfA, SSurface *srfB) {
     pts.ClearTags();
 
     Vector prev = pts[0].p;
+    SProjectionGuess guess[2] = {};
     double tprev = 0;
     double t = 0;
     double tnext = 0;
@@ -845,8 +847,8 @@ void SCurve::RemoveShortSegments(SSurface *srfA, SSurface *srfB) {
         for(a = 0; a < 2; a++) {
             SSurface *srf = (a == 0) ? srfA : srfB;
             Vector puv, nuv;
-            srf->ClosestPointTo(prev,   &(puv.x), &(puv.y));
-            srf->ClosestPointTo(scn->p, &(nuv.x), &(nuv.y));
+            srf->ClosestPointTo(prev,   &(puv.x), &(puv.y), /*mustConverge=*/true, &guess[a]);
+            srf->ClosestPointTo(scn->p, &(nuv.x), &(nuv.y), /*mustConverge=*/true, &guess[a]);
 
             if(srf->ChordToleranceForEdge(nuv, puv) > SS.ChordTolMm() ) {
                 mustKeep = true;
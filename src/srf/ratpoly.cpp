@@ -38,6 +38,36 @@ static inline double BernsteinDerivative(int k, int deg, double t) {
     return ((c[2]*t)+c[1])*t+c[0];
 }
 
+//-----------------------------------------------------------------------------
+// For the batched evaluations, we take the parameters a block at a time and
+// tabulate the Bernstein basis for all of them first. The sums are then kept
+// as a separate array for each coordinate, so the loops over a block have no
+// dependencies between their iterations, and the compiler can vectorize them.
+// The arithmetic for each point is the same as when evaluating just that one,
+// so the results are too.
+//-----------------------------------------------------------------------------
+static const size_t EVAL_BLOCK = 64;
+
+static inline void BernsteinBlock(int deg, const double *t, size_t n,
+                                  double B[4][EVAL_BLOCK]) {
+    for(int i = 0; i <= deg; i++) {
+#pragma omp simd
+        for(size_t k = 0; k < n; k++) {
+            B[i][k] = Bernstein(i, deg, t[k]);
+        }
+    }
+}
+
+static inline void BernsteinDerivativeBlock(int deg, const double *t, size_t n,
+                                            double B[4][EVAL_BLOCK]) {
+    for(int i = 0; i <= deg; i++) {
+#pragma omp simd
+        for(size_t k = 0; k < n; k++) {
+            B[i][k] = BernsteinDerivative(i, deg, t[k]);
+        }
+    }
+}
+
 Vector SBezier::PointAt(double t) const {
     Vector pt = {};
     double d = 0;
@@ -75,15 +105,48 @@ Vector SBezier::TangentAt(double t) const {
     return ret;
 }
 
+void SBezier::PointsAt(const double *t, Vector *pt, size_t n) const {
+    for(size_t k0 = 0; k0 < n; k0 += EVAL_BLOCK) {
+        size_t m = min(EVAL_BLOCK, n - k0);
+        double B[4][EVAL_BLOCK];
+        BernsteinBlock(deg, t + k0, m, B);
+
+        double x[EVAL_BLOCK] = {}, y[EVAL_BLOCK] = {}, z[EVAL_BLOCK] = {},
+               d[EVAL_BLOCK] = {};
+        for(int i = 0; i <= deg; i++) {
+            Vector c = ctrl[i];
+            double w = weight[i];
+#pragma omp simd
+            for(size_t k = 0; k < m; k++) {
+                double s = B[i][k]*w;
+                x[k] += c.x*s;
+                y[k] += c.y*s;
+                z[k] += c.z*s;
+                d[k] += w*B[i][k];
+            }
+        }
+        for(size_t k = 0; k < m; k++) {
+            double s = 1.0/d[k];
+            pt[k0 + k] = Vector::From(x[k]*s, y[k]*s, z[k]*s);
+        }
+    }
+}
+
 void SBezier::ClosestPointTo(Vector p, double *t, bool mustConverge) const {
     int i;
     double minDist = VERY_POSITIVE;
     *t = 0;
     double res = (deg <= 2) ? 7.0 : 20.0;
+    double tryts[20];
+    Vector tryps[20];
+    for(i = 0; i < (int)res; i++) {
+        tryts[i] = (i/res);
+    }
+    PointsAt(tryts, tryps, (size_t)res);
     for(i = 0; i < (int)res; i++) {
-        double tryt = (i/res);
+        double tryt = tryts[i];
 
-        Vector tryp = PointAt(tryt);
+        Vector tryp = tryps[i];
         double d = (tryp.Minus(p)).Magnitude();
         if(d < minDist) {
             *t = tryt;
@@ -380,11 +443,166 @@ Vector SSurface::NormalAt(double u, double v) const {
     return tu.Cross(tv);
 }
 
-void SSurface::ClosestPointTo(Vector p, Point2d *puv, bool mustConverge) {
-    ClosestPointTo(p, &(puv->x), &(puv->y), mustConverge);
+void SSurface::PointsAt(const Point2d *puv, Vector *pt, size_t n) const {
+    for(size_t k0 = 0; k0 < n; k0 += EVAL_BLOCK) {
+        size_t m = min(EVAL_BLOCK, n - k0);
+        double u[EVAL_BLOCK], v[EVAL_BLOCK];
+        for(size_t k = 0; k < m; k++) {
+            u[k] = puv[k0 + k].x;
+            v[k] = puv[k0 + k].y;
+        }
+        double Bu[4][EVAL_BLOCK], Bv[4][EVAL_BLOCK];
+        BernsteinBlock(degm, u, m, Bu);
+        BernsteinBlock(degn, v, m, Bv);
+
+        double x[EVAL_BLOCK] = {}, y[EVAL_BLOCK] = {}, z[EVAL_BLOCK] = {},
+               d[EVAL_BLOCK] = {};
+        for(int i = 0; i <= degm; i++) {
+            for(int j = 0; j <= degn; j++) {
+                Vector c = ctrl[i][j];
+                double w = weight[i][j];
+#pragma omp simd
+                for(size_t k = 0; k < m; k++) {
+                    double s = Bu[i][k]*Bv[j][k]*w;
+                    x[k] += c.x*s;
+                    y[k] += c.y*s;
+                    z[k] += c.z*s;
+                    d[k] += w*Bu[i][k]*Bv[j][k];
+                }
+            }
+        }
+        for(size_t k = 0; k < m; k++) {
+            double s = 1.0/d[k];
+            pt[k0 + k] = Vector::From(x[k]*s, y[k]*s, z[k]*s);
+        }
+    }
+}
+
+void SSurface::TangentsAt(const Point2d *puv, Vector *tu, Vector *tv, size_t n) const {
+    for(size_t k0 = 0; k0 < n; k0 += EVAL_BLOCK) {
+        size_t m = min(EVAL_BLOCK, n - k0);
+        double u[EVAL_BLOCK], v[EVAL_BLOCK];
+        for(size_t k = 0; k < m; k++) {
+            u[k] = puv[k0 + k].x;
+            v[k] = puv[k0 + k].y;
+        }
+        double Bu[4][EVAL_BLOCK], Bv[4][EVAL_BLOCK],
+               Bup[4][EVAL_BLOCK], Bvp[4][EVAL_BLOCK];
+        BernsteinBlock(degm, u, m, Bu);
+        BernsteinBlock(degn, v, m, Bv);
+        BernsteinDerivativeBlock(degm, u, m, Bup);
+        BernsteinDerivativeBlock(degn, v, m, Bvp);
+
+        double x[EVAL_BLOCK]  = {}, y[EVAL_BLOCK]  = {}, z[EVAL_BLOCK]  = {},
+               d[EVAL_BLOCK]  = {},
+               xu[EVAL_BLOCK] = {}, yu[EVAL_BLOCK] = {}, zu[EVAL_BLOCK] = {},
+               du[EVAL_BLOCK] = {},
+               xv[EVAL_BLOCK] = {}, yv[EVAL_BLOCK] = {}, zv[EVAL_BLOCK] = {},
+               dv[EVAL_BLOCK] = {};
+        for(int i = 0; i <= degm; i++) {
+            for(int j = 0; j <= degn; j++) {
+                Vector c = ctrl[i][j];
+                double w = weight[i][j];
+#pragma omp simd
+                for(size_t k = 0; k < m; k++) {
+                    double Bi  = Bu[i][k],  Bj  = Bv[j][k],
+                           Bip = Bup[i][k], Bjp = Bvp[j][k];
+
+                    double s = Bi*Bj*w;
+                    x[k] += c.x*s;
+                    y[k] += c.y*s;
+                    z[k] += c.z*s;
+                    d[k] += w*Bi*Bj;
+
+                    double su = Bip*Bj*w;
+                    xu[k] += c.x*su;
+                    yu[k] += c.y*su;
+                    zu[k] += c.z*su;
+                    du[k] += w*Bip*Bj;
+
+                    double sv = Bi*Bjp*w;
+                    xv[k] += c.x*sv;
+                    yv[k] += c.y*sv;
+                    zv[k] += c.z*sv;
+                    dv[k] += w*Bi*Bjp;
+                }
+            }
+        }
+        for(size_t k = 0; k < m; k++) {
+            // quotient rule; f(t) = n(t)/d(t), so f' = (n'*d - n*d')/(d^2)
+            double s = 1.0/(d[k]*d[k]);
+            Vector ttu = Vector::From(xu[k]*d[k] - x[k]*du[k],
+                                      yu[k]*d[k] - y[k]*du[k],
+                                      zu[k]*d[k] - z[k]*du[k]).ScaledBy(s),
+                   ttv = Vector::From(xv[k]*d[k] - x[k]*dv[k],
+                                      yv[k]*d[k] - y[k]*dv[k],
+                                      zv[k]*d[k] - z[k]*dv[k]).ScaledBy(s);
+            if(ttu.Equals({0, 0, 0}) || ttv.Equals({0, 0, 0})) {
+                // A singularity, so let the single point version retry.
+                TangentsAt(u[k], v[k], &ttu, &ttv);
+            }
+            tu[k0 + k] = ttu;
+            tv[k0 + k] = ttv;
+        }
+    }
+}
+
+void SSurface::NormalsAt(const Point2d *puv, Vector *nv, size_t n) const {
+    for(size_t k0 = 0; k0 < n; k0 += EVAL_BLOCK) {
+        size_t m = min(EVAL_BLOCK, n - k0);
+        Vector tu[EVAL_BLOCK], tv[EVAL_BLOCK];
+        TangentsAt(puv + k0, tu, tv, m);
+        for(size_t k = 0; k < m; k++) {
+            nv[k0 + k] = tu[k].Cross(tv[k]);
+        }
+    }
+}
+
+// Planes are trivial to project into, so they get no sample grid.
+static bool IsParallelogram(const SSurface *srf) {
+    if(srf->degm != 1 || srf->degn != 1) return false;
+    Vector orig = srf->ctrl[0][0],
+           bu   = (srf->ctrl[1][0]).Minus(orig),
+           bv   = (srf->ctrl[0][1]).Minus(orig);
+    return (srf->ctrl[1][1]).Equals(orig.Plus(bu).Plus(bv));
+}
+
+static int SampleGridSize(const SSurface *srf) {
+    return (max(srf->degm, srf->degn) == 2) ? 7 : 20;
+}
+
+static void SampleGridInto(const SSurface *srf, Vector *pts) {
+    int res = SampleGridSize(srf);
+    Point2d trys[20*20];
+    for(int i = 0; i < res; i++) {
+        for(int j = 0; j < res; j++) {
+            trys[i*res + j] = Point2d::From((i + 0.5)/res, (j + 0.5)/res);
+        }
+    }
+    srf->PointsAt(trys, pts, res*res);
+}
+
+void SSurface::MakeSampleGrid() {
+    if(IsParallelogram(this)) {
+        samples.reset();
+        return;
+    }
+    int res = SampleGridSize(this);
+    std::shared_ptr<std::vector<Vector>> grid =
+        std::make_shared<std::vector<Vector>>(res*res);
+    SampleGridInto(this, grid->data());
+    samples = grid;
+}
+
+void SSurface::ClosestPointTo(Vector p, Point2d *puv, bool mustConverge,
+                              SProjectionGuess *guess) const
+{
+    ClosestPointTo(p, &(puv->x), &(puv->y), mustConverge, guess);
 }
 
-void SSurface::ClosestPointTo(Vector p, double *u, double *v, bool mustConverge) {
+void SSurface::ClosestPointTo(Vector p, double *u, double *v, bool mustConverge,
+                              SProjectionGuess *guess) const
+{
     // A few special cases first; when control points are coincident the
     // derivative goes to zero at the control points, and would result in
     // nonconvergence. We avoid that here, and also guarantee a consistent
@@ -395,57 +613,63 @@ void SSurface::ClosestPointTo(Vector p, double *u, double *v, bool mustConverge)
     if(p.Equals(ctrl[0]   [degn])) { *u = 0; *v = 1; return; }
 
     // And planes are trivial, so don't waste time iterating over those.
-    if(degm == 1 && degn == 1) {
+    if(IsParallelogram(this)) {
         Vector orig =  ctrl[0][0],
                bu   = (ctrl[1][0]).Minus(orig),
                bv   = (ctrl[0][1]).Minus(orig);
-        if((ctrl[1][1]).Equals(orig.Plus(bu).Plus(bv))) {
 
-            Vector n = bu.Cross(bv);
-            Vector ty = n.Cross(bu).ScaledBy(1.0/bu.MagSquared());
-            Vector tx = bv.Cross(n).ScaledBy(1.0/bv.MagSquared());
+        Vector n = bu.Cross(bv);
+        Vector ty = n.Cross(bu).ScaledBy(1.0/bu.MagSquared());
+        Vector tx = bv.Cross(n).ScaledBy(1.0/bv.MagSquared());
 
-            Vector dp = p.Minus(orig);
-            *u = dp.Dot(bu) / tx.MagSquared();
-            *v = dp.Dot(bv) / ty.MagSquared();
-            return;
-        }
+        Vector dp = p.Minus(orig);
+        *u = dp.Dot(bu) / tx.MagSquared();
+        *v = dp.Dot(bv) / ty.MagSquared();
+        return;
     }
 
-    // Try whatever the previous guess was. This is likely to do something
+    // Try wherever the previous point landed. This is likely to do something
     // good if we're working our way along a curve or something else where
     // we project successive points that are close to each other; something
     // like a 20% speedup empirically.
-    if(mustConverge) {
-        double ut = cached.x, vt = cached.y;
+    if(mustConverge && guess && guess->valid) {
+        double ut = guess->uv.x, vt = guess->uv.y;
         if(ClosestPointNewton(p, &ut, &vt, mustConverge)) {
-            cached.x = *u = ut;
-            cached.y = *v = vt;
+            *u = ut;
+            *v = vt;
+            guess->uv = Point2d::From(ut, vt);
             return;
         }
     }
 
-    // Search for a reasonable initial guess
-    int i, j;
+    // Search for a reasonable initial guess, in our sample grid if we have
+    // one already.
+    int res = SampleGridSize(this);
+    Vector tryps[20*20];
+    const Vector *grid = tryps;
+    if(samples) {
+        ssassert(samples->size() == (size_t)(res*res), "Stale sample grid");
+        grid = samples->data();
+    } else {
+        SampleGridInto(this, tryps);
+    }
     double minDist = VERY_POSITIVE;
-    int res = (max(degm, degn) == 2) ? 7 : 20;
-    for(i = 0; i < res; i++) {
-        for(j = 0; j < res; j++) {
-            double tryu = (i + 0.5)/res, tryv = (j + 0.5)/res;
-
-            Vector tryp = PointAt(tryu, tryv);
-            double d = (tryp.Minus(p)).Magnitude();
+    for(int i = 0; i < res; i++) {
+        for(int j = 0; j < res; j++) {
+            double d = (grid[i*res + j].Minus(p)).Magnitude();
             if(d < minDist) {
-                *u = tryu;
-                *v = tryv;
+                *u = (i + 0.5)/res;
+                *v = (j + 0.5)/res;
                 minDist = d;
             }
         }
     }
 
     if(ClosestPointNewton(p, u, v, mustConverge)) {
-        cached.x = *u;
-        cached.y = *v;
+        if(guess) {
+            guess->uv = Point2d::From(*u, *v);
+            guess->valid = true;
+        }
         return;
     }
 
@@ -76,6 +76,7 @@ double SSurface::DepartureFromCoplanar() const {
 }
 
 void SSurface::WeightControlPoints() {
+    samples.reset();
     int i, j;
     for(i = 0; i <= degm; i++) {
         for(j = 0; j <= degn; j++) {
@@ -84,6 +85,7 @@ void SSurface::WeightControlPoints() {
     }
 }
 void SSurface::UnWeightControlPoints() {
+    samples.reset();
     int i, j;
     for(i = 0; i <= degm; i++) {
         for(j = 0; j <= degn; j++) {
@@ -92,6 +94,7 @@ void SSurface::UnWeightControlPoints() {
     }
 }
 void SSurface::CopyRowOrCol(bool row, int this_ij, SSurface *src, int src_ij) {
+    samples.reset();
     if(row) {
         int j;
         for(j = 0; j <= degn; j++) {
@@ -109,6 +112,7 @@ void SSurface::CopyRowOrCol(bool row, int this_ij, SSurface *src, int src_ij) {
 void SSurface::BlendRowOrCol(bool row, int this_ij, SSurface *a, int a_ij,
                                                     SSurface *b, int b_ij)
 {
+    samples.reset();
     if(row) {
         int j;
         for(j = 0; j <= degn; j++) {
@@ -587,12 +587,22 @@ void SShell::MakeSectionEdgesInto(Vector n, double d, SEdgeList *sel, SBezierLis
 }
 
 void SShell::TriangulateInto(SMesh *sm) {
+    // Each surface gets triangulated into its own mesh, and those are then
+    // appended in order; so the threads never wait on each other, and the
+    // result doesn't depend on how they were scheduled.
+    std::vector<SMesh> meshes(surface.n);
 #pragma omp parallel for
     for(int i=0; i<surface.n; i++) {
         SSurface *s = &surface[i];
-        SMesh m;
-        s->TriangulateInto(this, &m);
-        #pragma omp critical
+        s->TriangulateInto(this, &meshes[i]);
+    }
+
+    int n = 0;
+    for(SMesh &m : meshes) {
+        n += m.l.n;
+    }
+    sm->l.ReserveMore(n);
+    for(SMesh &m : meshes) {
         sm->MakeFromCopyOf(&m);
         m.Clear();
     }
@@ -602,6 +612,17 @@ bool SShell::IsEmpty() const {
     return surface.IsEmpty();
 }
 
+void SShell::GetBounding(Vector *vmax, Vector *vmin) {
+    *vmax = {VERY_NEGATIVE, VERY_NEGATIVE, VERY_NEGATIVE};
+    *vmin = {VERY_POSITIVE, VERY_POSITIVE, VERY_POSITIVE};
+    for(SSurface &ss : surface) {
+        Vector smax, smin;
+        ss.GetAxisAlignedBounding(&smax, &smin);
+        smax.MakeMaxMin(vmax, vmin);
+        smin.MakeMaxMin(vmax, vmin);
+    }
+}
+
 void SShell::Clear() {
     for(SSurface &s : surface) {
         s.Clear();
@@ -202,6 +202,35 @@ void SSurface::GetAxisAlignedBounding(Vector *ptMax, Vector *ptMin) const {
     }
 }
 
+//-----------------------------------------------------------------------------
+// A bounding box for the part of the surface that's within its trim curves.
+// A surface of degree one in u and v, a plane or any other bilinear patch, is
+// straight along each line of constant u; so every point within its trim lies
+// on a segment between two points of the trim curves, and the trimmed patch
+// stays within their convex hull, which is often much smaller than its control
+// polygon. Any other surface may bulge out past its trim curves, so that gets
+// the box of its control points.
+//-----------------------------------------------------------------------------
+void SSurface::GetTrimmedBounding(SShell *shell, Vector *ptMax, Vector *ptMin) const {
+    GetAxisAlignedBounding(ptMax, ptMin);
+    if(degm != 1 || degn != 1 || trim.IsEmpty()) return;
+
+    Vector tmax = {VERY_NEGATIVE, VERY_NEGATIVE, VERY_NEGATIVE},
+           tmin = {VERY_POSITIVE, VERY_POSITIVE, VERY_POSITIVE};
+    for(const STrimBy &stb : trim) {
+        SCurve *sc = shell->curve.FindByIdNoOops(stb.curve);
+        if(sc == NULL) return;
+        for(const SCurvePt &pt : sc->pts) {
+            pt.p.MakeMaxMin(&tmax, &tmin);
+        }
+    }
+    Vector pad = Vector::From(LENGTH_EPS, LENGTH_EPS, LENGTH_EPS);
+    tmax = tmax.Plus(pad);
+    tmin = tmin.Minus(pad);
+    *ptMax = Vector::From(min(ptMax->x, tmax.x), min(ptMax->y, tmax.y), min(ptMax->z, tmax.z));
+    *ptMin = Vector::From(max(ptMin->x, tmin.x), max(ptMin->y, tmin.y), max(ptMin->z, tmin.z));
+}
+
 bool SSurface::LineEntirelyOutsideBbox(Vector a, Vector b, bool asSegment) const {
     Vector amax, amin;
     GetAxisAlignedBounding(&amax, &amin);
@@ -225,6 +254,7 @@ void SSurface::MakeTrimEdgesInto(SEdgeList *sel, MakeAs flags,
     Vector prev = {};
     bool inCurve = false, empty = true;
     double u = 0, v = 0;
+    SProjectionGuess guess = {};
 
     int i, first, last, increment;
     if(stb->backwards) {
@@ -240,7 +270,7 @@ void SSurface::MakeTrimEdgesInto(SEdgeList *sel, MakeAs flags,
         Vector tpt, *pt = &(sc->pts[i].p);
 
         if(flags == MakeAs::UV) {
-            ClosestPointTo(*pt, &u, &v);
+            ClosestPointTo(*pt, &u, &v, /*mustConverge=*/true, &guess);
             tpt = {u, v, 0};
         } else {
             tpt = *pt;
@@ -435,19 +465,36 @@ void SSurface::TriangulateInto(SShell *shell, SMesh *sm) {
             poly.UvGridTriangulateInto(sm, this);
         }
 
+        // Map the vertices from uv to xyz, a few hundred at a time through
+        // the batched evaluators. This already runs on one of the threads of
+        // SShell::TriangulateInto(), so it's serial itself.
+        static const int BATCH_TRIANGLES = 128;
         STriMeta meta = { face, color };
-        for(i = start; i < sm->l.n; i++) {
-            STriangle *st = &(sm->l[i]);
-            st->meta = meta;
-            st->an = NormalAt(st->a.x, st->a.y);
-            st->bn = NormalAt(st->b.x, st->b.y);
-            st->cn = NormalAt(st->c.x, st->c.y);
-            st->a = PointAt(st->a.x, st->a.y);
-            st->b = PointAt(st->b.x, st->b.y);
-            st->c = PointAt(st->c.x, st->c.y);
-            // Works out that my chosen contour direction is inconsistent with
-            // the triangle direction, sigh.
-            st->FlipNormal();
+        for(i = start; i < sm->l.n; i += BATCH_TRIANGLES) {
+            int n = min(BATCH_TRIANGLES, sm->l.n - i);
+            Point2d puv[3*BATCH_TRIANGLES];
+            Vector pt[3*BATCH_TRIANGLES], nv[3*BATCH_TRIANGLES];
+            for(int k = 0; k < n; k++) {
+                const STriangle &st = sm->l[i + k];
+                puv[3*k + 0] = Point2d::From(st.a.x, st.a.y);
+                puv[3*k + 1] = Point2d::From(st.b.x, st.b.y);
+                puv[3*k + 2] = Point2d::From(st.c.x, st.c.y);
+            }
+            PointsAt(puv, pt, 3*n);
+            NormalsAt(puv, nv, 3*n);
+            for(int k = 0; k < n; k++) {
+                STriangle *st = &(sm->l[i + k]);
+                st->meta = meta;
+                st->an = nv[3*k + 0];
+                st->bn = nv[3*k + 1];
+                st->cn = nv[3*k + 2];
+                st->a = pt[3*k + 0];
+                st->b = pt[3*k + 1];
+                st->c = pt[3*k + 2];
+                // Works out that my chosen contour direction is inconsistent with
+                // the triangle direction, sigh.
+                st->FlipNormal();
+            }
         }
     } else {
         dbp("failed to assemble polygon to trim nurbs surface in uv space");
@@ -463,6 +510,7 @@ void SSurface::TriangulateInto(SShell *shell, SMesh *sm) {
 // coordinates change, but trim curves are stored as xyz so nothing happens
 //-----------------------------------------------------------------------------
 void SSurface::Reverse() {
+    samples.reset();
     int i, j;
     for(i = 0; i < (degm+1)/2; i++) {
         for(j = 0; j <= degn; j++) {
@@ -479,6 +527,7 @@ void SSurface::Reverse() {
 }
 
 void SSurface::ScaleSelfBy(double s) {
+    samples.reset();
     int i, j;
     for(i = 0; i <= degm; i++) {
         for(j = 0; j <= degn; j++) {
@@ -489,6 +538,7 @@ void SSurface::ScaleSelfBy(double s) {
 
 void SSurface::Clear() {
     trim.Clear();
+    samples.reset();
 }
 
 } // namespace SolveSpace
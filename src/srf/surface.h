@@ -94,6 +94,7 @@ public:
 
     Vector PointAt(double t) const;
     Vector TangentAt(double t) const;
+    void PointsAt(const double *t, Vector *pt, size_t n) const;
     void ClosestPointTo(Vector p, double *t, bool mustConverge=true) const;
     void SplitAt(double t, SBezier *bef, SBezier *aft) const;
     bool PointOnThisAndCurve(const SBezier *sbb, Vector *p) const;
@@ -259,6 +260,15 @@ public:
     bool        onEdge;         // pinter is on edge of trim poly
 };
 
+// Where the last of a run of projections into a surface landed, to start the
+// next one from. The caller keeps this, not the surface, so that a surface may
+// be projected into from several threads at once.
+class SProjectionGuess {
+public:
+    Point2d     uv;
+    bool        valid;
+};
+
 // A rational polynomial surface in Bezier form.
 class SSurface {
 public:
@@ -289,9 +299,11 @@ public:
     SBspUv          *bsp;
     SEdgeList       edges;
 
-    // For caching our initial (u, v) when doing Newton iterations to project
-    // a point into our surface.
-    Point2d         cached;
+    // A coarse grid of points on the surface, to start the Newton iterations
+    // from when projecting a point into it. Made along with the classifying
+    // BSP, and shared between copies; anything that moves the control points
+    // must drop it.
+    std::shared_ptr<const std::vector<Vector>> samples;
 
     static SSurface FromExtrusionOf(SBezier *spc, Vector t0, Vector t1);
     static SSurface FromRevolutionOf(SBezier *sb, Vector pt, Vector axis, double thetas,
@@ -335,8 +347,11 @@ public:
                                         List<Inter> *l, bool asSegment,
                                         SSurface *sorig);
 
-    void ClosestPointTo(Vector p, Point2d *puv, bool mustConverge=true);
-    void ClosestPointTo(Vector p, double *u, double *v, bool mustConverge=true);
+    void MakeSampleGrid();
+    void ClosestPointTo(Vector p, Point2d *puv, bool mustConverge=true,
+                        SProjectionGuess *guess=NULL) const;
+    void ClosestPointTo(Vector p, double *u, double *v, bool mustConverge=true,
+                        SProjectionGuess *guess=NULL) const;
     bool ClosestPointNewton(Vector p, double *u, double *v, bool mustConverge=true) const;
 
     bool PointIntersectingLine(Vector p0, Vector p1, double *u, double *v) const;
@@ -348,8 +363,12 @@ public:
     void TangentsAt(double u, double v, Vector *tu, Vector *tv, bool retry=true) const;
     Vector NormalAt(Point2d puv) const;
     Vector NormalAt(double u, double v) const;
+    void PointsAt(const Point2d *puv, Vector *pt, size_t n) const;
+    void TangentsAt(const Point2d *puv, Vector *tu, Vector *tv, size_t n) const;
+    void NormalsAt(const Point2d *puv, Vector *nv, size_t n) const;
     bool LineEntirelyOutsideBbox(Vector a, Vector b, bool asSegment) const;
     void GetAxisAlignedBounding(Vector *ptMax, Vector *ptMin) const;
+    void GetTrimmedBounding(SShell *shell, Vector *ptMax, Vector *ptMin) const;
     bool CoincidentWithPlane(Vector n, double d) const;
     bool CoincidentWith(SSurface *ss, bool sameNormal) const;
     bool ContainsPlaneCurve(SCurve *sc) const;
@@ -382,6 +401,28 @@ public:
     void Clear();
 };
 
+// A bounding volume hierarchy over the surfaces of a shell, so that the pairs
+// of surfaces from two shells that might intersect can be found without
+// testing every surface of one against every surface of the other.
+class SShellBvh {
+public:
+    struct Node {
+        Vector      minp, maxp;
+        uint32_t    first;  // first of two children, or of the surfaces
+        uint32_t    count;  // surfaces in this leaf, or 0 if not a leaf
+    };
+
+    std::vector<Node>     nodes;
+    std::vector<uint32_t> surfaces; // indices into the shell, leaf by leaf
+    std::vector<Vector>   minp, maxp; // bounds of each surface, by index
+
+    void Build(SShell *shell);
+    void Clear();
+
+    void FindOverlapsWith(const SShellBvh *b,
+                          std::vector<std::pair<uint32_t, uint32_t>> *pairs) const;
+};
+
 class SShell {
 public:
     IdList<SCurve,hSCurve>      curve;
@@ -440,6 +481,7 @@ public:
     void MakeEdgesInto(SEdgeList *sel);
     void MakeSectionEdgesInto(Vector n, double d, SEdgeList *sel, SBezierList *sbl);
     bool IsEmpty() const;
+    void GetBounding(Vector *vmax, Vector *vmin);
     void RemapFaces(Group *g, int remap);
     void Clear();
 };
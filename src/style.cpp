@@ -745,6 +745,7 @@ bool TextWindow::EditControlDoneForStyles(const std::string &str) {
         default: return false;
     }
     SS.GW.persistentDirty = true;
+    SS.GW.pickIndex.dirty = true;
     return true;
 }
 
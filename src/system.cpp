@@ -9,30 +9,109 @@
 #include "solvespace.h"
 
 #include <Eigen/Core>
+#include <Eigen/SparseCholesky>
 #include <Eigen/SparseQR>
 
+#include <atomic>
+
 namespace SolveSpace {
 
 // The solver will converge all unknowns to within this tolerance. This must
 // always be much less than LENGTH_EPS, and in practice should be much less.
 const double System::CONVERGE_TOLERANCE = (LENGTH_EPS/(1e2));
+// Relative to the largest entry on its diagonal, the regularization added to
+// A*A^T before factoring it, and the smallest pivot of that factorization
+// that isn't zero; see FactorNormalEquations().
+const double System::LEAST_SQUARES_SHIFT   = 1e-12;
+const double System::RANK_PIVOT_TOLERANCE  = 1e-9;
 
 constexpr size_t LikelyPartialCountPerEq = 10;
+// The most memory, in bytes, to spend on the Jacobian cache.
+constexpr size_t MaxJacobianCacheSize = 32 << 20;
+
+size_t System::SignatureHasher::operator()(const std::vector<uint64_t> &sig) const {
+    size_t h = sig.size();
+    for(uint64_t w : sig) {
+        h ^= std::hash<uint64_t>()(w) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+    return h;
+}
+
+// The structure of the expression, in prefix order: each op, followed by the
+// handle of a param or the bits of a constant.
+static void WriteExprStructure(const Expr *e, std::vector<uint64_t> *sig) {
+    sig->push_back((uint64_t)e->op);
+    switch(e->op) {
+        case Expr::Op::PARAM:
+            sig->push_back(e->parh.v);
+            break;
+
+        case Expr::Op::CONSTANT: {
+            uint64_t bits;
+            memcpy(&bits, &e->v, sizeof(bits));
+            sig->push_back(bits);
+            break;
+        }
+
+        default:
+            if(e->Children() >= 1) WriteExprStructure(e->a, sig);
+            if(e->Children() >= 2) WriteExprStructure(e->b, sig);
+            break;
+    }
+}
 
-bool System::WriteJacobian(int tag) {
+// Everything that the compiled Jacobian depends on, besides the values of the
+// params: the params solved for, and the whole structure of each equation as
+// it is now, after any substitutions. This is the key of the cache, so two
+// systems only share a tape if they're exactly the same. The known params get
+// compiled in as constants, but they're recorded with the tape instead; see
+// KnownParamsUnchanged().
+void System::WriteJacobianSignature(std::vector<uint64_t> *sig) {
+    sig->push_back(mat.m);
+    sig->push_back(mat.n);
+    for(hParam hp : mat.param) {
+        sig->push_back(hp.v);
+    }
+    for(Equation *e : mat.eq) {
+        WriteExprStructure(e->e, sig);
+    }
+}
+
+bool System::KnownParamsUnchanged(const CompiledJacobian &cj) {
+    for(const auto &k : cj.known) {
+        Param *p = param.FindByIdNoOops(k.first);
+        if(!p) p = SK.param.FindByIdNoOops(k.first);
+        if(!p || !p->known || !EXACT(p->val == k.second)) return false;
+    }
+    return true;
+}
+
+static size_t CacheEntryBytes(const std::vector<uint64_t> &signature,
+                              const System::CompiledJacobian &cj) {
+    return signature.size() * sizeof(uint64_t) +
+           cj.code.MemoryUsed() +
+           cj.B.size() * sizeof(uint32_t) +
+           cj.A.size() * sizeof(cj.A[0]) +
+           cj.known.size() * sizeof(cj.known[0]);
+}
+
+void System::WriteJacobian(int tag, bool useCache) {
     // Clear all
     mat.param.clear();
     mat.eq.clear();
     mat.A.sym.setZero();
     mat.B.sym.clear();
+    jacobianArena.Reset();
+    ExprArena::Scope arenaScope(&jacobianArena);
+    mat.tape.code.Clear();
+    mat.tape.B.clear();
+    mat.tape.A.clear();
+    mat.tape.known.clear();
 
     for(Equation &e : eq) {
         if(e.tag != tag) continue;
         mat.eq.push_back(&e);
     }
-    if(mat.eq.size() >= MAX_UNKNOWNS) {
-        return false;
-    }
     mat.m = mat.eq.size();
 
     std::unordered_map<uint32_t, int> paramToIndex;
@@ -44,16 +123,34 @@ bool System::WriteJacobian(int tag) {
     }
     mat.n = mat.param.size();
 
+    // If we've compiled the same system before, then just use that again.
+    std::vector<uint64_t> signature;
+    if(useCache) WriteJacobianSignature(&signature);
+    auto cached = useCache ? jacobianCache.find(signature) : jacobianCache.end();
+    if(cached != jacobianCache.end()) {
+        if(KnownParamsUnchanged(cached->second)) {
+            mat.tape = cached->second;
+            mat.tape.code.BindParams(&param, &(SK.param));
+            return;
+        }
+        // A param that was compiled in as a constant changed, so this gets
+        // compiled again and replaces it.
+        jacobianCacheSize -= CacheEntryBytes(cached->first, cached->second);
+        jacobianCache.erase(cached);
+    }
+
     // In some experimenting, this is almost always the right size.
     // Value is usually between 0 and 20, comes from number of constraints?
     mat.A.sym.resize(mat.m, mat.n);
     mat.A.sym.reserve(Eigen::VectorXi::Constant(mat.n, LikelyPartialCountPerEq));
 
     mat.B.sym.reserve(mat.eq.size());
+    ParamSet known;
     for(size_t i = 0; i < mat.eq.size(); i++) {
         Equation *e = mat.eq[i];
         // Deep-copy and simplify (fold) the current equation.
-        Expr *f = e->e->DeepCopyWithParamsAsPointers(&param, &(SK.param), /*foldConstants=*/true);
+        Expr *f = e->e->DeepCopyWithParamsAsPointers(&param, &(SK.param), /*foldConstants=*/true,
+                                                     &known);
 
         ParamSet paramsUsed;
         f->ParamsUsedList(&paramsUsed);
@@ -73,25 +170,72 @@ bool System::WriteJacobian(int tag) {
         }
         mat.B.sym.push_back(f);
     }
-    return true;
+    CompileJacobian();
+    for(hParam hp : known) {
+        Param *p = param.FindByIdNoOops(hp);
+        if(!p) p = SK.param.FindById(hp);
+        mat.tape.known.emplace_back(hp, p->val);
+    }
+    if(!useCache) return;
+
+    size_t size = CacheEntryBytes(signature, mat.tape);
+    if(jacobianCacheSize + size > MaxJacobianCacheSize) {
+        jacobianCache.clear();
+        jacobianCacheSize = 0;
+    }
+    if(size <= MaxJacobianCacheSize) {
+        jacobianCache.emplace(std::move(signature), mat.tape);
+        jacobianCacheSize += size;
+    }
 }
 
-void System::EvalJacobian() {
+void System::CompileJacobian() {
     using namespace Eigen;
-    mat.A.num.setZero();
-    mat.A.num.resize(mat.m, mat.n);
-    const int size = mat.A.sym.outerSize();
+    ExprTape &code = mat.tape.code;
+
+    // The residuals go first, so that they can be re-evaluated on their own
+    // during the Newton iterations; the partials share their subexpressions.
+    for(Expr *f : mat.B.sym) {
+        mat.tape.B.push_back(code.Add(f));
+    }
+    mat.tape.residualEnd = code.Size();
 
+    const int size = mat.A.sym.outerSize();
     for(int k = 0; k < size; k++) {
         for(SparseMatrix <Expr *>::InnerIterator it(mat.A.sym, k); it; ++it) {
-            double value = it.value()->Eval();
-            if(EXACT(value == 0.0)) continue;
-            mat.A.num.insert(it.row(), it.col()) = value;
+            JacobianEntry entry = { (int)it.row(), (int)it.col(), code.Add(it.value()) };
+            mat.tape.A.push_back(entry);
         }
     }
+    code.FinishAdding();
+}
+
+void System::EvalJacobian() {
+    // This evaluates the residuals too, since they're on the same tape.
+    mat.tape.code.Eval();
+    mat.B.num.resize(mat.m);
+    for(int i = 0; i < mat.m; i++) {
+        mat.B.num[i] = mat.tape.code.Value(mat.tape.B[i]);
+    }
+
+    mat.A.num.setZero();
+    mat.A.num.resize(mat.m, mat.n);
+    for(const JacobianEntry &entry : mat.tape.A) {
+        double value = mat.tape.code.Value(entry.slot);
+        if(EXACT(value == 0.0)) continue;
+        mat.A.num.insert(entry.row, entry.col) = value;
+    }
     mat.A.num.makeCompressed();
 }
 
+void System::EvalResiduals() {
+    mat.tape.code.Eval(mat.tape.residualEnd);
+    mat.B.num.resize(mat.m);
+    for(int i = 0; i < mat.m; i++) {
+        mat.B.num[i] = mat.tape.code.Value(mat.tape.B[i]);
+    }
+}
+
 bool System::IsDragged(hParam p) {
     return dragged.find(p) != dragged.end();
 }
@@ -234,12 +378,36 @@ SubstitutionMap System::SolveBySubstitution() {
     return subMap;
 }
 
+//-----------------------------------------------------------------------------
+// For the systems too big for a sparse QR, factor A*A^T with a sparse
+// Cholesky (LDL^T) factorization instead; that's close to linear in the number
+// of nonzeros for the banded systems that sketches give. A tiny shift keeps
+// it well defined when A doesn't have full rank; each row of A that depends
+// on the rows before it then gives a pivot not much bigger than the shift, so
+// any pivot under pivotTol counts as zero.
+//-----------------------------------------------------------------------------
+static bool FactorNormalEquations(const Eigen::SparseMatrix<double> &A,
+                                  Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> *ldlt,
+                                  double *pivotTol) {
+    using namespace Eigen;
+    SparseMatrix<double> AAt = A * A.transpose();
+    AAt.makeCompressed();
+    double maxDiag = std::max(AAt.diagonal().cwiseAbs().maxCoeff(), 1.0);
+    ldlt->setShift(maxDiag * System::LEAST_SQUARES_SHIFT);
+    ldlt->compute(AAt);
+    *pivotTol = maxDiag * System::RANK_PIVOT_TOLERANCE;
+    return ldlt->info() == Success;
+}
+
 //-----------------------------------------------------------------------------
 // Calculate the rank of the Jacobian matrix
 //-----------------------------------------------------------------------------
 int System::CalculateRank() {
     using namespace Eigen;
     if(mat.n == 0 || mat.m == 0) return 0;
+    // Always from A itself, whatever its size; the pivots of A*A^T would
+    // square its condition number, so a system's rank and dof could change
+    // just because it grew past MAX_DIRECT_UNKNOWNS.
     SparseQR <SparseMatrix<double>, COLAMDOrdering<int>> solver;
     solver.compute(mat.A.num);
     int result = solver.rank();
@@ -291,11 +459,28 @@ bool System::SolveLeastSquares() {
         }
     }
 
-    SparseMatrix<double> AAt = mat.A.num * mat.A.num.transpose();
-    AAt.makeCompressed();
-    VectorXd z(mat.n);
-
-    if(!SolveLinearSystem(AAt, mat.B.num, &z)) return false;
+    VectorXd z(mat.m);
+    if(mat.m > MAX_DIRECT_UNKNOWNS) {
+        SimplicialLDLT<SparseMatrix<double>> ldlt;
+        double pivotTol;
+        if(!FactorNormalEquations(mat.A.num, &ldlt, &pivotTol)) return false;
+        // Solve with the factors, dropping the dependent rows. Dividing by
+        // their pivots would blow up any inconsistency in B into a huge
+        // step; this way no component of z is more than 1/pivotTol times
+        // the corresponding component of B, once transformed.
+        z = ldlt.permutationP() * mat.B.num;
+        ldlt.matrixL().solveInPlace(z);
+        const VectorXd &d = ldlt.vectorD();
+        for(int i = 0; i < mat.m; i++) {
+            z[i] = (d[i] > pivotTol) ? z[i] / d[i] : 0.0;
+        }
+        ldlt.matrixU().solveInPlace(z);
+        z = ldlt.permutationPinv() * z;
+    } else {
+        SparseMatrix<double> AAt = mat.A.num * mat.A.num.transpose();
+        AAt.makeCompressed();
+        if(!SolveLinearSystem(AAt, mat.B.num, &z)) return false;
+    }
 
     mat.X = mat.A.num.transpose() * z;
 
@@ -311,13 +496,8 @@ bool System::NewtonSolve() {
     bool converged = false;
     int i;
 
-    // Evaluate the functions at our operating point.
-    mat.B.num = Eigen::VectorXd(mat.m);
-    for(i = 0; i < mat.m; i++) {
-        mat.B.num[i] = (mat.B.sym[i])->Eval();
-    }
     do {
-        // And evaluate the Jacobian at our initial operating point.
+        // Evaluate the functions and the Jacobian at our operating point.
         EvalJacobian();
 
         if(!SolveLeastSquares()) break;
@@ -334,8 +514,8 @@ bool System::NewtonSolve() {
         }
 
         // Re-evalute the functions, since the params have just changed.
+        EvalResiduals();
         for(i = 0; i < mat.m; i++) {
-            mat.B.num[i] = (mat.B.sym[i])->Eval();
             if(IsReasonable(mat.B.num[i])) {
                 // Very bad, and clearly not convergent
                 return false;
@@ -393,55 +573,145 @@ void System::WriteEquationsExceptFor(hConstraint hc, Group *g) {
 void System::FindWhichToRemoveToFixJacobian(Group *g, List<hConstraint> *bad, bool forceDofCheck) {
     auto time = GetMilliseconds();
     g->solved.timeout = false;
-    int a;
 
-    for(a = 0; a < 2; a++) {
+    // Do the constraints in two passes: first everything but the point-
+    // coincident constraints, then only those constraints (so they appear
+    // last in the list).
+    std::vector<hConstraint> candidates;
+    for(int a = 0; a < 2; a++) {
         for(auto &con : SK.constraint) {
-            if((GetMilliseconds() - time) > g->solved.findToFixTimeout) {
-                g->solved.timeout = true;
-                return;
-            }
-
             ConstraintBase *c = &con;
             if(c->group != g->h) continue;
-            if((c->type == Constraint::Type::POINTS_COINCIDENT && a == 0) ||
-               (c->type != Constraint::Type::POINTS_COINCIDENT && a == 1))
-            {
-                // Do the constraints in two passes: first everything but
-                // the point-coincident constraints, then only those
-                // constraints (so they appear last in the list).
-                continue;
-            }
+            if((c->type == Constraint::Type::POINTS_COINCIDENT) != (a == 1)) continue;
+            candidates.push_back(c->h);
+        }
+    }
 
-            param.ClearTags();
-            eq.Clear();
-            WriteEquationsExceptFor(c->h, g);
-            eq.ClearTags();
+    // Each candidate is tested on its own copy of the parameters, so the
+    // rank tests are independent and can run in parallel. When all
+    // dimensions are reference, writing the equations modifies the
+    // constraints, so that case stays serial.
+#if defined(LIBRARY)
+    Sketch *sketch = CurrentSketch;
+#endif
+    std::vector<char> fixes(candidates.size(), 0);
+    std::atomic<bool> timedOut(false);
+#pragma omp parallel for schedule(dynamic) if(!g->allDimsReference)
+    for(int i = 0; i < (int)candidates.size(); i++) {
+        if(timedOut) continue;
+        if((GetMilliseconds() - time) > g->solved.findToFixTimeout) {
+            timedOut = true;
+            continue;
+        }
+#if defined(LIBRARY)
+        CurrentSketch = sketch;
+#endif
+
+        System test;
+        ExprArena::Scope arenaScope(&test.eqArena);
+        test.param   = param;
+        test.dragged = dragged;
+        test.param.ClearTags();
+        test.WriteEquationsExceptFor(candidates[i], g);
+        test.eq.ClearTags();
+
+        // It's a major speedup to solve the easy ones by substitution here,
+        // and that doesn't break anything.
+        if(!forceDofCheck) {
+            test.SolveBySubstitution();
+        }
 
-            // It's a major speedup to solve the easy ones by substitution here,
-            // and that doesn't break anything.
-            if(!forceDofCheck) {
-                SolveBySubstitution();
-            }
+        test.WriteJacobian(0);
+        test.EvalJacobian();
 
-            WriteJacobian(0);
-            EvalJacobian();
+        int rank = test.CalculateRank();
+        if(rank == test.mat.m) {
+            // We fixed it by removing this constraint
+            fixes[i] = 1;
+        }
+    }
+    g->solved.timeout = timedOut;
 
-            int rank = CalculateRank();
-            if(rank == mat.m) {
-                // We fixed it by removing this constraint
-                bad->Add(&(c->h));
+    for(size_t i = 0; i < candidates.size(); i++) {
+        if(fixes[i]) bad->Add(&candidates[i]);
+    }
+}
+
+int System::TagClusters() {
+    // Union-find over the params that are still to be solved.
+    std::unordered_map<hParam, int, HandleHasher<hParam>> paramToIndex;
+    std::vector<Param *> params;
+    for(Param &p : param) {
+        if(p.tag != 0) continue;
+        paramToIndex[p.h] = params.size();
+        params.push_back(&p);
+    }
+    std::vector<int> parent(params.size());
+    for(size_t i = 0; i < parent.size(); i++) parent[i] = i;
+    auto findRoot = [&](int i) {
+        while(parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+
+    // Any params that appear in the same equation are in the same cluster.
+    std::vector<int> eqRoot;
+    for(Equation &e : eq) {
+        if(e.tag != 0) continue;
+        ParamSet paramsUsed;
+        e.e->ParamsUsedList(&paramsUsed);
+        int root = -1;
+        for(hParam hp : paramsUsed) {
+            auto it = paramToIndex.find(hp);
+            if(it == paramToIndex.end()) continue;
+            int r = findRoot(it->second);
+            if(root < 0) {
+                root = r;
+            } else if(r != root) {
+                parent[r] = root;
             }
         }
+        eqRoot.push_back(root);
+    }
+
+    // Now number the clusters; params that don't appear in any equation
+    // are left tagged zero. Equations that don't involve any of our params
+    // are all lumped together; they're either satisfied already, or will
+    // fail the rank test.
+    std::vector<int> clusterOf(params.size(), 0);
+    int clusters = 0, unknownFree = 0;
+    size_t k = 0;
+    for(Equation &e : eq) {
+        if(e.tag != 0) continue;
+        int root = eqRoot[k++];
+        if(root < 0) {
+            if(unknownFree == 0) unknownFree = ++clusters;
+            e.tag = -unknownFree;
+            continue;
+        }
+        root = findRoot(root);
+        if(clusterOf[root] == 0) clusterOf[root] = ++clusters;
+        e.tag = -clusterOf[root];
+    }
+    for(size_t i = 0; i < params.size(); i++) {
+        params[i]->tag = -clusterOf[findRoot(i)];
     }
+    return clusters;
 }
 
 SolveResult System::Solve(Group *g, int *dof, List<hConstraint> *bad,
                           bool andFindBad, bool andFindFree, bool forceDofCheck)
 {
+    // The equations are written afresh for every solve.
+    eqArena.Reset();
+    ExprArena::Scope arenaScope(&eqArena);
     WriteEquationsExceptFor(Constraint::NO_CONSTRAINT, g);
 
-    bool rankOk;
+    bool rankOk, initialRankOk;
+    bool converged = true;
+    int clusters, totalDof, initialDof;
 
     // int x;
     // printf("%d equations", eq.n);
@@ -485,32 +755,71 @@ SolveResult System::Solve(Group *g, int *dof, List<hConstraint> *bad,
         p->tag = alone;
         WriteJacobian(alone);
         if(!NewtonSolve()) {
-            // We don't do the rank test, so let's arbitrarily return
-            // the DIDNT_CONVERGE result here.
-            rankOk = true;
-            // Failed to converge, bail out early
-            goto didnt_converge;
+            // Keep going, so that we can report everything that's unsatisfied.
+            if(converged) SK.constraint.ClearTags();
+            converged = false;
+            EvalResiduals();
+            MarkUnsatisfied(bad);
         }
         alone++;
     }
 
-    // Now write the Jacobian for what's left, and do a rank test; that
-    // tells us if the system is inconsistently constrained.
-    if(!WriteJacobian(0)) {
-        return SolveResult::TOO_MANY_UNKNOWNS;
-    }
+    // What's left usually falls apart in to clusters that don't share any
+    // params; many small systems are much cheaper to solve and rank test
+    // than one big one.
+    clusters = TagClusters();
+
     // Clear dof value in order to have indication when dof is actually not calculated
     if(dof != NULL) *dof = -1;
-    // We are suppressing or allowing redundant, so we no need to catch unsolveable + redundant
-    rankOk = (!g->suppressDofCalculation && !g->allowRedundant) ? TestRank(dof) : true;
+    // Params that no equation refers to are all free.
+    totalDof = 0;
+    for(Param &p : param) {
+        if(p.tag == 0) totalDof++;
+    }
+    // The dof before solving, reported if we don't converge.
+    initialDof = totalDof;
+
+    rankOk = true;
+    initialRankOk = true;
+    for(int c = 1; c <= clusters; c++) {
+        // Write the Jacobian for this cluster, and do a rank test; that
+        // tells us if the system is inconsistently constrained.
+        WriteJacobian(-c, /*useCache=*/true);
+        // We are suppressing or allowing redundant, so we no need to catch unsolveable + redundant
+        if(!g->suppressDofCalculation && !g->allowRedundant) {
+            int clusterDof;
+            initialRankOk = TestRank(&clusterDof) && initialRankOk;
+            initialDof += clusterDof;
+        }
 
-    // And do the leftovers as one big system
-    if(!NewtonSolve()) {
-        goto didnt_converge;
+        if(!NewtonSolve()) {
+            // Solve the other clusters anyway, so that we report the
+            // unsatisfied constraints from all of them, and the same rank
+            // and dof as for one big system.
+            if(converged) SK.constraint.ClearTags();
+            converged = false;
+            EvalResiduals();
+            MarkUnsatisfied(bad);
+            continue;
+        }
+
+        // Here we are want to calculate dof even when redundant is allowed, so just handle suppressing
+        if(!g->suppressDofCalculation) {
+            int clusterDof;
+            rankOk = TestRank(&clusterDof) && rankOk;
+            totalDof += clusterDof;
+        }
     }
 
-    // Here we are want to calculate dof even when redundant is allowed, so just handle suppressing
-    rankOk = (!g->suppressDofCalculation) ? TestRank(dof) : true;
+    if(!converged) {
+        if(dof != NULL && !g->suppressDofCalculation && !g->allowRedundant) {
+            *dof = initialDof;
+        }
+        return initialRankOk ? SolveResult::DIDNT_CONVERGE
+                             : SolveResult::REDUNDANT_DIDNT_CONVERGE;
+    }
+    if(dof != NULL && !g->suppressDofCalculation) *dof = totalDof;
+
     if(!rankOk) {
         if(andFindBad) FindWhichToRemoveToFixJacobian(g, bad, forceDofCheck);
     } else {
@@ -528,9 +837,9 @@ SolveResult System::Solve(Group *g, int *dof, List<hConstraint> *bad,
         pp->free  = p.free;
     }
     return rankOk ? SolveResult::OKAY : SolveResult::REDUNDANT_OKAY;
+}
 
-didnt_converge:
-    SK.constraint.ClearTags();
+void System::MarkUnsatisfied(List<hConstraint> *bad) {
     // Not using range-for here because index is used in additional ways
     for(size_t i = 0; i < mat.eq.size(); i++) {
         if(fabs(mat.B.num[i]) > CONVERGE_TOLERANCE || IsReasonable(mat.B.num[i])) {
@@ -548,13 +857,13 @@ didnt_converge:
             }
         }
     }
-
-    return rankOk ? SolveResult::DIDNT_CONVERGE : SolveResult::REDUNDANT_DIDNT_CONVERGE;
 }
 
 SolveResult System::SolveRank(Group *g, int *rank, int *dof, List<hConstraint> *bad,
                               bool andFindBad, bool andFindFree)
 {
+    eqArena.Reset();
+    ExprArena::Scope arenaScope(&eqArena);
     WriteEquationsExceptFor(Constraint::NO_CONSTRAINT, g);
 
     // All params and equations are assigned to group zero.
@@ -563,9 +872,7 @@ SolveResult System::SolveRank(Group *g, int *rank, int *dof, List<hConstraint> *
 
     // Now write the Jacobian, and do a rank test; that
     // tells us if the system is inconsistently constrained.
-    if(!WriteJacobian(0)) {
-        return SolveResult::TOO_MANY_UNKNOWNS;
-    }
+    WriteJacobian(0, /*useCache=*/true);
 
     bool rankOk = TestRank(dof, rank);
     if(!rankOk) {
@@ -587,6 +894,10 @@ void System::Clear() {
     dragged.clear();
     mat.A.num.setZero();
     mat.A.sym.setZero();
+    mat.B.sym.clear();
+    mat.tape.code.Clear();
+    jacobianArena.Reset();
+    eqArena.Reset();
 }
 
 void System::MarkParamsFree(bool find) {
@@ -597,15 +908,18 @@ void System::MarkParamsFree(bool find) {
         p.free = false;
 
         if(find) {
-            if(p.tag == 0) {
+            // Only the params in the big system or one of its clusters (see
+            // TagClusters()); it's enough to test the cluster alone.
+            if(p.tag <= 0) {
+                int tag = p.tag;
                 p.tag = VAR_DOF_TEST;
-                WriteJacobian(0);
+                WriteJacobian(tag);
                 EvalJacobian();
                 int rank = CalculateRank();
                 if(rank == mat.m) {
                     p.free = true;
                 }
-                p.tag = 0;
+                p.tag = tag;
             }
         }
     }
@@ -467,6 +467,7 @@ public:
 
     static void ScreenChangeArcDimDefault(int link, uint32_t v);
     static void ScreenChangeShowFullFilePath(int link, uint32_t v);
+    static void ScreenChangeSaveBinaryFiles(int link, uint32_t v);
     static void ScreenChangeFixExportColors(int link, uint32_t v);
     static void ScreenChangeExportBackgroundColor(int link, uint32_t v);
     static void ScreenChangeBackFaces(int link, uint32_t v);
@@ -782,6 +783,30 @@ public:
     Selection ChooseFromHoverToSelect();
     Selection ChooseFromHoverToDrag();
     void HitTestMakeSelection(Point2d mp);
+
+    // The entities and constraints that could be hovered from each cell of a
+    // grid over the screen, so that hit testing need only try those near the
+    // cursor. Rebuilt when the sketch is regenerated, and when the view
+    // changes; while dragging, only the entities that moved are placed again.
+    struct PickExtent {
+        int  x0, y0, x1, y1;    // the cells it's in; none if x0 > x1
+        bool unbounded;         // if tried everywhere instead
+    };
+    struct {
+        bool                                dirty;
+        bool                                moved;      // by a drag
+        double                              width, height;
+        int                                 columns, rows;
+        int                                 entities, constraints;
+        std::vector<Selection>              items;      // entities, then constraints
+        std::vector<PickExtent>             extents;    // of each item
+        std::vector<uint64_t>               geometry;   // of each entity, see EntityGeometryHash()
+        std::vector<std::vector<uint32_t>>  cells;      // indices into items
+        std::vector<uint32_t>               unbounded;  // tried wherever the cursor is
+    } pickIndex;
+    void BuildPickIndex(const Camera &camera, double selRadius);
+    bool UpdatePickIndex(const Camera &camera, double selRadius);
+    void GetPickCandidates(Point2d mp, std::vector<uint32_t> *candidates);
     void ClearSelection();
     void ClearNonexistentSelectionItems();
     /// This structure is filled by a call to GroupSelection().
@@ -3,6 +3,10 @@
 // record our state and push it on a stack, and we pop the stack when they
 // select undo.
 //
+// Only the state on top of each stack is kept in full. Each state below it is
+// kept as the records that differ from the one above, so that remembering an
+// edit costs memory in proportion to what changed, not to the sketch.
+//
 // Copyright 2008-2013 Jonathan Westhues.
 //-----------------------------------------------------------------------------
 #include "solvespace.h"
@@ -33,70 +37,214 @@ void SolveSpaceUI::UndoRedo() {
 }
 
 void SolveSpaceUI::UndoEnableMenus() {
+    // There's no menu when running headless, as in the tests.
+    if(!SS.GW.undoMenuItem) return;
     SS.GW.undoMenuItem->SetEnabled(undo.cnt > 0);
     SS.GW.redoMenuItem->SetEnabled(redo.cnt > 0);
 }
 
+//-----------------------------------------------------------------------------
+// The copies of the records that we keep, and whether two of those are the
+// same as far as undo is concerned; which is all that the user can edit, but
+// not what gets regenerated.
+//-----------------------------------------------------------------------------
+static Group CopyForUndo(const Group &src) {
+    // Shallow copy
+    Group dest(src);
+    // And then clean up all the stuff that needs to be a deep copy,
+    // and zero out all the dynamic stuff that will get regenerated.
+    dest.clean = false;
+    dest.solved = {};
+    dest.polyLoops = {};
+    dest.bezierLoops = {};
+    dest.bezierOpens = {};
+    dest.polyError = {};
+    dest.thisMesh = {};
+    dest.runningMesh = {};
+    dest.thisShell = {};
+    dest.runningShell = {};
+    dest.displayMesh = {};
+    dest.displayMeshBvh = {};
+    dest.displayMeshAdjacency = {};
+    dest.displayOutlines = {};
+
+    dest.remap = src.remap;
+
+    dest.impPart = nullptr;
+    return dest;
+}
+
+template<class T>
+static T CopyForUndo(const T &src) {
+    return src;
+}
+
+static bool SameForUndo(const Group &a, const Group &b) {
+    return a.type == b.type && a.order == b.order && a.opA == b.opA && a.opB == b.opB &&
+        a.visible == b.visible && a.suppress == b.suppress &&
+        a.relaxConstraints == b.relaxConstraints && a.allowRedundant == b.allowRedundant &&
+        a.suppressDofCalculation == b.suppressDofCalculation &&
+        a.allDimsReference == b.allDimsReference && EXACT(a.scale == b.scale) &&
+        a.activeWorkplane == b.activeWorkplane &&
+        EXACT(a.valA == b.valA && a.valB == b.valB && a.valC == b.valC) &&
+        a.color.Equals(b.color) && a.subtype == b.subtype && a.skipFirst == b.skipFirst &&
+        EXACT(a.predef.q.w == b.predef.q.w && a.predef.q.vx == b.predef.q.vx &&
+              a.predef.q.vy == b.predef.q.vy && a.predef.q.vz == b.predef.q.vz) &&
+        a.predef.origin == b.predef.origin && a.predef.entityB == b.predef.entityB &&
+        a.predef.entityC == b.predef.entityC && a.predef.swapUV == b.predef.swapUV &&
+        a.predef.negateU == b.predef.negateU && a.predef.negateV == b.predef.negateV &&
+        a.meshCombine == b.meshCombine && a.forceToMesh == b.forceToMesh &&
+        a.linkFile.raw == b.linkFile.raw && a.name == b.name &&
+        a.remap.size() == b.remap.size() &&
+        std::equal(a.remap.begin(), a.remap.end(), b.remap.begin(),
+            [](const std::pair<const EntityKey, EntityId> &ea,
+               const std::pair<const EntityKey, EntityId> &eb) {
+                return EntityKeyEqual()(ea.first, eb.first) && ea.second == eb.second;
+            });
+}
+
+static bool SameForUndo(const Request &a, const Request &b) {
+    return a.type == b.type && a.extraPoints == b.extraPoints &&
+        a.workplane == b.workplane && a.group == b.group && a.style == b.style &&
+        a.construction == b.construction && a.str == b.str && a.font == b.font &&
+        a.file.raw == b.file.raw && EXACT(a.aspectRatio == b.aspectRatio) &&
+        a.groupRequestIndex == b.groupRequestIndex;
+}
+
+static bool SameForUndo(const Constraint &a, const Constraint &b) {
+    return a.Equals(b) && a.disp.offset.EqualsExactly(b.disp.offset) &&
+        a.disp.style == b.disp.style;
+}
+
+static bool SameForUndo(const Param &a, const Param &b) {
+    return EXACT(a.val == b.val);
+}
+
+static bool SameForUndo(const Style &a, const Style &b) {
+    return a.name == b.name && EXACT(a.width == b.width) && a.widthAs == b.widthAs &&
+        EXACT(a.textHeight == b.textHeight) && a.textHeightAs == b.textHeightAs &&
+        a.textOrigin == b.textOrigin && EXACT(a.textAngle == b.textAngle) &&
+        a.color.Equals(b.color) && a.filled == b.filled && a.fillColor.Equals(b.fillColor) &&
+        a.visible == b.visible && a.exportable == b.exportable &&
+        a.stippleType == b.stippleType && EXACT(a.stippleScale == b.stippleScale) &&
+        a.zIndex == b.zIndex;
+}
+
+//-----------------------------------------------------------------------------
+// Make the list on top of a stack hold the same records as the current one,
+// and record in changed and removed what it takes to turn it back. Both lists
+// are in order of their handles, so that's a single pass over the two.
+//-----------------------------------------------------------------------------
+template<class T, class H, IdIndex I>
+static void UpdateTop(IdList<T, H, I> *current, IdList<T, H, I> *top,
+                      IdList<T, H, I> *changed, std::vector<H> *removed) {
+    std::vector<int> added;
+    bool anyGone = false;
+    int i = 0, j = 0;
+    while(i < current->n || j < top->n) {
+        T *c = (i < current->n) ? &current->Get(i) : NULL;
+        T *t = (j < top->n)     ? &top->Get(j)     : NULL;
+        if(t == NULL || (c != NULL && c->h.v < t->h.v)) {
+            // New since the state on top; going back removes it.
+            removed->push_back(c->h);
+            added.push_back(i);
+            i++;
+        } else if(c == NULL || t->h.v < c->h.v) {
+            // Gone since the state on top; going back puts it back.
+            changed->Add(t);
+            t->tag = 1;
+            anyGone = true;
+            j++;
+        } else {
+            if(!SameForUndo(*c, *t)) {
+                changed->Add(t);
+                *t = CopyForUndo(*c);
+            }
+            t->tag = 0;
+            i++;
+            j++;
+        }
+    }
+
+    if(anyGone) top->RemoveTagged();
+    for(int k : added) {
+        T t = CopyForUndo(current->Get(k));
+        t.tag = 0;
+        top->Add(&t);
+    }
+}
+
+// The reverse; apply what was recorded to the list on top of a stack.
+template<class T, class H, IdIndex I>
+static void ApplyToTop(IdList<T, H, I> *top, IdList<T, H, I> *changed,
+                       const std::vector<H> &removed) {
+    if(!removed.empty()) {
+        top->ClearTags();
+        for(H h : removed) {
+            top->Tag(h, 1);
+        }
+        top->RemoveTagged();
+    }
+    for(T &t : *changed) {
+        T *existing = top->FindByIdNoOops(t.h);
+        if(existing != NULL) {
+            *existing = t;
+        } else {
+            top->Add(&t);
+        }
+    }
+}
+
+template<class T, class H, IdIndex I>
+static void CopyAll(IdList<T, H, I> *src, IdList<T, H, I> *dest) {
+    dest->ReserveMore(src->n);
+    for(T &t : *src) {
+        T copy = CopyForUndo(t);
+        dest->Add(&copy);
+    }
+}
+
 void SolveSpaceUI::PushFromCurrentOnto(UndoStack *uk) {
-    if(uk->cnt == MAX_UNDO) {
-        UndoClearState(&(uk->d[uk->write]));
-        // And then write in to this one again
+    UndoState *ut = &uk->top;
+    if(uk->cnt == 0) {
+        ut->Clear();
+        CopyAll(&SK.group, &ut->group);
+        CopyAll(&SK.request, &ut->request);
+        CopyAll(&SK.constraint, &ut->constraint);
+        CopyAll(&SK.param, &ut->param);
+        CopyAll(&SK.style, &ut->style);
     } else {
-        (uk->cnt)++;
-    }
+        if(uk->cnt == MAX_UNDO) {
+            // Forget the oldest state, to make room.
+            (uk->cnt)--;
+            uk->d[WRAP(uk->write - uk->cnt, MAX_UNDO)].Clear();
+        }
 
-    UndoState *ut = &(uk->d[uk->write]);
-    *ut = {};
-    ut->group.ReserveMore(SK.group.n);
-    for(Group &src : SK.group) {
-        // Shallow copy
-        Group dest(src);
-        // And then clean up all the stuff that needs to be a deep copy,
-        // and zero out all the dynamic stuff that will get regenerated.
-        dest.clean = false;
-        dest.solved = {};
-        dest.polyLoops = {};
-        dest.bezierLoops = {};
-        dest.bezierOpens = {};
-        dest.polyError = {};
-        dest.thisMesh = {};
-        dest.runningMesh = {};
-        dest.thisShell = {};
-        dest.runningShell = {};
-        dest.displayMesh = {};
-        dest.displayOutlines = {};
-
-        dest.remap = src.remap;
-
-        dest.impMesh = {};
-        dest.impShell = {};
-        dest.impEntity = {};
-        ut->group.Add(&dest);
+        UndoDelta *ud = &(uk->d[uk->write]);
+        ud->Clear();
+        UpdateTop(&SK.group, &ut->group, &ud->changed.group, &ud->removedGroup);
+        UpdateTop(&SK.request, &ut->request, &ud->changed.request, &ud->removedRequest);
+        UpdateTop(&SK.constraint, &ut->constraint,
+                  &ud->changed.constraint, &ud->removedConstraint);
+        UpdateTop(&SK.param, &ut->param, &ud->changed.param, &ud->removedParam);
+        UpdateTop(&SK.style, &ut->style, &ud->changed.style, &ud->removedStyle);
+        std::swap(ut->groupOrder, ud->changed.groupOrder);
+        ud->changed.activeGroup = ut->activeGroup;
+
+        uk->write = WRAP(uk->write + 1, MAX_UNDO);
     }
+    ut->groupOrder.Clear();
     for(auto &src : SK.groupOrder) { ut->groupOrder.Add(&src); }
-    ut->request.ReserveMore(SK.request.n);
-    for(auto &src : SK.request) { ut->request.Add(&src); }
-    ut->constraint.ReserveMore(SK.constraint.n);
-    for(auto &src : SK.constraint) {
-        // Shallow copy
-        Constraint dest(src);
-        ut->constraint.Add(&dest);
-    }
-    ut->param.ReserveMore(SK.param.n);
-    for(auto &src : SK.param) { ut->param.Add(&src); }
-    ut->style.ReserveMore(SK.style.n);
-    for(auto &src : SK.style) { ut->style.Add(&src); }
     ut->activeGroup = SS.GW.activeGroup;
 
-    uk->write = WRAP(uk->write + 1, MAX_UNDO);
+    (uk->cnt)++;
 }
 
 void SolveSpaceUI::PopOntoCurrentFrom(UndoStack *uk) {
     ssassert(uk->cnt > 0, "Cannot pop from empty undo stack");
     (uk->cnt)--;
-    uk->write = WRAP(uk->write - 1, MAX_UNDO);
 
-    UndoState *ut = &(uk->d[uk->write]);
+    UndoState *ut = &uk->top;
 
     // Free everything in the main copy of the program before replacing it
     for(hGroup hg : SK.groupOrder) {
@@ -110,17 +258,31 @@ void SolveSpaceUI::PopOntoCurrentFrom(UndoStack *uk) {
     SK.param.Clear();
     SK.style.Clear();
 
-    // And then do a shallow copy of the state from the undo list
-    ut->group.MoveSelfInto(&(SK.group));
+    // And then copy the state on top of the stack; it's still needed to get
+    // back to the state below it.
+    CopyAll(&ut->group, &SK.group);
     for(auto &gh : ut->groupOrder) { SK.groupOrder.Add(&gh); }
-    ut->request.MoveSelfInto(&(SK.request));
-    ut->constraint.MoveSelfInto(&(SK.constraint));
-    ut->param.MoveSelfInto(&(SK.param));
-    ut->style.MoveSelfInto(&(SK.style));
+    CopyAll(&ut->request, &SK.request);
+    CopyAll(&ut->constraint, &SK.constraint);
+    CopyAll(&ut->param, &SK.param);
+    CopyAll(&ut->style, &SK.style);
     SS.GW.activeGroup = ut->activeGroup;
 
-    // No need to free it, since a shallow copy was made above
-    *ut = {};
+    if(uk->cnt > 0) {
+        uk->write = WRAP(uk->write - 1, MAX_UNDO);
+        UndoDelta *ud = &(uk->d[uk->write]);
+        ApplyToTop(&ut->group, &ud->changed.group, ud->removedGroup);
+        ApplyToTop(&ut->request, &ud->changed.request, ud->removedRequest);
+        ApplyToTop(&ut->constraint, &ud->changed.constraint, ud->removedConstraint);
+        ApplyToTop(&ut->param, &ud->changed.param, ud->removedParam);
+        ApplyToTop(&ut->style, &ud->changed.style, ud->removedStyle);
+        ut->groupOrder.Clear();
+        std::swap(ut->groupOrder, ud->changed.groupOrder);
+        ut->activeGroup = ud->changed.activeGroup;
+        ud->Clear();
+    } else {
+        ut->Clear();
+    }
 
     // And reset the state everywhere else in the program, since the
     // sketch just changed a lot.
@@ -136,22 +298,51 @@ void SolveSpaceUI::PopOntoCurrentFrom(UndoStack *uk) {
 }
 
 void SolveSpaceUI::UndoClearStack(UndoStack *uk) {
-    while(uk->cnt > 0) {
+    while(uk->cnt > 1) {
         uk->write = WRAP(uk->write - 1, MAX_UNDO);
         (uk->cnt)--;
-        UndoClearState(&(uk->d[uk->write]));
+        uk->d[uk->write].Clear();
     }
-    *uk = {}; // for good measure
+    uk->top.Clear();
+    uk->top.activeGroup = {};
+    uk->cnt = 0;
+    uk->write = 0;
 }
 
-void SolveSpaceUI::UndoClearState(UndoState *ut) {
-    for(auto &g : ut->group) { g.remap.clear(); }
-    ut->group.Clear();
-    ut->request.Clear();
-    ut->constraint.Clear();
-    ut->param.Clear();
-    ut->style.Clear();
-    *ut = {};
+//-----------------------------------------------------------------------------
+// An estimate of the memory held by both stacks, for the configuration screen;
+// it counts the records and the group remaps, but not the strings.
+//-----------------------------------------------------------------------------
+static size_t UndoStateMemoryUsage(SolveSpaceUI::UndoState *ut) {
+    size_t size = ut->group.n * sizeof(Group) +
+                  ut->groupOrder.n * sizeof(hGroup) +
+                  ut->request.n * sizeof(Request) +
+                  ut->constraint.n * sizeof(Constraint) +
+                  ut->param.n * sizeof(Param) +
+                  ut->style.n * sizeof(Style);
+    for(Group &g : ut->group) {
+        // A map node holds the pair, and a few pointers to the others.
+        size += g.remap.size() * (sizeof(EntityMap::value_type) + 4 * sizeof(void *));
+    }
+    return size;
+}
+
+size_t SolveSpaceUI::UndoMemoryUsage() {
+    size_t size = 0;
+    for(UndoStack *uk : { &undo, &redo }) {
+        if(uk->cnt == 0) continue;
+        size += UndoStateMemoryUsage(&uk->top);
+        for(int i = 1; i < uk->cnt; i++) {
+            UndoDelta *ud = &(uk->d[WRAP(uk->write - i, MAX_UNDO)]);
+            size += UndoStateMemoryUsage(&ud->changed) +
+                    ud->removedGroup.size() * sizeof(hGroup) +
+                    ud->removedRequest.size() * sizeof(hRequest) +
+                    ud->removedConstraint.size() * sizeof(hConstraint) +
+                    ud->removedParam.size() * sizeof(hParam) +
+                    ud->removedStyle.size() * sizeof(hStyle);
+        }
+    }
+    return size;
 }
 
 } // namespace SolveSpace
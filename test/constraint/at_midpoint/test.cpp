@@ -4,6 +4,7 @@ TEST_CASE(line_pt_normal_roundtrip) {
     CHECK_LOAD("line_pt_normal.slvs");
     CHECK_RENDER("line_pt_normal.png");
     CHECK_SAVE("line_pt_normal.slvs");
+    CHECK_SAVE_BINARY("line_pt_normal.slvs");
 }
 
 TEST_CASE(line_pt_normal_migrate_from_v20) {
@@ -20,6 +21,7 @@ TEST_CASE(line_pt_free_in_3d_roundtrip) {
     CHECK_LOAD("line_pt_free_in_3d.slvs");
     CHECK_RENDER("line_pt_free_in_3d.png");
     CHECK_SAVE("line_pt_free_in_3d.slvs");
+    CHECK_SAVE_BINARY("line_pt_free_in_3d.slvs");
 }
 
 TEST_CASE(line_pt_free_in_3d_migrate_from_v20) {
@@ -36,6 +38,7 @@ TEST_CASE(line_plane_normal_roundtrip) {
     CHECK_LOAD("line_plane_normal.slvs");
     CHECK_RENDER("line_plane_normal.png");
     CHECK_SAVE("line_plane_normal.slvs");
+    CHECK_SAVE_BINARY("line_plane_normal.slvs");
 }
 
 TEST_CASE(line_plane_normal_migrate_from_v20) {
@@ -52,6 +55,7 @@ TEST_CASE(line_plane_free_in_3d_roundtrip) {
     CHECK_LOAD("line_plane_free_in_3d.slvs");
     CHECK_RENDER("line_plane_free_in_3d.png");
     CHECK_SAVE("line_plane_free_in_3d.slvs");
+    CHECK_SAVE_BINARY("line_plane_free_in_3d.slvs");
 }
 
 TEST_CASE(line_plane_free_in_3d_migrate_from_v20) {
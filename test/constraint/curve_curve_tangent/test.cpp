@@ -4,6 +4,7 @@ TEST_CASE(arc_arc_roundtrip) {
     CHECK_LOAD("arc_arc.slvs");
     CHECK_RENDER("arc_arc.png");
     CHECK_SAVE("arc_arc.slvs");
+    CHECK_SAVE_BINARY("arc_arc.slvs");
 }
 
 TEST_CASE(arc_arc_migrate_from_v20) {
@@ -20,6 +21,7 @@ TEST_CASE(arc_cubic_roundtrip) {
     CHECK_LOAD("arc_cubic.slvs");
     CHECK_RENDER("arc_cubic.png");
     CHECK_SAVE("arc_cubic.slvs");
+    CHECK_SAVE_BINARY("arc_cubic.slvs");
 }
 
 TEST_CASE(arc_cubic_migrate_from_v20) {
@@ -4,6 +4,7 @@ TEST_CASE(normal_roundtrip) {
     CHECK_LOAD("normal.slvs");
     CHECK_RENDER("normal.png");
     CHECK_SAVE("normal.slvs");
+    CHECK_SAVE_BINARY("normal.slvs");
 }
 
 TEST_CASE(normal_migrate_from_v20) {
@@ -20,6 +21,7 @@ TEST_CASE(other_roundtrip) {
     CHECK_LOAD("other.slvs");
     CHECK_RENDER("other.png");
     CHECK_SAVE("other.slvs");
+    CHECK_SAVE_BINARY("other.slvs");
 }
 
 TEST_CASE(other_migrate_from_v20) {
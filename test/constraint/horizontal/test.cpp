@@ -4,6 +4,7 @@ TEST_CASE(line_roundtrip) {
     CHECK_LOAD("line.slvs");
     CHECK_RENDER("line.png");
     CHECK_SAVE("line.slvs");
+    CHECK_SAVE_BINARY("line.slvs");
 }
 
 TEST_CASE(line_migrate_from_v20) {
@@ -20,6 +21,7 @@ TEST_CASE(pt_pt_roundtrip) {
     CHECK_LOAD("pt_pt.slvs");
     CHECK_RENDER("pt_pt.png");
     CHECK_SAVE("pt_pt.slvs");
+    CHECK_SAVE_BINARY("pt_pt.slvs");
 }
 
 TEST_CASE(pt_pt_migrate_from_v20) {
@@ -4,6 +4,7 @@ TEST_CASE(normal_roundtrip) {
     CHECK_LOAD("normal.slvs");
     CHECK_RENDER("normal.png");
     CHECK_SAVE("normal.slvs");
+    CHECK_SAVE_BINARY("normal.slvs");
 }
 
 TEST_CASE(normal_migrate_from_v22) {
@@ -15,6 +16,7 @@ TEST_CASE(reference_roundtrip) {
     CHECK_LOAD("reference.slvs");
     CHECK_RENDER("reference.png");
     CHECK_SAVE("reference.slvs");
+    CHECK_SAVE_BINARY("reference.slvs");
 }
 
 TEST_CASE(reference_migrate_from_v22) {
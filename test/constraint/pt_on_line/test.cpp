@@ -4,6 +4,7 @@ TEST_CASE(normal_roundtrip) {
     CHECK_LOAD("normal.slvs");
     CHECK_RENDER("normal.png");
     CHECK_SAVE("normal.slvs");
+    CHECK_SAVE_BINARY("normal.slvs");
 }
 
 TEST_CASE(normal_migrate_from_v20) {
@@ -20,12 +21,14 @@ TEST_CASE(left_free_in_3d_roundtrip) {
     CHECK_LOAD("left_free_in_3d.slvs");
     CHECK_RENDER("left_free_in_3d.png");
     CHECK_SAVE("left_free_in_3d.slvs");
+    CHECK_SAVE_BINARY("left_free_in_3d.slvs");
 }
 
 TEST_CASE(right_free_in_3d_roundtrip) {
     CHECK_LOAD("right_free_in_3d.slvs");
     CHECK_RENDER("right_free_in_3d.png");
     CHECK_SAVE("right_free_in_3d.slvs");
+    CHECK_SAVE_BINARY("right_free_in_3d.slvs");
 }
 
 TEST_CASE(free_in_3d_migrate_from_v20) {
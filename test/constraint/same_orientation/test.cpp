@@ -4,6 +4,7 @@ TEST_CASE(normal_roundtrip) {
     CHECK_LOAD("normal.slvs");
     CHECK_RENDER("normal.png");
     CHECK_SAVE("normal.slvs");
+    CHECK_SAVE_BINARY("normal.slvs");
 }
 
 TEST_CASE(normal_migrate_from_v20) {
@@ -20,4 +21,5 @@ TEST_CASE(same_group_roundtrip) {
     CHECK_LOAD("same_group.slvs");
     CHECK_RENDER("same_group.png");
     CHECK_SAVE("same_group.slvs");
+    CHECK_SAVE_BINARY("same_group.slvs");
 }
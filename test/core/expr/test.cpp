@@ -94,6 +94,48 @@ TEST_CASE(precedence) {
   CHECK_TRUE(e->Eval() == 1);
 }
 
+TEST_CASE(tape) {
+  Param pa = {}, pb = {};
+  pa.h   = hParam { 1 };
+  pa.val = 3;
+  pb.h   = hParam { 2 };
+  pb.val = -0.5;
+  Expr *a = Expr::From(pa.h);
+  a->op   = Expr::Op::PARAM_PTR;
+  a->parp = &pa;
+  Expr *b = Expr::From(pb.h);
+  b->op   = Expr::Op::PARAM_PTR;
+  b->parp = &pb;
+
+  // f = a*a*sin(b) + sqrt(square(a) + square(b)) - acos(b/(a + 5))
+  Expr *f = a->Times(a)->Times(b->Sin())
+             ->Plus(a->Square()->Plus(b->Square())->Sqrt())
+             ->Minus(b->Div(a->Plus(Expr::From(5.0)))->ACos());
+  Expr *g = a->Negate()->Times(b->Cos())->Plus(b->ASin()->Negate());
+  std::vector<Expr *> exprs = {
+    f, f->PartialWrt(pa.h), f->PartialWrt(pb.h),
+    g, g->PartialWrt(pa.h), g->PartialWrt(pb.h),
+  };
+
+  ExprTape tape;
+  std::vector<uint32_t> slots;
+  int nodes = 0;
+  for(Expr *e : exprs) {
+    slots.push_back(tape.Add(e));
+    nodes += e->Nodes();
+  }
+  // The partials repeat much of f and g, which should be shared.
+  CHECK_TRUE((int)tape.Size() < nodes / 2);
+
+  for(double bv : { -0.5, 0.25, 0.75 }) {
+    pb.val = bv;
+    tape.Eval();
+    for(size_t i = 0; i < exprs.size(); i++) {
+      CHECK_EQ_EPS(tape.Value(slots[i]), exprs[i]->Eval());
+    }
+  }
+}
+
 TEST_CASE(errors) {
   CHECK_PARSE_ERR("\x01",
                   "Unexpected character");
@@ -112,3 +154,33 @@ TEST_CASE(errors) {
   CHECK_PARSE_ERR("(",
                   "Expected ')'");
 }
+
+TEST_CASE(arena) {
+  ExprArena arena;
+  Expr *outside = Expr::From(1.0);
+  {
+    ExprArena::Scope scope(&arena);
+    CHECK_TRUE(ExprArena::Current() == &arena);
+    Expr *e = Expr::From(2.0)->Plus(Expr::From(3.0));
+    CHECK_TRUE(e->Eval() == 5.0);
+    CHECK_TRUE(arena.GetStats().bytesUsed == 3 * sizeof(Expr));
+    for(int i = 0; i < 10000; i++) {
+      e = e->Plus(Expr::From(1.0));
+    }
+    CHECK_TRUE(e->Eval() == 10005.0);
+
+    size_t reserved = arena.GetStats().bytesReserved;
+    arena.Reset();
+    CHECK_TRUE(arena.GetStats().bytesUsed == 0);
+    CHECK_TRUE(arena.GetStats().bytesReserved == reserved);
+    // Common constants like 1.0 are statically allocated.
+    CHECK_TRUE(arena.GetStats().peakBytesUsed == 10003 * sizeof(Expr));
+    // The blocks are reused after a reset.
+    Expr::From(4.0);
+    CHECK_TRUE(arena.GetStats().bytesReserved == reserved);
+  }
+  CHECK_TRUE(ExprArena::Current() == NULL);
+  CHECK_TRUE(outside->Eval() == 1.0);
+  arena.Release();
+  CHECK_TRUE(arena.GetStats().bytesReserved == 0);
+}
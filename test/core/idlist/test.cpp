@@ -0,0 +1,51 @@
+#include "solvespace.h"
+
+#include "harness.h"
+
+// Add params with the given handles, and check that the list iterates them
+// in order of their handles, whichever way it is indexed.
+template<IdIndex Index>
+static void CheckAddFindRemove(Test::Helper *helper) {
+  IdList<Param, hParam, Index> list;
+  for(uint32_t h : { 5, 1, 9, 3, 7, 10, 2 }) {
+    Param p = {};
+    p.h.v = h;
+    p.val = h * 2.0;
+    list.Add(&p);
+  }
+  CHECK_TRUE(list.n == 7);
+  CHECK_TRUE(list.MaximumId() == 10);
+
+  uint32_t prev = 0;
+  for(Param &p : list) {
+    CHECK_TRUE(p.h.v > prev);
+    prev = p.h.v;
+  }
+  CHECK_TRUE(list.FindById(hParam { 7 })->val == 14.0);
+  CHECK_TRUE(list.FindByIdNoOops(hParam { 4 }) == nullptr);
+
+  list.FindById(hParam { 3 })->tag = 1;
+  list.RemoveById(hParam { 9 });
+  CHECK_TRUE(list.n == 6);
+  CHECK_TRUE(list.FindByIdNoOops(hParam { 9 }) == nullptr);
+  // Removing one element leaves the tags of the others alone.
+  list.RemoveTagged();
+  CHECK_TRUE(list.n == 5);
+  CHECK_TRUE(list.FindByIdNoOops(hParam { 3 }) == nullptr);
+
+  // The freed slots are reused.
+  Param p = {};
+  p.h.v = 4;
+  list.Add(&p);
+  CHECK_TRUE(list.FindById(hParam { 4 })->h.v == 4);
+  CHECK_TRUE(list[2].h.v == 4);
+  CHECK_TRUE(list.FindById(hParam { 10 })->val == 20.0);
+}
+
+TEST_CASE(sorted) {
+  CheckAddFindRemove<IdIndex::SORTED>(helper);
+}
+
+TEST_CASE(hashed) {
+  CheckAddFindRemove<IdIndex::HASHED>(helper);
+}
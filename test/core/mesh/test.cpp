@@ -0,0 +1,89 @@
+#include "solvespace.h"
+
+#include "harness.h"
+
+// A closed tetrahedron, with each of its triangles wound outwards; nudge moves
+// the copies of its last vertex apart, by less than the welding tolerance.
+static void MakeTetrahedron(SMesh *m, double nudge) {
+  Vector p[4] = {
+    Vector::From(0, 0, 0), Vector::From(1, 0, 0),
+    Vector::From(0, 1, 0), Vector::From(0, 0, 1),
+  };
+  Vector q[3] = {
+    p[3].Plus(Vector::From(nudge, 0, 0)),
+    p[3].Plus(Vector::From(0, nudge, 0)),
+    p[3].Plus(Vector::From(0, 0, nudge)),
+  };
+  STriMeta meta = {};
+  m->AddTriangle(meta, p[0], p[2], p[1]);
+  m->AddTriangle(meta, p[0], p[1], q[0]);
+  m->AddTriangle(meta, p[1], p[2], q[1]);
+  m->AddTriangle(meta, p[2], p[0], q[2]);
+}
+
+static void BuildFrom(SMeshAdjacency *adj, SMesh *m) {
+  std::vector<STriangle *> tris;
+  for(STriangle &tr : m->l) {
+    tris.push_back(&tr);
+  }
+  adj->Build(tris);
+}
+
+TEST_CASE(closed) {
+  SMesh m = {};
+  MakeTetrahedron(&m, LENGTH_EPS / 2);
+  SMeshAdjacency adj;
+  BuildFrom(&adj, &m);
+
+  for(uint32_t h = 0; h < 12; h++) {
+    CHECK_TRUE(adj.CountMates(h) == 1);
+    CHECK_TRUE(adj.CountParallel(h) == 1);
+    // The mate runs the other way between the same two vertices.
+    uint32_t g = adj.FirstMate(h);
+    CHECK_TRUE(adj.FirstMate(g) == h);
+    CHECK_TRUE(adj.vertex[g] == adj.vertex[h - h % 3 + (h + 1) % 3]);
+  }
+  m.Clear();
+}
+
+TEST_CASE(naked) {
+  SMesh m = {};
+  MakeTetrahedron(&m, 0);
+  m.l.RemoveLast(1);
+  SMeshAdjacency adj;
+  BuildFrom(&adj, &m);
+
+  int naked = 0;
+  for(uint32_t h = 0; h < 9; h++) {
+    if(adj.CountMates(h) == 0) naked++;
+  }
+  CHECK_TRUE(naked == 3);
+
+  SKdNode *root = SKdNode::From(&m);
+  SEdgeList el = {};
+  bool inter, leaky;
+  root->MakeCertainEdgesInto(adj, &el, EdgeKind::NAKED_OR_SELF_INTER,
+                             /*coplanarIsInter=*/true, &inter, &leaky);
+  CHECK_TRUE(el.l.n == 3);
+  CHECK_TRUE(leaky);
+  CHECK_FALSE(inter);
+  el.Clear();
+  m.Clear();
+}
+
+TEST_CASE(welded) {
+  SMesh m = {};
+  MakeTetrahedron(&m, LENGTH_EPS / 2);
+  SWeldedMesh wm = {};
+  wm.MakeFromMesh(&m);
+
+  CHECK_TRUE(wm.triangles.size() == 4);
+  CHECK_TRUE(wm.vertices.size() == 4);
+  // Each face is flat, so its three corners share its normal.
+  CHECK_TRUE(wm.normals.size() == 4);
+  for(const SWeldedMesh::Triangle &t : wm.triangles) {
+    CHECK_TRUE(t.normal[0] == t.normal[1] && t.normal[1] == t.normal[2]);
+  }
+  CHECK_TRUE(fabs(m.CalculateVolume() - 1.0 / 6) < LENGTH_EPS);
+  m.Clear();
+}
@@ -0,0 +1,143 @@
+#include "solvespace.h"
+
+#include "harness.h"
+
+// normal.slvs is an extrusion with a second one cut out of it, so its last
+// group has a shell made by a Boolean.
+
+static SShell *LastShell() {
+    return &SK.GetGroup(*SK.groupOrder.Last())->runningShell;
+}
+
+// Whether any group generated a shell or mesh of its own, rather than all of
+// the geometry being the one loaded with the file.
+static bool AnyGroupGenerated() {
+    for(Group &g : SK.group) {
+        if(!g.thisShell.IsEmpty() || !g.thisMesh.IsEmpty()) return true;
+    }
+    return false;
+}
+
+// Load a file the way that the GUI does, and tell whether it kept the
+// geometry saved with it.
+static bool LoadUsesSavedGeometry(const Platform::Path &path) {
+    if(!SS.LoadFromFile(path)) return false;
+    SS.AfterNewFile();
+    return SS.useSavedGeometry && !AnyGroupGenerated();
+}
+
+TEST_CASE(unchanged_uses_saved) {
+    CHECK_LOAD("normal.slvs");
+    int surfaces = LastShell()->surface.n;
+    CHECK_TRUE(surfaces > 0);
+    CHECK_FALSE(SS.useSavedGeometry);
+
+    Platform::Path path = helper->GetAssetPath(__FILE__, "normal.slvs", "warm");
+    bool saved = SS.SaveToFile(path);
+    bool warm = saved && LoadUsesSavedGeometry(path);
+    RemoveFile(path);
+    CHECK_TRUE(saved);
+    CHECK_TRUE(warm);
+    CHECK_TRUE(LastShell()->surface.n == surfaces);
+
+    // Anything that needs the shells of the other groups generates them all.
+    SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+    CHECK_FALSE(SS.useSavedGeometry);
+    CHECK_TRUE(AnyGroupGenerated());
+    CHECK_TRUE(LastShell()->surface.n == surfaces);
+}
+
+TEST_CASE(changed_param_regenerates) {
+    CHECK_LOAD("normal.slvs");
+    Platform::Path path = helper->GetAssetPath(__FILE__, "normal.slvs", "warm");
+    bool saved = SS.SaveToFile(path);
+
+    // Move the last param of the sketch a little, behind the hash's back.
+    std::string data;
+    bool edited = saved && ReadFile(path, &data);
+    size_t at = data.rfind("\nParam.val=");
+    edited = edited && at != std::string::npos;
+    if(edited) {
+        at += strlen("\nParam.val=");
+        size_t end = data.find('\n', at);
+        double val = strtod(data.substr(at, end - at).c_str(), NULL);
+        data.replace(at, end - at, ssprintf("%.20f", val + 1.0));
+        edited = WriteFile(path, data);
+    }
+    bool warm = edited && LoadUsesSavedGeometry(path);
+    RemoveFile(path);
+    CHECK_TRUE(saved);
+    CHECK_TRUE(edited);
+    CHECK_FALSE(warm);
+    CHECK_FALSE(SS.useSavedGeometry);
+    CHECK_TRUE(AnyGroupGenerated());
+    CHECK_TRUE(LastShell()->surface.n > 0);
+}
+
+TEST_CASE(changed_chord_tolerance_regenerates) {
+    CHECK_LOAD("normal.slvs");
+    Platform::Path path = helper->GetAssetPath(__FILE__, "normal.slvs", "warm");
+    bool saved = SS.SaveToFile(path);
+
+    double chordTol = SS.chordTol;
+    SS.chordTol = chordTol * 2.0;
+    bool warm = saved && LoadUsesSavedGeometry(path);
+    SS.chordTol = chordTol;
+    RemoveFile(path);
+    CHECK_TRUE(saved);
+    CHECK_FALSE(warm);
+    CHECK_FALSE(SS.useSavedGeometry);
+    CHECK_TRUE(AnyGroupGenerated());
+}
+
+TEST_CASE(damaged_geometry_regenerates) {
+    CHECK_LOAD("normal.slvs");
+    int surfaces = LastShell()->surface.n;
+    Platform::Path path = helper->GetAssetPath(__FILE__, "normal.slvs", "warm");
+    bool saved = SS.SaveToFile(path);
+
+    // Cut the file off in the middle of the shell.
+    std::string data;
+    bool edited = saved && ReadFile(path, &data);
+    size_t at = data.rfind("\nSCtrl ");
+    edited = edited && at != std::string::npos;
+    if(edited) {
+        data.resize(at + strlen("\nSCtrl 1"));
+        edited = WriteFile(path, data);
+    }
+    bool warm = edited && LoadUsesSavedGeometry(path);
+    RemoveFile(path);
+    CHECK_TRUE(saved);
+    CHECK_TRUE(edited);
+    CHECK_FALSE(warm);
+    CHECK_TRUE(AnyGroupGenerated());
+    CHECK_TRUE(LastShell()->surface.n == surfaces);
+}
+
+TEST_CASE(bad_binary_degree_regenerates) {
+    CHECK_LOAD("normal.slvs");
+    int surfaces = LastShell()->surface.n;
+    Platform::Path path = helper->GetAssetPath(__FILE__, "normal.slvs", "warm");
+    SS.saveBinaryFiles = true;
+    bool saved = SS.SaveToFile(path);
+    SS.saveBinaryFiles = false;
+
+    // Give the first surface of the shell a degree of zero; its tag and
+    // length are followed by the count of surfaces, and then its handle,
+    // color and face.
+    std::string data;
+    bool edited = saved && ReadFile(path, &data);
+    size_t at = data.rfind("SHEL");
+    edited = edited && at != std::string::npos;
+    if(edited) {
+        data.replace(at + 4 + 8 + 4 * 4, 4, std::string(4, '\0'));
+        edited = WriteFile(path, data);
+    }
+    bool warm = edited && LoadUsesSavedGeometry(path);
+    RemoveFile(path);
+    CHECK_TRUE(saved);
+    CHECK_TRUE(edited);
+    CHECK_FALSE(warm);
+    CHECK_TRUE(AnyGroupGenerated());
+    CHECK_TRUE(LastShell()->surface.n == surfaces);
+}
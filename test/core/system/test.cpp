@@ -0,0 +1,81 @@
+#include "solvespace.h"
+
+#include "harness.h"
+
+// A chain of points, each a unit distance from the next and 0.6 to its right;
+// that's one cluster of 2*(points-1) coupled equations in 2*points unknowns,
+// so two degrees of freedom. The extra equation, if any, fixes the last step
+// to the right a second time, give or take skew times the height of the first
+// point; that takes away one of them, unless skew is zero.
+static void WriteChain(System *sys, int points, bool extra, double skew) {
+    for(int i = 0; i < points; i++) {
+        Param px = {}, py = {};
+        px.h.v  = 2 * i + 1;
+        px.val  = 0.55 * i;
+        py.h.v  = 2 * i + 2;
+        py.val  = 0.85 * i;
+        sys->param.Add(&px);
+        sys->param.Add(&py);
+    }
+    Expr *dx = NULL;
+    for(int i = 0; i + 1 < points; i++) {
+        dx = Expr::From(hParam { (uint32_t)(2 * i + 3) })
+                 ->Minus(Expr::From(hParam { (uint32_t)(2 * i + 1) }));
+        Expr *dy = Expr::From(hParam { (uint32_t)(2 * i + 4) })
+                       ->Minus(Expr::From(hParam { (uint32_t)(2 * i + 2) }));
+        Equation e = {};
+        e.h.v = 2 * i + 1;
+        e.e   = dx->Square()->Plus(dy->Square())->Minus(Expr::From(1.0));
+        sys->eq.Add(&e);
+        e.h.v = 2 * i + 2;
+        e.e   = dx->Minus(Expr::From(0.6));
+        sys->eq.Add(&e);
+    }
+    if(extra) {
+        Equation e = {};
+        e.h.v = 2 * points + 1;
+        Expr *y0 = Expr::From(hParam { 2 });
+        e.e   = dx->Plus(y0->Times(Expr::From(skew)))->Minus(Expr::From(0.6));
+        sys->eq.Add(&e);
+    }
+}
+
+// The rank test of a chain just under and just over the size where the solver
+// switches from a QR to a Cholesky factorization; the verdict mustn't change.
+static void TestChainRank(bool extra, double skew, bool *rankOk, int *dof) {
+    int points[] = { System::MAX_DIRECT_UNKNOWNS / 2 - 24,
+                     System::MAX_DIRECT_UNKNOWNS / 2 + 24 };
+    for(int i = 0; i < 2; i++) {
+        System sys;
+        WriteChain(&sys, points[i], extra, skew);
+        sys.WriteJacobian(0);
+        rankOk[i] = sys.TestRank(&dof[i]);
+        sys.Clear();
+    }
+}
+
+TEST_CASE(rank_independent) {
+    bool rankOk[2];
+    int dof[2];
+    TestChainRank(/*extra=*/false, 0.0, rankOk, dof);
+    CHECK_TRUE(rankOk[0] && rankOk[1]);
+    CHECK_TRUE(dof[0] == 2 && dof[1] == 2);
+}
+
+TEST_CASE(rank_redundant) {
+    bool rankOk[2];
+    int dof[2];
+    TestChainRank(/*extra=*/true, 0.0, rankOk, dof);
+    CHECK_TRUE(!rankOk[0] && !rankOk[1]);
+    CHECK_TRUE(dof[0] == 2 && dof[1] == 2);
+}
+
+TEST_CASE(rank_nearly_redundant) {
+    // Independent by about 1e-9, which a QR of the Jacobian resolves easily;
+    // squared, that's well under what the pivots of A*A^T can.
+    bool rankOk[2];
+    int dof[2];
+    TestChainRank(/*extra=*/true, 1e-7, rankOk, dof);
+    CHECK_TRUE(rankOk[0] && rankOk[1]);
+    CHECK_TRUE(dof[0] == 1 && dof[1] == 1);
+}
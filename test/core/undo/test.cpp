@@ -0,0 +1,193 @@
+#include "solvespace.h"
+
+#include "harness.h"
+
+// normal.slvs is a sketch, extruded, with a second sketch on its face that's
+// extruded and cut out of it.
+
+// The whole sketch as it would be saved, to compare one state with another.
+static std::string SavedSketch(Test::Helper *helper) {
+    Platform::Path path = helper->GetAssetPath(__FILE__, "normal.slvs", "undo");
+    std::string data;
+    if(!SS.SaveToFile(path) || !ReadFile(path, &data)) data.clear();
+    RemoveFile(path);
+    return data;
+}
+
+static Group *LastGroup() {
+    return SK.GetGroup(*SK.groupOrder.Last());
+}
+
+static Group *LastSketchGroup() {
+    Group *sketch = NULL;
+    for(hGroup hg : SK.groupOrder) {
+        Group *g = SK.GetGroup(hg);
+        if(g->type == Group::Type::DRAWING_WORKPLANE) sketch = g;
+    }
+    return sketch;
+}
+
+static Constraint *FirstDimension() {
+    for(Constraint &c : SK.constraint) {
+        if(c.type == Constraint::Type::PT_PT_DISTANCE) return &c;
+    }
+    return NULL;
+}
+
+TEST_CASE(group_removed) {
+    CHECK_LOAD("normal.slvs");
+    std::string before = SavedSketch(helper);
+
+    SS.UndoRemember();
+    hGroup hg = LastGroup()->h;
+    if(hg == SS.GW.activeGroup) {
+        SS.GW.activeGroup = LastGroup()->PreviousGroup()->h;
+    }
+    SK.group.RemoveById(hg);
+    SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+    SS.GW.ClearSuper();
+    std::string after = SavedSketch(helper);
+    CHECK_FALSE(after == before);
+
+    SS.UndoUndo();
+    CHECK_TRUE(SavedSketch(helper) == before);
+    SS.UndoRedo();
+    CHECK_TRUE(SavedSketch(helper) == after);
+    SS.UndoUndo();
+    CHECK_TRUE(SavedSketch(helper) == before);
+}
+
+TEST_CASE(request_constraint_style_added) {
+    CHECK_LOAD("normal.slvs");
+    Group *sketch = LastSketchGroup();
+    CHECK_TRUE(sketch != NULL);
+    SS.GW.activeGroup = sketch->h;
+    sketch->Activate();
+    SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+    std::string before = SavedSketch(helper);
+
+    // A line, with its points and their params, and a constraint on it.
+    SS.UndoRemember();
+    hRequest hr = SS.GW.AddRequest(Request::Type::LINE_SEGMENT, /*rememberForUndo=*/false);
+    SK.GetEntity(hr.entity(1))->PointForceTo(Vector::From(1, 2, 0));
+    SK.GetEntity(hr.entity(2))->PointForceTo(Vector::From(3, 2.5, 0));
+    Constraint::Constrain(Constraint::Type::HORIZONTAL,
+                          Entity::NO_ENTITY, Entity::NO_ENTITY, hr.entity(0));
+    Style::CreateCustomStyle(/*rememberForUndo=*/false);
+    SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+    std::string after = SavedSketch(helper);
+    CHECK_FALSE(after == before);
+
+    SS.UndoUndo();
+    CHECK_TRUE(SavedSketch(helper) == before);
+    SS.UndoRedo();
+    CHECK_TRUE(SavedSketch(helper) == after);
+}
+
+TEST_CASE(items_modified) {
+    CHECK_LOAD("normal.slvs");
+    hStyle hs = { Style::CreateCustomStyle(/*rememberForUndo=*/false) };
+    std::string before = SavedSketch(helper);
+
+    SS.UndoRemember();
+    LastGroup()->name = "renamed";
+    LastGroup()->color = RgbaColor::From(10, 20, 30);
+    Constraint *c = FirstDimension();
+    CHECK_TRUE(c != NULL);
+    c->valA *= 0.9;
+    c->disp.offset = c->disp.offset.Plus(Vector::From(1, 1, 0));
+    Style::Get(hs)->width = 3.5;
+    for(Request &r : SK.request) {
+        if(r.group != LastSketchGroup()->h) continue;
+        SK.GetParam(r.h.param(0))->val += 0.01;
+        break;
+    }
+    SS.MarkGroupDirty(c->group);
+    SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+    std::string after = SavedSketch(helper);
+    CHECK_FALSE(after == before);
+
+    SS.UndoUndo();
+    CHECK_TRUE(SavedSketch(helper) == before);
+    SS.UndoRedo();
+    CHECK_TRUE(SavedSketch(helper) == after);
+}
+
+TEST_CASE(items_removed) {
+    CHECK_LOAD("normal.slvs");
+    hStyle hs = { Style::CreateCustomStyle(/*rememberForUndo=*/false) };
+    std::string before = SavedSketch(helper);
+
+    // The request takes its params and the constraints on it with it.
+    SS.UndoRemember();
+    SK.style.RemoveById(hs);
+    SK.constraint.RemoveById(FirstDimension()->h);
+    Group *sketch = LastSketchGroup();
+    for(Request &r : SK.request) {
+        if(r.group != sketch->h) continue;
+        SK.request.RemoveById(r.h);
+        break;
+    }
+    SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+    std::string after = SavedSketch(helper);
+    CHECK_FALSE(after == before);
+
+    SS.UndoUndo();
+    CHECK_TRUE(SavedSketch(helper) == before);
+    SS.UndoRedo();
+    CHECK_TRUE(SavedSketch(helper) == after);
+}
+
+TEST_CASE(oldest_forgotten) {
+    CHECK_LOAD("normal.slvs");
+    const int MAX_UNDO = SolveSpaceUI::MAX_UNDO;
+    const int edits = MAX_UNDO + 5;
+    std::string oldest, newest;
+    for(int i = 0; i < edits; i++) {
+        if(i == edits - MAX_UNDO) oldest = SavedSketch(helper);
+        SS.UndoRemember();
+        LastGroup()->name = ssprintf("step%d", i);
+    }
+    newest = SavedSketch(helper);
+    CHECK_TRUE(SS.undo.cnt == MAX_UNDO);
+
+    // Each undo goes back one edit, as far as the stack reaches, and no
+    // further.
+    for(int i = edits - 1; i >= edits - MAX_UNDO; i--) {
+        CHECK_TRUE(LastGroup()->name == ssprintf("step%d", i));
+        SS.UndoUndo();
+    }
+    CHECK_TRUE(SS.undo.cnt == 0);
+    CHECK_TRUE(SavedSketch(helper) == oldest);
+    SS.UndoUndo();
+    CHECK_TRUE(SavedSketch(helper) == oldest);
+
+    for(int i = edits - MAX_UNDO; i < edits; i++) {
+        SS.UndoRedo();
+        CHECK_TRUE(LastGroup()->name == ssprintf("step%d", i));
+    }
+    CHECK_TRUE(SS.redo.cnt == 0);
+    CHECK_TRUE(SavedSketch(helper) == newest);
+}
+
+TEST_CASE(redo_cleared_by_edit) {
+    CHECK_LOAD("normal.slvs");
+    std::string before = SavedSketch(helper);
+
+    SS.UndoRemember();
+    LastGroup()->name = "first";
+    SS.UndoUndo();
+    CHECK_TRUE(SS.redo.cnt == 1);
+
+    SS.UndoRemember();
+    LastGroup()->name = "second";
+    std::string after = SavedSketch(helper);
+    CHECK_TRUE(SS.redo.cnt == 0);
+    SS.UndoRedo();
+    CHECK_TRUE(SavedSketch(helper) == after);
+
+    SS.UndoUndo();
+    CHECK_TRUE(SavedSketch(helper) == before);
+    SS.UndoRedo();
+    CHECK_TRUE(SavedSketch(helper) == after);
+}
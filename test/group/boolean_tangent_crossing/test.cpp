@@ -22,7 +22,7 @@ TEST_CASE(normal_watertight_volume) {
 
     SEdgeList el = {};
     bool inters, leaks;
-    SKdNode::From(m)->MakeCertainEdgesInto(&el,
+    SKdNode::From(m)->MakeCertainEdgesInto(*g->DisplayMeshAdjacency(), &el,
         EdgeKind::NAKED_OR_SELF_INTER, /*coplanarIsInter=*/true, &inters, &leaks);
     // Free the edge list before checking. CHECK_* returns from the test case on
     // failure, so checking first leaks the list whenever the check that matters
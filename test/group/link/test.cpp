@@ -1,9 +1,12 @@
+#include "solvespace.h"
+
 #include "harness.h"
 
 TEST_CASE(normal_roundtrip) {
     CHECK_LOAD("normal.slvs");
     CHECK_RENDER("normal.png");
     CHECK_SAVE("normal.slvs");
+    CHECK_SAVE_BINARY("normal.slvs");
 }
 
 TEST_CASE(normal_migrate_from_v20) {
@@ -15,3 +18,83 @@ TEST_CASE(normal_migrate_from_v22) {
     CHECK_LOAD("normal_v22.slvs");
     CHECK_SAVE("normal.slvs");
 }
+
+TEST_CASE(link_binary_part) {
+    // Save the linked sketch in the binary encoding, and link that instead;
+    // it must bring in the very same entities.
+    CHECK_LOAD("rect_v20.slvs");
+    Platform::Path binPath = helper->GetAssetPath(__FILE__, "rect_v20.slvs", "bin");
+    SS.saveBinaryFiles = true;
+    bool saved = SS.SaveToFile(binPath);
+    SS.saveBinaryFiles = false;
+
+    bool loaded = saved && SS.LoadFromFile(helper->GetAssetPath(__FILE__, "normal.slvs"));
+    Group *link = NULL;
+    std::shared_ptr<LinkedPart> textPart, binaryPart;
+    if(loaded) {
+        for(Group &g : SK.group) {
+            if(g.type == Group::Type::LINKED) link = &g;
+        }
+    }
+    if(link != NULL) {
+        textPart = link->impPart;
+        link->linkFile = binPath;
+        if(SS.ReloadAllLinked(helper->GetAssetPath(__FILE__, "normal.slvs"))) {
+            binaryPart = link->impPart;
+        }
+    }
+    RemoveFile(binPath);
+    CHECK_TRUE(saved);
+    CHECK_TRUE(loaded);
+    CHECK_TRUE(link != NULL);
+    CHECK_TRUE(textPart != nullptr);
+    CHECK_TRUE(binaryPart != nullptr);
+
+    CHECK_TRUE(binaryPart->entity.n == textPart->entity.n);
+    for(Entity &e : textPart->entity) {
+        Entity *be = binaryPart->entity.FindByIdNoOops(e.h);
+        CHECK_TRUE(be != NULL);
+        CHECK_TRUE(be->type == e.type);
+        CHECK_TRUE(be->actPoint.Equals(e.actPoint));
+        CHECK_TRUE(be->actNormal.Minus(e.actNormal).Magnitude() < LENGTH_EPS);
+        CHECK_EQ_EPS(be->actDistance, e.actDistance);
+    }
+}
+
+TEST_CASE(changed_link_regenerates) {
+    // Link a copy of the linked sketch, so that it can be changed after the
+    // sketch that links it is saved; that must be regenerated then.
+    CHECK_LOAD("normal.slvs");
+    Platform::Path partPath = helper->GetAssetPath(__FILE__, "rect_v20.slvs", "copy"),
+                   path     = helper->GetAssetPath(__FILE__, "normal.slvs", "warm");
+    std::string part;
+    bool copied = ReadFile(helper->GetAssetPath(__FILE__, "rect_v20.slvs"), &part) &&
+                  WriteFile(partPath, part);
+    Group *link = NULL;
+    for(Group &g : SK.group) {
+        if(g.type == Group::Type::LINKED) link = &g;
+    }
+    bool saved = false;
+    if(copied && link != NULL) {
+        link->linkFile = partPath;
+        saved = SS.ReloadAllLinked(path) && SS.SaveToFile(path);
+    }
+
+    bool warm = saved && SS.LoadFromFile(path);
+    if(warm) SS.AfterNewFile();
+    warm = warm && SS.useSavedGeometry;
+
+    // A blank line changes the file, but not what's linked from it.
+    bool changed = saved && WriteFile(partPath, part + "\n");
+    bool cold = changed && SS.LoadFromFile(path);
+    if(cold) SS.AfterNewFile();
+    cold = cold && !SS.useSavedGeometry;
+
+    RemoveFile(path);
+    RemoveFile(partPath);
+    CHECK_TRUE(copied);
+    CHECK_TRUE(link != NULL);
+    CHECK_TRUE(saved);
+    CHECK_TRUE(warm);
+    CHECK_TRUE(cold);
+}
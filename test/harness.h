@@ -33,6 +33,9 @@ public:
                            double value, double reference);
     bool CheckLoad(const char *file, int line, const char *fixture);
     bool CheckSave(const char *file, int line, const char *reference);
+    // Round-trips the sketch through the binary encoding, so it loads the
+    // sketch anew.
+    bool CheckSaveBinary(const char *file, int line, const char *reference);
     bool CheckRender(const char *file, int line, const char *fixture);
     bool CheckRenderXY(const char *file, int line, const char *fixture);
     bool CheckRenderIso(const char *file, int line, const char *fixture);
@@ -72,6 +75,8 @@ using namespace SolveSpace;
     do { if(!helper->CheckLoad(__FILE__, __LINE__, fixture)) return; } while(0)
 #define CHECK_SAVE(fixture) \
     do { if(!helper->CheckSave(__FILE__, __LINE__, fixture)) return; } while(0)
+#define CHECK_SAVE_BINARY(fixture) \
+    do { if(!helper->CheckSaveBinary(__FILE__, __LINE__, fixture)) return; } while(0)
 #define CHECK_RENDER(reference) \
     do { if(!helper->CheckRenderXY(__FILE__, __LINE__, reference)) return; } while(0)
 #define CHECK_RENDER_ISO(reference) \
@@ -6,6 +6,7 @@ TEST_CASE(normal_roundtrip) {
     CHECK_LOAD("normal.slvs");
     CHECK_RENDER("normal.png");
     CHECK_SAVE("normal.slvs");
+    CHECK_SAVE_BINARY("normal.slvs");
 }
 
 TEST_CASE(normal_migrate_from_v20) {
@@ -22,6 +23,7 @@ TEST_CASE(free_in_3d_roundtrip) {
     CHECK_LOAD("free_in_3d.slvs");
     CHECK_RENDER("free_in_3d.png");
     CHECK_SAVE("free_in_3d.slvs");
+    CHECK_SAVE_BINARY("free_in_3d.slvs");
 }
 
 TEST_CASE(free_in_3d_migrate_from_v20) {
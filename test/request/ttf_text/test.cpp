@@ -4,12 +4,14 @@ TEST_CASE(normal_roundtrip) {
     CHECK_LOAD("normal.slvs");
     CHECK_RENDER("normal.png");
     CHECK_SAVE("normal.slvs");
+    CHECK_SAVE_BINARY("normal.slvs");
 }
 
 TEST_CASE(kerning_roundtrip) {
     CHECK_LOAD("kerning.slvs");
     CHECK_RENDER("kerning.png");
     CHECK_SAVE("kerning.slvs");
+    CHECK_SAVE_BINARY("kerning.slvs");
 }
 
 TEST_CASE(normal_migrate_from_v20) {